@@ -18,18 +18,72 @@
 #include "../src/util.h"
 
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+namespace {
+
+// Runs function repeatedly for about a second and returns GB/s, given the
+// number of bytes it processes per run
+template<typename Function>
+double Measure(size_t size, Function function)
+{
+  using Clock = std::chrono::steady_clock;
+
+  size_t runs = 0;
+  const auto start = Clock::now();
+  std::chrono::duration<double> elapsed;
+  do {
+    function();
+    ++runs;
+    elapsed = Clock::now() - start;
+  } while (elapsed.count() < 1);
+
+  return runs * size / elapsed.count() / 1e9;
+}
+
+int Benchmark(int fd)
+{
+  std::string data;
+  char buffer[65536];
+  ssize_t res;
+  while ((res = read(fd, buffer, sizeof(buffer))) > 0) {
+    data.append(buffer, res);
+  }
+
+  std::string str = xsonrpc::util::Base64Encode(data);
+  if (xsonrpc::util::Base64Decode(str) != data) {
+    std::cerr << "Decoded data differs\n";
+    return 1;
+  }
+
+  // Throughput of the binary side in both directions
+  const double encode = Measure(data.size(), [&] {
+      str = xsonrpc::util::Base64Encode(data);
+    });
+  std::string decoded(data.size(), '\0');
+  const double decode = Measure(data.size(), [&] {
+      xsonrpc::util::Base64Decode(str.data(), str.size(), &decoded[0]);
+    });
+
+  std::cout << "encode: " << encode << " GB/s\n"
+            << "decode: " << decode << " GB/s\n";
+  return 0;
+}
+
+} // namespace
+
 int main(int argc, char** argv)
 {
   if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " -e|-d|-v <FILE>\n";
+    std::cerr << "Usage: " << argv[0] << " -e|-d|-v|-b <FILE>\n";
     return 1;
   }
 
@@ -41,7 +95,8 @@ int main(int argc, char** argv)
   const bool verify = flag == 'v';
   const bool encode = verify || flag == 'e';
   const bool decode = flag == 'd';
-  if (!encode && !decode) {
+  const bool benchmark = flag == 'b';
+  if (!encode && !decode && !benchmark) {
     return 1;
   }
 
@@ -50,6 +105,12 @@ int main(int argc, char** argv)
     return 1;
   }
 
+  if (benchmark) {
+    const int status = Benchmark(fd);
+    close(fd);
+    return status;
+  }
+
   const size_t size = encode ? 28671 : 30030;
   std::unique_ptr<char[]> buffer(new char[size]);
 
@@ -15,9 +15,12 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include "xsonrpc/cborformathandler.h"
 #include "xsonrpc/client.h"
+#include "xsonrpc/compactformathandler.h"
 #include "xsonrpc/fault.h"
 #include "xsonrpc/jsonformathandler.h"
+#include "xsonrpc/msgpackformathandler.h"
 #include "xsonrpc/xmlformathandler.h"
 
 #include <cstring>
@@ -71,12 +74,38 @@ void LogCall(xsonrpc::Client& client, std::string method, T&&... args)
 int main(int argc, char** argv)
 {
   std::unique_ptr<xsonrpc::FormatHandler> formatHandler;
+  bool negotiate = false;
   for (int i = 1; i < argc; ++i) {
-    if (strcmp(argv[i], "json") == 0) {
+    if (strcmp(argv[i], "auto") == 0) {
+      std::cout << "Negotiating format\n";
+      negotiate = true;
+      break;
+    }
+    else if (strcmp(argv[i], "json") == 0) {
       std::cout << "Using JSON format\n";
       formatHandler.reset(new xsonrpc::JsonFormatHandler());
       break;
     }
+    else if (strcmp(argv[i], "cbor") == 0) {
+      std::cout << "Using CBOR format\n";
+      formatHandler.reset(new xsonrpc::CborFormatHandler());
+      break;
+    }
+    else if (strcmp(argv[i], "compact") == 0) {
+      std::cout << "Using compact format\n";
+      auto compactFormatHandler = new xsonrpc::CompactFormatHandler();
+      formatHandler.reset(compactFormatHandler);
+      // As the server has it
+      compactFormatHandler->AddSignature(
+        "add", xsonrpc::Value::Type::INTEGER_32,
+        xsonrpc::Value::Type::INTEGER_32, xsonrpc::Value::Type::INTEGER_32);
+      break;
+    }
+    else if (strcmp(argv[i], "msgpack") == 0) {
+      std::cout << "Using MessagePack format\n";
+      formatHandler.reset(new xsonrpc::MsgPackFormatHandler());
+      break;
+    }
   }
   if (!formatHandler) {
     std::cout << "Using XML format\n";
@@ -87,6 +116,14 @@ int main(int argc, char** argv)
     xsonrpc::Client::GlobalInit();
     xsonrpc::Client client("localhost", 8080, *formatHandler);
 
+    xsonrpc::CborFormatHandler cborFormatHandler;
+    xsonrpc::MsgPackFormatHandler msgPackFormatHandler;
+    xsonrpc::JsonFormatHandler jsonFormatHandler;
+    if (negotiate) {
+      client.SetFormatHandlers(
+        {&cborFormatHandler, &msgPackFormatHandler, &jsonFormatHandler});
+    }
+
     LogCall(client, "add", 3, 2);
     LogCall(client, "concat", "Hello, ", "World!");
 
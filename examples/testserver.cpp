@@ -15,7 +15,10 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include "xsonrpc/cborformathandler.h"
+#include "xsonrpc/compactformathandler.h"
 #include "xsonrpc/jsonformathandler.h"
+#include "xsonrpc/msgpackformathandler.h"
 #include "xsonrpc/server.h"
 #include "xsonrpc/xmlformathandler.h"
 #include "xsonrpc/xmlrpcsystemmethods.h"
@@ -72,9 +75,15 @@ void RunServer()
 
   xsonrpc::XmlRpcSystemMethods systemMethods(server.GetDispatcher(), true);
 
+  xsonrpc::CborFormatHandler cborFormatHandler;
+  xsonrpc::CompactFormatHandler compactFormatHandler;
   xsonrpc::JsonFormatHandler jsonFormatHandler;
+  xsonrpc::MsgPackFormatHandler msgPackFormatHandler;
   xsonrpc::XmlFormatHandler xmlFormatHandler;
+  server.RegisterFormatHandler(cborFormatHandler);
+  server.RegisterFormatHandler(compactFormatHandler);
   server.RegisterFormatHandler(jsonFormatHandler);
+  server.RegisterFormatHandler(msgPackFormatHandler);
   server.RegisterFormatHandler(xmlFormatHandler);
 
   auto& dispatcher = server.GetDispatcher();
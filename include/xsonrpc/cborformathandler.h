@@ -0,0 +1,51 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_CBORFORMATHANDLER_H
+#define XSONRPC_CBORFORMATHANDLER_H
+
+#include "formathandler.h"
+
+namespace xsonrpc {
+
+// CBOR (RFC 8949) in the message layout of MessagePack-RPC, see
+// MsgPackFormatHandler. Binary data is a byte string and a date/time is an
+// epoch-based date/time (tag 1), taken to be in UTC. Batches are not
+// supported.
+class CborFormatHandler : public FormatHandler
+{
+public:
+  explicit CborFormatHandler(std::string requestPath = "/RPC2");
+
+  // FormatHandler
+  bool CanHandleRequest(const std::string& path,
+                        const std::string& contentType) override;
+  std::string GetContentType() override;
+  bool UsesId() override;
+  std::unique_ptr<Reader> CreateReader(std::string data) override;
+  std::unique_ptr<RequestParser> CreateRequestParser(
+    const Dispatcher& dispatcher) override;
+  std::unique_ptr<Writer> CreateWriter() override;
+
+private:
+  std::string myRequestPath;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -19,15 +19,63 @@
 #define XSONRPC_CLIENT_H
 
 #include "request.h"
+#include "response.h"
 #include "value.h"
 
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace xsonrpc {
 
+struct Attachment;
+class AttachmentWriter;
 class FormatHandler;
 
+// Calls that are sent in one request, see Client::CallBatch
+class Batch
+{
+public:
+  // Adds a call and returns the index of its response
+  size_t Add(const std::string& methodName,
+             const Request::Parameters& params = {})
+  {
+    return AddInternal(methodName, params);
+  }
+
+  template<typename FirstType,
+           typename... RestTypes>
+  typename std::enable_if<
+    !std::is_same<typename std::decay<FirstType>::type,
+                  Request::Parameters>::value,
+    size_t>::type
+  Add(const std::string& methodName, FirstType&& first, RestTypes&&... rest)
+  {
+    Request::Parameters params;
+    params.emplace_back(std::forward<FirstType>(first));
+
+    return AddInternal(
+      methodName, params, std::forward<RestTypes>(rest)...);
+  }
+
+  const std::vector<Request>& GetRequests() const { return myRequests; }
+
+private:
+  template<typename FirstType, typename... RestTypes>
+  size_t AddInternal(const std::string& methodName,
+                     Request::Parameters& params,
+                     FirstType&& first, RestTypes&&... rest)
+  {
+    params.emplace_back(std::forward<FirstType>(first));
+    return AddInternal(
+      methodName, params, std::forward<RestTypes>(rest)...);
+  }
+  size_t AddInternal(const std::string& methodName,
+                     const Request::Parameters& params);
+
+  std::vector<Request> myRequests;
+};
+
 class Client
 {
 public:
@@ -60,6 +108,52 @@ public:
       methodName, params, std::forward<RestTypes>(rest)...);
   }
 
+  // Calls a method without waiting for a result. Only the HTTP status of
+  // the reply is checked, the body is not parsed.
+  void Notify(const std::string& methodName,
+              const Request::Parameters& params = {})
+  {
+    NotifyInternal(methodName, params);
+  }
+
+  template<typename FirstType,
+           typename... RestTypes>
+  typename std::enable_if<
+    !std::is_same<typename std::decay<FirstType>::type,
+                  Request::Parameters>::value>::type
+  Notify(const std::string& methodName, FirstType&& first,
+         RestTypes&&... rest)
+  {
+    Request::Parameters params;
+    params.emplace_back(std::forward<FirstType>(first));
+
+    NotifyInternal(methodName, params, std::forward<RestTypes>(rest)...);
+  }
+
+  // Sends all calls in the batch in one request. The responses are
+  // returned in the order the calls were added, with faults left to be
+  // thrown by Response::ThrowIfFault. Throws if the batch as a whole fails.
+  std::vector<Response> CallBatch(const Batch& batch);
+
+  // Sends large binary values as attachments of a multipart/related
+  // request, and accepts replies with attachments. Only for servers that
+  // support it, as other servers can't read such requests.
+  void SetAttachments(bool attachments) { myAttachments = attachments; }
+
+  // Lets the client pick the format on its first call, from the format
+  // handlers in order of preference. The client doesn't measure the cost
+  // of the formats, so the cheapest format is the one first in the list,
+  // and it is up to the caller to order them. The first handler whose
+  // content type the server lists in system.getCapabilities, i.e. one
+  // that is registered with the server, is used. The query is sent with the
+  // handler given to the constructor, or with the others in turn if the
+  // server doesn't read it, and the client keeps the handler that the
+  // server read if none is listed. The choice is cached per URL and set of
+  // handlers for the whole process, so other clients of the same server
+  // skip the query. A server without system methods is asked again by
+  // each client.
+  void SetFormatHandlers(std::vector<FormatHandler*> formatHandlers);
+
   Client(const Client&) = delete;
   Client& operator=(const Client&) = delete;
   Client(Client&&) = delete;
@@ -77,9 +171,32 @@ private:
   }
   Value CallInternal(const std::string& methodName,
                      const Request::Parameters& params);
-  FormatHandler& myFormatHandler;
+  template<typename FirstType, typename... RestTypes>
+  void NotifyInternal(const std::string& methodName,
+                      Request::Parameters& params,
+                      FirstType&& first, RestTypes&&... rest)
+  {
+    params.emplace_back(std::forward<FirstType>(first));
+    NotifyInternal(methodName, params, std::forward<RestTypes>(rest)...);
+  }
+  void NotifyInternal(const std::string& methodName,
+                      const Request::Parameters& params);
+  // Negotiates the format first, if SetFormatHandlers was called
+  FormatHandler& GetFormatHandler();
+  void NegotiateFormat(std::vector<FormatHandler*>& formatHandlers);
+  // Posts the request and returns the body of the reply. For a
+  // multipart/related reply, the root part is returned while the
+  // attachments reference the message.
+  std::string Post(AttachmentWriter& writer, std::string& message,
+                   std::vector<Attachment>& attachments);
+
+  FormatHandler* myFormatHandler;
+  // Left to negotiate, see SetFormatHandlers
+  std::vector<FormatHandler*> myFormatHandlers;
+  std::string myUrl;
   void* myHandle;
   int32_t myId;
+  bool myAttachments = false;
 };
 
 } // namespace xsonrpc
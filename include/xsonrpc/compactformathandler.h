@@ -0,0 +1,74 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_COMPACTFORMATHANDLER_H
+#define XSONRPC_COMPACTFORMATHANDLER_H
+
+#include "formathandler.h"
+#include "value.h"
+
+#include <map>
+#include <vector>
+
+namespace xsonrpc {
+
+// A binary format for peers that share the signatures of the methods (see
+// MethodWrapper::AddSignature). The parameters of a call are then written
+// in order without types, with a hash of the signature to detect
+// mismatches. Calls of other methods, and responses, have a type before
+// each value. Batches and attachments are not supported.
+class CompactFormatHandler : public FormatHandler
+{
+public:
+  // Return type followed by the parameter types, as in MethodWrapper
+  typedef std::map<std::string, std::vector<Value::Type>> Signatures;
+
+  explicit CompactFormatHandler(std::string requestPath = "/RPC2");
+
+  // Calls of the method are written by the signature, which must be one
+  // the server has for the method. Replaces any signature added before.
+  // Readers created by the handler also need it to read such calls with
+  // GetRequest, while servers use the signatures of their methods.
+  template<typename... ParameterTypes>
+  CompactFormatHandler& AddSignature(const std::string& methodName,
+                                     Value::Type returnType,
+                                     ParameterTypes... parameterTypes)
+  {
+    mySignatures[methodName] = {returnType, parameterTypes...};
+    return *this;
+  }
+  void RemoveSignature(const std::string& methodName);
+
+  // FormatHandler
+  bool CanHandleRequest(const std::string& path,
+                        const std::string& contentType) override;
+  std::string GetContentType() override;
+  bool UsesId() override;
+  std::unique_ptr<Reader> CreateReader(std::string data) override;
+  std::unique_ptr<RequestParser> CreateRequestParser(
+    const Dispatcher& dispatcher) override;
+  std::unique_ptr<Writer> CreateWriter() override;
+
+private:
+  std::string myRequestPath;
+  Signatures mySignatures;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -19,8 +19,10 @@
 #define XSONRPC_DISPATCHER_H
 
 #include "fault.h"
+#include "parameterdecoder.h"
 #include "request.h"
 #include "response.h"
+#include "structtraits.h"
 #include "value.h"
 
 #if __cplusplus <= 201103L
@@ -32,6 +34,8 @@ using redi::index_sequence_for;
 #endif
 
 #include <functional>
+#include <memory>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -41,6 +45,7 @@ class MethodWrapper
 {
 public:
   typedef std::function<Value(const Request::Parameters&)> Method;
+  typedef std::function<std::unique_ptr<ParameterDecoder>()> DecoderFactory;
 
   explicit MethodWrapper(Method method) : myMethod(method) {}
 
@@ -70,8 +75,20 @@ public:
     return myMethod(params);
   }
 
+  // Methods with typed parameters can have their arguments decoded while
+  // the request is parsed. Returns null if not supported by the method.
+  std::unique_ptr<ParameterDecoder> CreateParameterDecoder() const
+  {
+    return myDecoderFactory ? myDecoderFactory() : nullptr;
+  }
+  void SetDecoderFactory(DecoderFactory factory)
+  {
+    myDecoderFactory = std::move(factory);
+  }
+
 private:
   Method myMethod;
+  DecoderFactory myDecoderFactory;
   bool myIsHidden = false;
   std::string myHelpText;
   std::vector<std::vector<Value::Type>> mySignatures;
@@ -113,11 +130,94 @@ struct StdFunction<MethodType, true>
     decltype(&MethodType::operator())>::Type Type;
 };
 
+template<typename ReturnType, typename... ParameterTypes>
+class MethodParameterDecoder final : public ParameterDecoder
+{
+public:
+  typedef std::function<ReturnType(ParameterTypes...)> Method;
+
+  // Holds a copy of the method, so that the decoder may outlive the
+  // dispatcher's method
+  explicit MethodParameterDecoder(Method method)
+    : MethodParameterDecoder(std::move(method),
+                             std::index_sequence_for<ParameterTypes...>{})
+  {
+  }
+
+  // ParameterDecoder
+  void StartParameter() override
+  {
+    myHandler = myIndex < sizeof...(ParameterTypes)
+      ? myHandlers[myIndex] : &myIgnored;
+  }
+  void EndParameter() override { ++myIndex; }
+  Value Invoke() override
+  {
+    if (myIndex != sizeof...(ParameterTypes)) {
+      throw InvalidParametersFault();
+    }
+    return Invoke(std::index_sequence_for<ParameterTypes...>{});
+  }
+
+  // ValueHandler
+  void StartArray() override { myHandler->StartArray(); }
+  void EndArray() override { myHandler->EndArray(); }
+  void StartStruct() override { myHandler->StartStruct(); }
+  void EndStruct() override { myHandler->EndStruct(); }
+  void StartStructElement(const char* name, size_t size) override
+  {
+    myHandler->StartStructElement(name, size);
+  }
+
+  void Binary(const char* data, size_t size) override
+  {
+    myHandler->Binary(data, size);
+  }
+  void Boolean(bool value) override { myHandler->Boolean(value); }
+  void DateTime(const Value::DateTime& value) override
+  {
+    myHandler->DateTime(value);
+  }
+  void Double(double value) override { myHandler->Double(value); }
+  void Integer32(int32_t value) override { myHandler->Integer32(value); }
+  void Integer64(int64_t value) override { myHandler->Integer64(value); }
+  void Nil() override { myHandler->Nil(); }
+  void String(const char* data, size_t size) override
+  {
+    myHandler->String(data, size);
+  }
+
+private:
+  template<std::size_t... index>
+  MethodParameterDecoder(Method method, std::index_sequence<index...>)
+    : myMethod(std::move(method)),
+      myHandlers{&std::get<index>(myDecoders)..., nullptr},
+      myHandler(&myIgnored)
+  {
+  }
+
+  template<std::size_t... index>
+  Value Invoke(std::index_sequence<index...>)
+  {
+    return ToValue(myMethod(std::get<index>(myDecoders).Get()...));
+  }
+
+  Method myMethod;
+  std::tuple<ArgumentDecoder<
+    typename std::decay<ParameterTypes>::type>...> myDecoders;
+  ValueHandler* myHandlers[sizeof...(ParameterTypes) + 1];
+  ValueBuilder myIgnored;
+  ValueHandler* myHandler;
+  size_t myIndex = 0;
+};
+
 class Dispatcher
 {
 public:
   std::vector<std::string> GetMethodNames(bool includeHidden = false) const;
   MethodWrapper& GetMethod(const std::string& name);
+  // Returns null if there is no method with the name
+  const MethodWrapper* FindMethod(const std::string& name) const;
 
   MethodWrapper& AddMethod(
     std::string name, MethodWrapper::Method method);
@@ -186,6 +286,19 @@ public:
                   const Request::Parameters& parameters,
                   const Value& id) const;
 
+  // For decoding the parameters while the request is parsed. Returns null
+  // if the method does not exist or does not support it, in which case
+  // the parameters are to be read as values and passed to Invoke above.
+  std::unique_ptr<ParameterDecoder> CreateParameterDecoder(
+    const std::string& name) const;
+  Response Invoke(ParameterDecoder& decoder, const Value& id) const;
+
+  // Content types of the formats that requests are read in, which
+  // system.getCapabilities lists (see XmlRpcSystemMethods). Added by
+  // Server::RegisterFormatHandler.
+  void AddFormat(std::string contentType);
+  const std::vector<std::string>& GetFormats() const { return myFormats; }
+
 private:
   template<typename ReturnType, typename... ParameterTypes>
   MethodWrapper& AddMethodInternal(
@@ -225,14 +338,22 @@ private:
         if (params.size() != sizeof...(ParameterTypes)) {
           throw InvalidParametersFault();
         }
-        return method(
-          params[index]
-          .AsType<typename std::decay<ParameterTypes>::type>()...);
+        return ToValue(method(
+          ParameterHolder<typename std::decay<ParameterTypes>::type>(
+            params[index])...));
       };
-    return AddMethod(std::move(name), std::move(realMethod));
+    auto& wrapper = AddMethod(std::move(name), std::move(realMethod));
+    wrapper.SetDecoderFactory(
+      [method] ()
+      {
+        return std::unique_ptr<ParameterDecoder>(
+          new MethodParameterDecoder<ReturnType, ParameterTypes...>(method));
+      });
+    return wrapper;
   }
 
   std::map<std::string, MethodWrapper> myMethods;
+  std::vector<std::string> myFormats;
 };
 
 } // namespace xsonrpc
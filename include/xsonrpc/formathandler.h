@@ -23,7 +23,9 @@
 
 namespace xsonrpc {
 
+class Dispatcher;
 class Reader;
+class RequestParser;
 class Writer;
 
 class FormatHandler
@@ -36,6 +38,10 @@ public:
   virtual std::string GetContentType() = 0;
   virtual bool UsesId() = 0;
   virtual std::unique_ptr<Reader> CreateReader(std::string data) = 0;
+  // Returns null if the format cannot parse a request until all of it has
+  // arrived, in which case a reader is used instead
+  virtual std::unique_ptr<RequestParser> CreateRequestParser(
+    const Dispatcher& dispatcher) = 0;
   virtual std::unique_ptr<Writer> CreateWriter() = 0;
 };
 
@@ -22,21 +22,41 @@
 
 namespace xsonrpc {
 
+class JsonAllocatorPool;
+
+// Readers and request parsers created by the handler reuse the memory that
+// they parse into, through a pool that is safe to use from several threads,
+// so a handler can be shared by clients on different threads.
 class JsonFormatHandler : public FormatHandler
 {
 public:
   explicit JsonFormatHandler(std::string requestPath = "/RPC2");
 
+  // JSON has no date/time or binary type, so by default strings that look
+  // like a date/time or contain null characters are read as such. Disable
+  // to always read strings as strings.
+  void SetTypeInference(bool enabled) { myTypeInference = enabled; }
+
+  // Strings are read as they are, whatever their encoding. Enable to
+  // reject requests and responses with strings that aren't valid UTF-8.
+  void SetUtf8Validation(bool enabled) { myValidateUtf8 = enabled; }
+
   // FormatHandler
   bool CanHandleRequest(const std::string& path,
                         const std::string& contentType) override;
   std::string GetContentType() override;
   bool UsesId() override;
   std::unique_ptr<Reader> CreateReader(std::string data) override;
+  std::unique_ptr<RequestParser> CreateRequestParser(
+    const Dispatcher& dispatcher) override;
   std::unique_ptr<Writer> CreateWriter() override;
 
 private:
   std::string myRequestPath;
+  bool myTypeInference = true;
+  bool myValidateUtf8 = false;
+  // Shared with the readers, which may outlive the handler
+  std::shared_ptr<JsonAllocatorPool> myAllocatorPool;
 };
 
 } // namespace xsonrpc
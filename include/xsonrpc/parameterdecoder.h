@@ -0,0 +1,425 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef XSONRPC_PARAMETERDECODER_H
+#define XSONRPC_PARAMETERDECODER_H
+
+#include "fault.h"
+#include "structtraits.h"
+#include "value.h"
+#include "valuehandler.h"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xsonrpc {
+
+inline const std::vector<int32_t>* GetPackedArray(const Value& value,
+                                                  int32_t*)
+{
+  return value.IsInteger32Array() ? &value.AsInteger32Array() : nullptr;
+}
+
+inline const std::vector<int64_t>* GetPackedArray(const Value& value,
+                                                  int64_t*)
+{
+  return value.IsInteger64Array() ? &value.AsInteger64Array() : nullptr;
+}
+
+inline const std::vector<double>* GetPackedArray(const Value& value, double*)
+{
+  return value.IsDoubleArray() ? &value.AsDoubleArray() : nullptr;
+}
+
+template<typename T>
+const std::vector<T>* GetPackedArray(const Value& /*value*/, T*)
+{
+  return nullptr;
+}
+
+// Converts a parameter to the type the method takes. Most types are
+// referenced in the value as is.
+template<typename T, typename = void>
+class ParameterHolder
+{
+public:
+  explicit ParameterHolder(const Value& value) : myValue(value.AsType<T>()) {}
+  operator const T&() const { return myValue; }
+
+private:
+  const T& myValue;
+};
+
+// Vectors reference packed arrays of the same type, or are built from the
+// elements of the array
+template<typename T>
+class ParameterHolder<std::vector<T>>
+{
+public:
+  explicit ParameterHolder(const Value& value)
+    : myPacked(GetPackedArray(value, static_cast<T*>(nullptr)))
+  {
+    if (!myPacked) {
+      auto& array = value.AsArray();
+      myVector.reserve(array.size());
+      for (auto& element : array) {
+        myVector.emplace_back(
+          static_cast<const T&>(ParameterHolder<T>(element)));
+      }
+    }
+  }
+
+  operator const std::vector<T>&() const
+  {
+    return myPacked ? *myPacked : myVector;
+  }
+
+private:
+  const std::vector<T>* myPacked;
+  std::vector<T> myVector;
+};
+
+class StructReader
+{
+public:
+  explicit StructReader(const Value::Struct& value) : myStruct(value) {}
+
+  template<typename T>
+  void operator()(const char* name, T& field)
+  {
+    auto it = myStruct.find(name);
+    if (it == myStruct.end()) {
+      throw InvalidParametersFault();
+    }
+    field = static_cast<const T&>(ParameterHolder<T>(it->second));
+  }
+
+private:
+  const Value::Struct& myStruct;
+};
+
+// Bound structs are read field by field, see StructTraits
+template<typename T>
+class ParameterHolder<
+  T, typename std::enable_if<IsBoundStruct<T>::value>::type>
+{
+public:
+  explicit ParameterHolder(const Value& value)
+  {
+    StructReader reader(value.AsStruct());
+    StructTraits<T>::Bind(reader, myObject);
+  }
+
+  operator const T&() const { return myObject; }
+
+private:
+  T myObject;
+};
+
+// Decodes the parameters of a call straight into the arguments of a method
+// while the request is parsed, see Dispatcher::CreateParameterDecoder.
+// Unlike for other handlers, strings must stay valid until Invoke returns.
+class ParameterDecoder : public ValueHandler
+{
+public:
+  // Called around the events of each parameter
+  virtual void StartParameter() = 0;
+  virtual void EndParameter() = 0;
+
+  // Calls the method with the decoded arguments
+  virtual Value Invoke() = 0;
+};
+
+// Fails on all events, subclasses override the ones they accept
+class ArgumentDecoderBase : public ValueHandler
+{
+public:
+  void StartArray() override { Fail(); }
+  void EndArray() override { Fail(); }
+  void StartStruct() override { Fail(); }
+  void EndStruct() override { Fail(); }
+  void StartStructElement(const char*, size_t) override { Fail(); }
+
+  void Binary(const char*, size_t) override { Fail(); }
+  void Boolean(bool) override { Fail(); }
+  void DateTime(const Value::DateTime&) override { Fail(); }
+  void Double(double) override { Fail(); }
+  void Integer32(int32_t) override { Fail(); }
+  void Integer64(int64_t) override { Fail(); }
+  void Nil() override { Fail(); }
+  void String(const char*, size_t) override { Fail(); }
+
+protected:
+  void Fail() { myIsFailed = true; }
+  void Done()
+  {
+    if (myIsDone) {
+      Fail();
+    }
+    myIsDone = true;
+  }
+  void Check() const
+  {
+    if (!myIsDone || myIsFailed) {
+      throw InvalidParametersFault();
+    }
+  }
+
+private:
+  bool myIsDone = false;
+  bool myIsFailed = false;
+};
+
+// Number conversions allowed for arguments, as in Value::AsType
+inline bool ConvertNumber(int32_t value, int32_t& out)
+{
+  out = value;
+  return true;
+}
+
+inline bool ConvertNumber(int64_t value, int32_t& out)
+{
+  out = static_cast<int32_t>(value);
+  return out == value;
+}
+
+inline bool ConvertNumber(double /*value*/, int32_t& /*out*/)
+{
+  return false;
+}
+
+inline bool ConvertNumber(int32_t value, int64_t& out)
+{
+  out = value;
+  return true;
+}
+
+inline bool ConvertNumber(int64_t value, int64_t& out)
+{
+  out = value;
+  return true;
+}
+
+inline bool ConvertNumber(double /*value*/, int64_t& /*out*/)
+{
+  return false;
+}
+
+template<typename T>
+bool ConvertNumber(T value, double& out)
+{
+  out = static_cast<double>(value);
+  return true;
+}
+
+template<typename T>
+class NumberDecoder : public ArgumentDecoderBase
+{
+public:
+  void Double(double value) override { Set(value); }
+  void Integer32(int32_t value) override { Set(value); }
+  void Integer64(int64_t value) override { Set(value); }
+
+  const T& Get() const
+  {
+    Check();
+    return myValue;
+  }
+
+private:
+  template<typename U>
+  void Set(U value)
+  {
+    if (!ConvertNumber(value, myValue)) {
+      Fail();
+    }
+    Done();
+  }
+
+  T myValue;
+};
+
+template<typename T>
+class PackedArrayDecoder : public ArgumentDecoderBase
+{
+public:
+  void StartArray() override
+  {
+    if (myIsStarted) {
+      Fail();
+    }
+    myIsStarted = true;
+  }
+  void EndArray() override { Done(); }
+
+  void Double(double value) override { Add(value); }
+  void Integer32(int32_t value) override { Add(value); }
+  void Integer64(int64_t value) override { Add(value); }
+
+  const std::vector<T>& Get() const
+  {
+    Check();
+    return myValue;
+  }
+
+private:
+  template<typename U>
+  void Add(U value)
+  {
+    T element{};
+    if (!ConvertNumber(value, element)) {
+      Fail();
+    }
+    myValue.push_back(element);
+  }
+
+  bool myIsStarted = false;
+  std::vector<T> myValue;
+};
+
+// Decodes an argument from the events of a parameter. Types without a
+// specialization are built as a Value first, and converted when the method
+// is invoked.
+template<typename T, typename = void>
+class ArgumentDecoder : public ValueHandler
+{
+public:
+  // Only used during the call, so strings need not be copied
+  ArgumentDecoder() : myBuilder(true) {}
+
+  void StartArray() override { myBuilder.StartArray(); }
+  void EndArray() override { myBuilder.EndArray(); }
+  void StartStruct() override { myBuilder.StartStruct(); }
+  void EndStruct() override { myBuilder.EndStruct(); }
+  void StartStructElement(const char* name, size_t size) override
+  {
+    myBuilder.StartStructElement(name, size);
+  }
+
+  void Binary(const char* data, size_t size) override
+  {
+    myBuilder.Binary(data, size);
+  }
+  void Boolean(bool value) override { myBuilder.Boolean(value); }
+  void DateTime(const Value::DateTime& value) override
+  {
+    myBuilder.DateTime(value);
+  }
+  void Double(double value) override { myBuilder.Double(value); }
+  void Integer32(int32_t value) override { myBuilder.Integer32(value); }
+  void Integer64(int64_t value) override { myBuilder.Integer64(value); }
+  void Nil() override { myBuilder.Nil(); }
+  void String(const char* data, size_t size) override
+  {
+    myBuilder.String(data, size);
+  }
+
+  ParameterHolder<T> Get()
+  {
+    return ParameterHolder<T>(myBuilder.GetValue());
+  }
+
+private:
+  ValueBuilder myBuilder;
+};
+
+template<>
+class ArgumentDecoder<bool> : public ArgumentDecoderBase
+{
+public:
+  void Boolean(bool value) override
+  {
+    myValue = value;
+    Done();
+  }
+
+  const bool& Get() const
+  {
+    Check();
+    return myValue;
+  }
+
+private:
+  bool myValue;
+};
+
+template<>
+class ArgumentDecoder<Value::DateTime> : public ArgumentDecoderBase
+{
+public:
+  void DateTime(const Value::DateTime& value) override
+  {
+    myValue = value;
+    Done();
+  }
+
+  const Value::DateTime& Get() const
+  {
+    Check();
+    return myValue;
+  }
+
+private:
+  Value::DateTime myValue;
+};
+
+template<>
+class ArgumentDecoder<std::string> : public ArgumentDecoderBase
+{
+public:
+  void Binary(const char* data, size_t size) override { String(data, size); }
+  void String(const char* data, size_t size) override
+  {
+    myValue.assign(data, size);
+    Done();
+  }
+
+  const std::string& Get() const
+  {
+    Check();
+    return myValue;
+  }
+
+private:
+  std::string myValue;
+};
+
+template<>
+class ArgumentDecoder<int32_t> : public NumberDecoder<int32_t> {};
+
+template<>
+class ArgumentDecoder<int64_t> : public NumberDecoder<int64_t> {};
+
+template<>
+class ArgumentDecoder<double> : public NumberDecoder<double> {};
+
+template<>
+class ArgumentDecoder<std::vector<int32_t>>
+  : public PackedArrayDecoder<int32_t> {};
+
+template<>
+class ArgumentDecoder<std::vector<int64_t>>
+  : public PackedArrayDecoder<int64_t> {};
+
+template<>
+class ArgumentDecoder<std::vector<double>>
+  : public PackedArrayDecoder<double> {};
+
+} // namespace xsonrpc
+
+#endif
@@ -22,6 +22,7 @@
 
 #include <deque>
 #include <string>
+#include <vector>
 
 namespace xsonrpc {
 
@@ -36,13 +37,21 @@ public:
 
   const std::string& GetMethodName() const { return myMethodName; }
   const Parameters& GetParameters() const { return myParameters; }
+  Parameters& GetParameters() { return myParameters; }
   const Value& GetId() const { return myId; }
 
   void Write(Writer& writer) const;
   static void Write(const std::string& methodName, const Parameters& params,
                     const Value& id, Writer& writer);
+  // Writes the requests as one batch, see Writer::StartBatch
+  static void WriteBatch(const std::vector<Request>& requests,
+                         Writer& writer);
 
 private:
+  static void WriteRequest(const std::string& methodName,
+                           const Parameters& params, const Value& id,
+                           Writer& writer);
+
   std::string myMethodName;
   Parameters myParameters;
   Value myId;
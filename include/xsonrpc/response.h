@@ -20,6 +20,8 @@
 
 #include "value.h"
 
+#include <vector>
+
 namespace xsonrpc {
 
 class Writer;
@@ -31,13 +33,20 @@ public:
   Response(int32_t faultCode, std::string faultString, Value id);
 
   void Write(Writer& writer) const;
+  // Writes the responses as one batch, see Writer::StartBatch
+  static void WriteBatch(const std::vector<Response>& responses,
+                         Writer& writer);
 
   Value& GetResult() { return myResult; }
   bool IsFault() const { return myIsFault; }
+  int32_t GetFaultCode() const { return myFaultCode; }
+  const std::string& GetFaultString() const { return myFaultString; }
   void ThrowIfFault() const;
   const Value& GetId() const { return myId; }
 
 private:
+  void WriteResponse(Writer& writer) const;
+
   Value myResult;
   bool myIsFault;
   int32_t myFaultCode;
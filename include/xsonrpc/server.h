@@ -20,6 +20,7 @@
 
 #include "dispatcher.h"
 
+#include <cstddef>
 #include <string>
 
 struct MHD_Connection;
@@ -42,6 +43,12 @@ public:
 
   void RegisterFormatHandler(FormatHandler& formatHandler);
 
+  // Larger requests are rejected. A multipart/related request, with binary
+  // values as attachments, is held in memory until it has arrived, so it
+  // has a limit of its own.
+  void SetMaxRequestSize(size_t size);
+  void SetMaxMultipartRequestSize(size_t size);
+
   void Run();
   int GetFileDescriptor();
   void OnReadableFileDescriptor();
@@ -71,6 +78,8 @@ private:
 
   MHD_Daemon* myDaemon;
   Dispatcher myDispatcher;
+  size_t myMaxRequestSize;
+  size_t myMaxMultipartRequestSize;
   std::vector<FormatHandler*> myFormatHandlers;
 };
 
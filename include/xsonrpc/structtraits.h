@@ -0,0 +1,276 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef XSONRPC_STRUCTTRAITS_H
+#define XSONRPC_STRUCTTRAITS_H
+
+#include "value.h"
+#include "writer.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xsonrpc {
+
+// Specialize StructTraits for a type to let methods take and return it
+// directly, without building a Value::Struct by hand. Bind is used both
+// for reading and writing (so T may be const) and should pass each field
+// to the binder, in the order they are to be written:
+//
+//   template<>
+//   struct StructTraits<Point>
+//   {
+//     template<typename Binder, typename T>
+//     static void Bind(Binder& binder, T& point)
+//     {
+//       binder("x", point.X);
+//       binder("y", point.Y);
+//     }
+//   };
+template<typename T>
+struct StructTraits
+{
+};
+
+struct ProbeBinder
+{
+  template<typename T>
+  void operator()(const char* /*name*/, T& /*field*/) {}
+};
+
+template<typename T, typename = void>
+struct IsBoundStruct : std::false_type {};
+
+template<typename T>
+struct IsBoundStruct<T, decltype(StructTraits<T>::Bind(
+  std::declval<ProbeBinder&>(), std::declval<T&>()))>
+  : std::true_type {};
+
+// Types that are written through StructTraits
+template<typename T>
+struct NeedsBinding : IsBoundStruct<T> {};
+
+template<typename T>
+struct NeedsBinding<std::vector<T>> : NeedsBinding<T> {};
+
+inline void WriteValue(Writer& writer, const Value& value);
+inline void WriteValue(Writer& writer, bool value);
+inline void WriteValue(Writer& writer, double value);
+inline void WriteValue(Writer& writer, int32_t value);
+inline void WriteValue(Writer& writer, int64_t value);
+inline void WriteValue(Writer& writer, const std::string& value);
+inline void WriteValue(Writer& writer, const Value::DateTime& value);
+inline void WriteValue(Writer& writer, const std::vector<int32_t>& value);
+inline void WriteValue(Writer& writer, const std::vector<int64_t>& value);
+inline void WriteValue(Writer& writer, const std::vector<double>& value);
+
+template<typename T>
+void WriteValue(Writer& writer, const std::vector<T>& value);
+
+template<typename T>
+void WriteValue(Writer& writer, const std::map<std::string, T>& value);
+
+template<typename T>
+typename std::enable_if<IsBoundStruct<T>::value>::type
+WriteValue(Writer& writer, const T& value);
+
+// Creates a value from anything a Value can be constructed from, as well
+// as from bound structs (and vectors of them). The latter are written
+// directly and only converted to a Value::Struct if accessed.
+template<typename T>
+typename std::enable_if<
+  !NeedsBinding<typename std::decay<T>::type>::value, Value>::type
+ToValue(T&& value)
+{
+  return Value(std::forward<T>(value));
+}
+
+template<typename T>
+typename std::enable_if<
+  NeedsBinding<typename std::decay<T>::type>::value, Value>::type
+ToValue(T&& value);
+
+class StructWriter
+{
+public:
+  explicit StructWriter(Writer& writer) : myWriter(writer) {}
+
+  template<typename T>
+  void operator()(const char* name, const T& field)
+  {
+    myWriter.StartStructElement(name);
+    WriteValue(myWriter, field);
+    myWriter.EndStructElement();
+  }
+
+private:
+  Writer& myWriter;
+};
+
+class StructBuilder
+{
+public:
+  explicit StructBuilder(Value::Struct& value) : myStruct(value) {}
+
+  template<typename T>
+  void operator()(const char* name, const T& field)
+  {
+    myStruct.emplace(name, ToValue(field));
+  }
+
+private:
+  Value::Struct& myStruct;
+};
+
+template<typename T>
+typename std::enable_if<IsBoundStruct<T>::value, Value>::type
+BoundToValue(const T& value)
+{
+  Value::Struct data;
+  StructBuilder builder(data);
+  StructTraits<T>::Bind(builder, value);
+  return Value(std::move(data));
+}
+
+template<typename T>
+Value BoundToValue(const std::vector<T>& value)
+{
+  Value::Array data;
+  data.reserve(value.size());
+  for (auto& element : value) {
+    data.push_back(ToValue(element));
+  }
+  return Value(std::move(data));
+}
+
+template<typename T>
+class BoundValue final : public Value::Writable
+{
+public:
+  explicit BoundValue(T object) : myObject(std::move(object)) {}
+
+  Value::Type GetType() const override
+  {
+    return IsBoundStruct<T>::value ? Value::Type::STRUCT : Value::Type::ARRAY;
+  }
+  Writable* Clone() const override { return new BoundValue(myObject); }
+  void Write(Writer& writer) const override { WriteValue(writer, myObject); }
+  Value CreateValue() const override { return BoundToValue(myObject); }
+
+private:
+  T myObject;
+};
+
+template<typename T>
+typename std::enable_if<
+  NeedsBinding<typename std::decay<T>::type>::value, Value>::type
+ToValue(T&& value)
+{
+  typedef typename std::decay<T>::type Type;
+  return Value(std::unique_ptr<Value::Writable>(
+      new BoundValue<Type>(std::forward<T>(value))));
+}
+
+inline void WriteValue(Writer& writer, const Value& value)
+{
+  value.Write(writer);
+}
+
+inline void WriteValue(Writer& writer, bool value)
+{
+  writer.Write(value);
+}
+
+inline void WriteValue(Writer& writer, double value)
+{
+  writer.Write(value);
+}
+
+inline void WriteValue(Writer& writer, int32_t value)
+{
+  writer.Write(value);
+}
+
+inline void WriteValue(Writer& writer, int64_t value)
+{
+  writer.Write(value);
+}
+
+inline void WriteValue(Writer& writer, const std::string& value)
+{
+  writer.Write(value.data(), value.size());
+}
+
+inline void WriteValue(Writer& writer, const Value::DateTime& value)
+{
+  writer.Write(value);
+}
+
+inline void WriteValue(Writer& writer, const std::vector<int32_t>& value)
+{
+  writer.WriteArray(value.data(), value.size());
+}
+
+inline void WriteValue(Writer& writer, const std::vector<int64_t>& value)
+{
+  writer.WriteArray(value.data(), value.size());
+}
+
+inline void WriteValue(Writer& writer, const std::vector<double>& value)
+{
+  writer.WriteArray(value.data(), value.size());
+}
+
+template<typename T>
+void WriteValue(Writer& writer, const std::vector<T>& value)
+{
+  writer.StartArray();
+  for (auto& element : value) {
+    WriteValue(writer, element);
+  }
+  writer.EndArray();
+}
+
+template<typename T>
+void WriteValue(Writer& writer, const std::map<std::string, T>& value)
+{
+  writer.StartStruct();
+  for (auto& element : value) {
+    writer.StartStructElement(element.first);
+    WriteValue(writer, element.second);
+    writer.EndStructElement();
+  }
+  writer.EndStruct();
+}
+
+template<typename T>
+typename std::enable_if<IsBoundStruct<T>::value>::type
+WriteValue(Writer& writer, const T& value)
+{
+  writer.StartStruct();
+  StructWriter structWriter(writer);
+  StructTraits<T>::Bind(structWriter, value);
+  writer.EndStruct();
+}
+
+} // namespace xsonrpc
+
+#endif
@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -35,10 +36,41 @@ class Value
 {
 public:
   typedef std::vector<Value> Array;
-  typedef tm DateTime;
   typedef std::string String;
   typedef std::map<std::string, Value> Struct;
 
+  // String data owned by someone else, e.g. the buffer of the request being
+  // handled. Values created from a StringRef do not copy the data, so it
+  // must outlive the value.
+  struct StringRef
+  {
+    const char* Data;
+    size_t Size;
+  };
+
+  // Date and time without time zone, as used by XML-RPC. Stored as seconds
+  // since 1970-01-01T00:00:00 so that it fits inline in a value.
+  class DateTime
+  {
+  public:
+    DateTime() = default;
+    explicit DateTime(int64_t secondsSinceEpoch)
+      : mySecondsSinceEpoch(secondsSinceEpoch) {}
+    DateTime(const tm& value);
+
+    int64_t GetSecondsSinceEpoch() const { return mySecondsSinceEpoch; }
+    tm ToTm() const;
+
+    bool operator==(const DateTime& other) const
+    {
+      return mySecondsSinceEpoch == other.mySecondsSinceEpoch;
+    }
+    bool operator!=(const DateTime& other) const { return !(*this == other); }
+
+  private:
+    int64_t mySecondsSinceEpoch = 0;
+  };
+
   enum class Type
   {
     ARRAY,
@@ -53,6 +85,43 @@ public:
     STRUCT
   };
 
+  // Encodings a value can be given in, see Value(Format, String)
+  enum class Format
+  {
+    JSON,
+    XML
+  };
+
+  // Produces the elements of an array one at a time, so that a large array
+  // can be written while it is produced instead of first being built in
+  // memory. Each element is written before the next one is produced.
+  class Generator
+  {
+  public:
+    virtual ~Generator() {}
+
+    // Sets element to the next element and returns true, or returns false
+    // when there are no more elements
+    virtual bool Next(Value& element) = 0;
+  };
+
+  // An object that writes itself to a Writer without first being converted
+  // to values, e.g. a bound struct (see structtraits.h). It is converted
+  // only if its contents are accessed.
+  class Writable
+  {
+  public:
+    virtual ~Writable() {}
+
+    virtual Type GetType() const = 0;
+    virtual Writable* Clone() const = 0;
+    virtual void Write(Writer& writer) const = 0;
+    virtual Value CreateValue() const = 0;
+    // Arrays that are generated return their generator, so that the
+    // elements can be written one at a time
+    virtual Generator* GetGenerator() const { return nullptr; }
+  };
+
   Value() : myType(Type::NIL) {}
   Value(Array value);
   Value(bool value) : myType(Type::BOOLEAN) { as.myBoolean = value; }
@@ -62,7 +131,23 @@ public:
   Value(int64_t value);
   Value(const char* value) : Value(String(value)) {}
   Value(String value, bool binary = false);
+  explicit Value(StringRef value, bool binary = false);
   Value(Struct value);
+  explicit Value(std::unique_ptr<Writable> value);
+  // An array whose elements can only be produced once, so copies of the
+  // value share them
+  explicit Value(std::unique_ptr<Generator> generator);
+  // A value that is already encoded, e.g. a cached document. XML is a
+  // <value> element. Writers of the same format copy it as is, while other
+  // writers, and accessing its contents, parse it. Only its type is checked
+  // up front, so it must be valid. Copies of the value share the data.
+  Value(Format format, String data);
+
+  // Arrays of these types are stored packed instead of as one value per
+  // element, see AsInteger32Array() etc.
+  Value(std::vector<int32_t> value);
+  Value(std::vector<int64_t> value);
+  Value(std::vector<double> value);
 
   template<typename T>
   Value(std::vector<T> value)
@@ -110,6 +195,40 @@ public:
   bool IsString() const { return myType == Type::STRING; }
   bool IsStruct() const { return myType == Type::STRUCT; }
 
+  // True if the string or binary data is referenced rather than owned
+  bool IsStringRef() const
+  {
+    return myIsStringRef && !as.myStringRef.Copy;
+  }
+  // True if the value is a Writable that has not been converted yet
+  bool IsWritable() const
+  {
+    return myIsWritable && !as.myWritable.Converted;
+  }
+  // The generator of an array that has not been converted yet, or null
+  Generator* GetGenerator() const
+  {
+    return IsWritable() ? as.myWritable.Object->GetGenerator() : nullptr;
+  }
+
+  // True for packed arrays (which are also arrays)
+  bool IsInteger32Array() const
+  {
+    return GetPacking() == Packing::INTEGER_32;
+  }
+  bool IsInteger64Array() const
+  {
+    return GetPacking() == Packing::INTEGER_64;
+  }
+  bool IsDoubleArray() const { return GetPacking() == Packing::DOUBLE; }
+
+  // The accessors may keep a conversion that they make on first use, e.g.
+  // the copy of a referenced string that AsString returns or the contents
+  // of a Writable, in mutable members. Values are therefore not thread
+  // safe even when const, and must not be accessed from several threads at
+  // once.
+
+  // For packed arrays this creates a value per element on first use
   const Array& AsArray() const;
   const String& AsBinary() const { return AsString(); }
   const bool& AsBoolean() const;
@@ -118,30 +237,79 @@ public:
   const int32_t& AsInteger32() const;
   const int64_t& AsInteger64() const;
   const String& AsString() const;
+  StringRef AsStringRef() const;
   const Struct& AsStruct() const;
 
+  const std::vector<int32_t>& AsInteger32Array() const;
+  const std::vector<int64_t>& AsInteger64Array() const;
+  const std::vector<double>& AsDoubleArray() const;
+
   template<typename T>
   inline const T& AsType() const;
 
   Type GetType() const { return myType; }
 
+  // Calls Writer::WriteValue, so that the writer can traverse the value
+  // without a virtual call per element
   void Write(Writer& writer) const;
 
   inline const Value& operator[](Array::size_type i) const;
   inline const Value& operator[](const Struct::key_type& key) const;
 
 private:
+  enum class Packing : uint8_t
+  {
+    NONE,
+    INTEGER_32,
+    INTEGER_64,
+    DOUBLE
+  };
+
+  template<typename T>
+  struct PackedArray;
+
+  // Converts a Writable on first use and returns the result
+  const Value& Convert() const;
+  Packing GetPacking() const
+  {
+    auto converted = myIsWritable ? as.myWritable.Converted : nullptr;
+    return converted ? converted->myPacking : myPacking;
+  }
   void Reset();
 
+  template<typename WriterType>
+  friend void SerializeValue(const Value& value, WriterType& writer);
+
   Type myType;
+  bool myIsStringRef = false;
+  bool myIsWritable = false;
+  Packing myPacking = Packing::NONE;
   union
   {
     Array* myArray;
+    PackedArray<int32_t>* myInteger32Array;
+    PackedArray<int64_t>* myInteger64Array;
+    PackedArray<double>* myDoubleArray;
     bool myBoolean;
-    DateTime* myDateTime;
+    // Has an initializer since DateTime isn't trivially default
+    // constructible, which would otherwise delete the union's constructor
+    DateTime myDateTime = {};
     String* myString;
+    struct
+    {
+      StringRef Ref;
+      // Created by the first call to AsString, after which the value owns
+      // its data
+      mutable String* Copy;
+    } myStringRef;
     Struct* myStruct;
     struct
+    {
+      Writable* Object;
+      // Created by the first access to the contents, see Convert
+      mutable Value* Converted;
+    } myWritable;
+    struct
     {
       double myDouble;
       int32_t myInteger32;
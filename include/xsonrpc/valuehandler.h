@@ -0,0 +1,120 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef XSONRPC_VALUEHANDLER_H
+#define XSONRPC_VALUEHANDLER_H
+
+#include "value.h"
+
+#include <string>
+#include <vector>
+
+namespace xsonrpc {
+
+// Receives a value as a sequence of events, e.g. straight from a parser
+// without building a Value. Strings passed to the handler are only valid
+// during the call.
+class ValueHandler
+{
+public:
+  virtual ~ValueHandler() {}
+
+  virtual void StartArray() = 0;
+  virtual void EndArray() = 0;
+  virtual void StartStruct() = 0;
+  virtual void EndStruct() = 0;
+  virtual void StartStructElement(const char* name, size_t size) = 0;
+
+  virtual void Binary(const char* data, size_t size) = 0;
+  // Binary data that is still base64 encoded. The handler may decode it in
+  // place. The default does so and passes the data to Binary.
+  virtual void Base64(char* text, size_t size);
+  virtual void Boolean(bool value) = 0;
+  virtual void DateTime(const Value::DateTime& value) = 0;
+  virtual void Double(double value) = 0;
+  virtual void Integer32(int32_t value) = 0;
+  virtual void Integer64(int64_t value) = 0;
+  virtual void Nil() = 0;
+  virtual void String(const char* data, size_t size) = 0;
+};
+
+// Builds a Value from events
+class ValueBuilder final : public ValueHandler
+{
+public:
+  // If strings are referenced rather than copied (see Value::StringRef),
+  // the data passed to the builder must outlive the built value
+  explicit ValueBuilder(bool stringsByReference = false)
+    : myStringsByReference(stringsByReference) {}
+
+  bool IsDone() const { return myIsDone; }
+  // Throws InvalidParametersFault unless a complete value has been built
+  Value& GetValue();
+  // Prepares for building another value
+  void Reset();
+
+  // ValueHandler
+  void StartArray() override;
+  void EndArray() override;
+  void StartStruct() override;
+  void EndStruct() override;
+  void StartStructElement(const char* name, size_t size) override;
+
+  void Binary(const char* data, size_t size) override;
+  void Base64(char* text, size_t size) override;
+  void Boolean(bool value) override;
+  void DateTime(const Value::DateTime& value) override;
+  void Double(double value) override;
+  void Integer32(int32_t value) override;
+  void Integer64(int64_t value) override;
+  void Nil() override;
+  void String(const char* data, size_t size) override;
+
+private:
+  struct Container
+  {
+    explicit Container(bool isStruct) : IsStruct(isStruct) {}
+
+    bool IsStruct;
+    // Numbers of the same type are packed, as done by the readers, so the
+    // elements of an array are kept in the vector of their type until one
+    // of another type is added. NIL while the array is empty, and ARRAY
+    // once the elements are in Array.
+    Value::Type ElementType = Value::Type::NIL;
+    std::vector<int32_t> Integer32Array;
+    std::vector<int64_t> Integer64Array;
+    std::vector<double> DoubleArray;
+    Value::Array Array;
+    Value::Struct Struct;
+    std::string Name;
+  };
+
+  template<typename T>
+  void AddNumber(T value, Value::Type type,
+                 std::vector<T> Container::*elements);
+  void Add(Value value);
+  Value CreateString(const char* data, size_t size, bool binary) const;
+
+  bool myStringsByReference;
+  std::vector<Container> myContainers;
+  Value myValue;
+  bool myIsDone = false;
+};
+
+} // namespace xsonrpc
+
+#endif
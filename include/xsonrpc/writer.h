@@ -18,14 +18,12 @@
 #ifndef XSONRPC_WRITER_H
 #define XSONRPC_WRITER_H
 
-#include <string>
+#include "value.h"
 
-struct tm;
+#include <string>
 
 namespace xsonrpc {
 
-class Value;
-
 class Writer
 {
 public:
@@ -34,11 +32,18 @@ public:
   // Result
   virtual const char* GetData() = 0;
   virtual size_t GetSize() = 0;
+  // Discards the data written so far without ending the document, so that
+  // it can be sent in parts
+  virtual void ClearData() = 0;
 
   // Document
   virtual void StartDocument() = 0;
   virtual void EndDocument() = 0;
 
+  // Batch of requests or responses, for formats that support it
+  virtual void StartBatch() = 0;
+  virtual void EndBatch() = 0;
+
   // Request
   virtual void StartRequest(const std::string& methodName,
                             const Value& id) = 0;
@@ -59,7 +64,11 @@ public:
   virtual void StartStruct() = 0;
   virtual void EndStruct() = 0;
   virtual void StartStructElement(const std::string& name) = 0;
+  virtual void StartStructElement(const char* name) = 0;
   virtual void EndStructElement() = 0;
+  virtual void WriteArray(const int32_t* data, size_t size) = 0;
+  virtual void WriteArray(const int64_t* data, size_t size) = 0;
+  virtual void WriteArray(const double* data, size_t size) = 0;
   virtual void WriteBinary(const char* data, size_t size) = 0;
   virtual void WriteNull() = 0;
   virtual void Write(bool value) = 0;
@@ -67,7 +76,20 @@ public:
   virtual void Write(int32_t value) = 0;
   virtual void Write(int64_t value) = 0;
   virtual void Write(const std::string& value) = 0;
-  virtual void Write(const tm& value) = 0;
+  virtual void Write(const char* data, size_t size) = 0;
+  virtual void Write(const Value::DateTime& value) = 0;
+  // Writes a value that is already encoded, see Value(Format, String), and
+  // returns true, or returns false if the writer can't use the format
+  virtual bool WriteRaw(Value::Format /*format*/, const char* /*data*/,
+                        size_t /*size*/)
+  {
+    return false;
+  }
+
+  // Writes a whole value. The default makes a virtual call per element;
+  // the library's writers override it to traverse the value with their
+  // own calls inlined.
+  virtual void WriteValue(const Value& value);
 };
 
 } // namespace xsonrpc
@@ -35,6 +35,8 @@ public:
   std::string GetContentType() override;
   bool UsesId() override;
   std::unique_ptr<Reader> CreateReader(std::string data) override;
+  std::unique_ptr<RequestParser> CreateRequestParser(
+    const Dispatcher& dispatcher) override;
   std::unique_ptr<Writer> CreateWriter() override;
 
 private:
@@ -26,6 +26,7 @@
 namespace xsonrpc {
 
 class Dispatcher;
+class FormatHandler;
 
 class XmlRpcSystemMethods
 {
@@ -36,6 +37,13 @@ public:
   void AddCapability(std::string name, std::string url, int32_t version);
   void RemoveCapability(const std::string& name);
 
+  // Lists the format as a capability named after its content type, for
+  // clients that negotiate the format, see Client::SetFormatHandlers. The
+  // formats of the handlers registered with the server are listed without
+  // this (see Dispatcher::AddFormat), so it is only needed for formats that
+  // the dispatcher is reached through by other means.
+  void AddFormat(FormatHandler& formatHandler);
+
 private:
   Value SystemMulticall(const Request::Parameters& parameters) const;
   Value SystemListMethods() const;
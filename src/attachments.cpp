@@ -0,0 +1,637 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "attachments.h"
+
+#include "dispatcher.h"
+#include "fault.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+
+namespace {
+
+const char CRLF[] = "\r\n";
+const char APPLICATION_OCTET_STREAM[] = "application/octet-stream";
+
+bool Contains(const char* data, size_t size, const std::string& str)
+{
+  return std::search(data, data + size, str.begin(), str.end())
+    != data + size;
+}
+
+std::string Trim(const std::string& str, size_t begin, size_t end)
+{
+  end = std::min(end, str.size());
+  while (begin < end && isspace(static_cast<unsigned char>(str[begin]))) {
+    ++begin;
+  }
+  while (end > begin && isspace(static_cast<unsigned char>(str[end - 1]))) {
+    --end;
+  }
+  return str.substr(begin, end - begin);
+}
+
+std::string ToLower(std::string str)
+{
+  for (auto& c : str) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+  return str;
+}
+
+// Gets the Content-ID from the header lines of a part, without the angle
+// brackets
+std::string GetContentId(const std::string& message, size_t begin,
+                         size_t end)
+{
+  while (begin < end) {
+    size_t lineEnd = message.find(CRLF, begin);
+    if (lineEnd == std::string::npos || lineEnd > end) {
+      lineEnd = end;
+    }
+    const size_t colon = message.find(':', begin);
+    if (colon < lineEnd
+        && ToLower(Trim(message, begin, colon)) == "content-id") {
+      auto id = Trim(message, colon + 1, lineEnd);
+      if (id.size() >= 2 && id.front() == '<' && id.back() == '>') {
+        id = id.substr(1, id.size() - 2);
+      }
+      return id;
+    }
+    begin = lineEnd + 2;
+  }
+  return std::string();
+}
+
+// Finds the attachment that a reference names, or returns null
+const xsonrpc::Attachment* FindAttachment(
+  const xsonrpc::Attachments& attachments, const char* data, size_t size)
+{
+  const size_t prefixSize = sizeof(xsonrpc::ATTACHMENT_PREFIX) - 1;
+  if (size <= prefixSize
+      || memcmp(data, xsonrpc::ATTACHMENT_PREFIX, prefixSize) != 0) {
+    return nullptr;
+  }
+  data += prefixSize;
+  size -= prefixSize;
+
+  // The ids written by AttachmentWriter start with the index of the part,
+  // which is tried first
+  size_t index = 0;
+  for (size_t i = 0; i < size && isdigit(static_cast<unsigned char>(data[i]));
+       ++i) {
+    index = index * 10 + static_cast<size_t>(data[i] - '0');
+    if (index >= attachments.size()) {
+      break;
+    }
+  }
+  if (index < attachments.size()
+      && attachments[index].Id.compare(0, std::string::npos, data, size)
+      == 0) {
+    return &attachments[index];
+  }
+  for (auto& attachment : attachments) {
+    if (attachment.Id.compare(0, std::string::npos, data, size) == 0) {
+      return &attachment;
+    }
+  }
+  return nullptr;
+}
+
+const xsonrpc::Attachment* FindAttachment(
+  const xsonrpc::Value& value, const xsonrpc::Attachments& attachments)
+{
+  if (!value.IsStruct() || value.AsStruct().size() != 1) {
+    return nullptr;
+  }
+  auto& member = *value.AsStruct().begin();
+  if (member.first != xsonrpc::ATTACHMENT_NAME
+      || !member.second.IsString()) {
+    return nullptr;
+  }
+  auto id = member.second.AsStringRef();
+  return FindAttachment(attachments, id.Data, id.Size);
+}
+
+// Sets resolved and returns true if the value references attachments, so
+// that each value is only visited once
+bool Resolve(const xsonrpc::Value& value,
+             const xsonrpc::Attachments& attachments, bool byReference,
+             xsonrpc::Value& resolved)
+{
+  using xsonrpc::Value;
+
+  if (auto attachment = FindAttachment(value, attachments)) {
+    if (byReference) {
+      resolved = Value(attachment->Data, true);
+    }
+    else {
+      resolved = Value(
+        Value::String(attachment->Data.Data, attachment->Data.Size), true);
+    }
+    return true;
+  }
+  else if (value.IsStruct()) {
+    // Only copied once a member has a reference
+    auto& members = value.AsStruct();
+    std::unique_ptr<Value::Struct> copy;
+    for (auto it = members.begin(); it != members.end(); ++it) {
+      Value member;
+      if (Resolve(it->second, attachments, byReference, member)) {
+        if (!copy) {
+          copy.reset(new Value::Struct());
+          for (auto previous = members.begin(); previous != it;
+               ++previous) {
+            copy->emplace(previous->first, Value(previous->second));
+          }
+        }
+        copy->emplace(it->first, std::move(member));
+      }
+      else if (copy) {
+        copy->emplace(it->first, Value(it->second));
+      }
+    }
+    if (copy) {
+      resolved = Value(std::move(*copy));
+      return true;
+    }
+  }
+  else if (value.IsArray() && !value.IsInteger32Array()
+           && !value.IsInteger64Array() && !value.IsDoubleArray()
+           && !value.GetGenerator()) {
+    auto& elements = value.AsArray();
+    std::unique_ptr<Value::Array> copy;
+    for (size_t i = 0; i < elements.size(); ++i) {
+      Value element;
+      if (Resolve(elements[i], attachments, byReference, element)) {
+        if (!copy) {
+          copy.reset(new Value::Array());
+          copy->reserve(elements.size());
+          for (size_t j = 0; j < i; ++j) {
+            copy->emplace_back(Value(elements[j]));
+          }
+        }
+        copy->push_back(std::move(element));
+      }
+      else if (copy) {
+        copy->emplace_back(Value(elements[i]));
+      }
+    }
+    if (copy) {
+      resolved = Value(std::move(*copy));
+      return true;
+    }
+  }
+  return false;
+}
+
+// Builds the parameters as values, for methods without a decoder
+class ValueParameterDecoder final : public xsonrpc::ParameterDecoder
+{
+public:
+  explicit ValueParameterDecoder(const xsonrpc::MethodWrapper& method)
+    : myMethod(method),
+      myBuilder(true)
+  {
+  }
+
+  // ParameterDecoder
+  void StartParameter() override { myBuilder.Reset(); }
+  void EndParameter() override
+  {
+    myParameters.push_back(std::move(myBuilder.GetValue()));
+  }
+  xsonrpc::Value Invoke() override { return myMethod(myParameters); }
+
+  // ValueHandler
+  void StartArray() override { myBuilder.StartArray(); }
+  void EndArray() override { myBuilder.EndArray(); }
+  void StartStruct() override { myBuilder.StartStruct(); }
+  void EndStruct() override { myBuilder.EndStruct(); }
+  void StartStructElement(const char* name, size_t size) override
+  {
+    myBuilder.StartStructElement(name, size);
+  }
+
+  void Binary(const char* data, size_t size) override
+  {
+    myBuilder.Binary(data, size);
+  }
+  void Base64(char* text, size_t size) override
+  {
+    myBuilder.Base64(text, size);
+  }
+  void Boolean(bool value) override { myBuilder.Boolean(value); }
+  void DateTime(const xsonrpc::Value::DateTime& value) override
+  {
+    myBuilder.DateTime(value);
+  }
+  void Double(double value) override { myBuilder.Double(value); }
+  void Integer32(int32_t value) override { myBuilder.Integer32(value); }
+  void Integer64(int64_t value) override { myBuilder.Integer64(value); }
+  void Nil() override { myBuilder.Nil(); }
+  void String(const char* data, size_t size) override
+  {
+    myBuilder.String(data, size);
+  }
+
+private:
+  const xsonrpc::MethodWrapper& myMethod;
+  xsonrpc::ValueBuilder myBuilder;
+  xsonrpc::Request::Parameters myParameters;
+};
+
+// Passes the events on to another decoder, with references to attachments
+// replaced by the binary data. The events of a struct are held back until
+// it is clear whether it is a reference.
+class AttachmentDecoder final : public xsonrpc::ParameterDecoder
+{
+public:
+  AttachmentDecoder(std::unique_ptr<xsonrpc::ParameterDecoder> decoder,
+                    const xsonrpc::Attachments& attachments)
+    : myDecoder(std::move(decoder)),
+      myAttachments(attachments)
+  {
+  }
+
+  // ParameterDecoder
+  void StartParameter() override { myDecoder->StartParameter(); }
+  void EndParameter() override { myDecoder->EndParameter(); }
+  xsonrpc::Value Invoke() override { return myDecoder->Invoke(); }
+
+  // ValueHandler
+  void StartArray() override
+  {
+    Flush();
+    myDecoder->StartArray();
+  }
+  void EndArray() override
+  {
+    Flush();
+    myDecoder->EndArray();
+  }
+  void StartStruct() override
+  {
+    Flush();
+    myState = State::STRUCT;
+  }
+  void EndStruct() override
+  {
+    if (myState == State::REFERENCE) {
+      myState = State::NONE;
+      myDecoder->Binary(myAttachment->Data.Data, myAttachment->Data.Size);
+      return;
+    }
+    Flush();
+    myDecoder->EndStruct();
+  }
+  void StartStructElement(const char* name, size_t size) override
+  {
+    if (myState == State::STRUCT
+        && size == sizeof(xsonrpc::ATTACHMENT_NAME) - 1
+        && memcmp(name, xsonrpc::ATTACHMENT_NAME, size) == 0) {
+      myState = State::NAME;
+      return;
+    }
+    Flush();
+    myDecoder->StartStructElement(name, size);
+  }
+
+  void Binary(const char* data, size_t size) override
+  {
+    Flush();
+    myDecoder->Binary(data, size);
+  }
+  void Base64(char* text, size_t size) override
+  {
+    Flush();
+    myDecoder->Base64(text, size);
+  }
+  void Boolean(bool value) override
+  {
+    Flush();
+    myDecoder->Boolean(value);
+  }
+  void DateTime(const xsonrpc::Value::DateTime& value) override
+  {
+    Flush();
+    myDecoder->DateTime(value);
+  }
+  void Double(double value) override
+  {
+    Flush();
+    myDecoder->Double(value);
+  }
+  void Integer32(int32_t value) override
+  {
+    Flush();
+    myDecoder->Integer32(value);
+  }
+  void Integer64(int64_t value) override
+  {
+    Flush();
+    myDecoder->Integer64(value);
+  }
+  void Nil() override
+  {
+    Flush();
+    myDecoder->Nil();
+  }
+  void String(const char* data, size_t size) override
+  {
+    if (myState == State::NAME) {
+      myAttachment = FindAttachment(myAttachments, data, size);
+      if (myAttachment) {
+        myState = State::REFERENCE;
+        return;
+      }
+    }
+    Flush();
+    myDecoder->String(data, size);
+  }
+
+private:
+  enum class State
+  {
+    NONE,
+    STRUCT,
+    NAME,
+    REFERENCE
+  };
+
+  // Passes on the events that were held back, as they turned out not to be
+  // a reference
+  void Flush()
+  {
+    if (myState == State::NONE) {
+      return;
+    }
+    const auto state = myState;
+    myState = State::NONE;
+
+    myDecoder->StartStruct();
+    if (state == State::STRUCT) {
+      return;
+    }
+    myDecoder->StartStructElement(xsonrpc::ATTACHMENT_NAME,
+                                  sizeof(xsonrpc::ATTACHMENT_NAME) - 1);
+    if (state == State::REFERENCE) {
+      // Strings passed to a decoder must stay valid until it is invoked
+      myStrings.push_back(xsonrpc::ATTACHMENT_PREFIX + myAttachment->Id);
+      myDecoder->String(myStrings.back().data(), myStrings.back().size());
+    }
+  }
+
+  std::unique_ptr<xsonrpc::ParameterDecoder> myDecoder;
+  const xsonrpc::Attachments& myAttachments;
+  State myState = State::NONE;
+  const xsonrpc::Attachment* myAttachment = nullptr;
+  std::deque<std::string> myStrings;
+};
+
+} // namespace
+
+namespace xsonrpc {
+
+AttachmentWriter::AttachmentWriter(std::unique_ptr<Writer> writer,
+                                   bool collect)
+  : myWriter(std::move(writer)),
+    myCollect(collect)
+{
+  std::random_device random;
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%08x%08x@xsonrpc",
+           static_cast<unsigned>(random()), static_cast<unsigned>(random()));
+  myIdSuffix = suffix;
+}
+
+void AttachmentWriter::WriteBinary(const char* data, size_t size)
+{
+  if (!myCollect || size < ATTACHMENT_MIN_SIZE) {
+    myWriter->WriteBinary(data, size);
+    return;
+  }
+
+  auto id = std::to_string(myAttachments.size()) + myIdSuffix;
+  myWriter->StartStruct();
+  myWriter->StartStructElement(ATTACHMENT_NAME);
+  myWriter->Write(ATTACHMENT_PREFIX + id);
+  myWriter->EndStructElement();
+  myWriter->EndStruct();
+  myAttachments.push_back({std::move(id), {data, size}});
+}
+
+std::string GetMultipartContentType(const std::string& rootType,
+                                    const std::string& boundary)
+{
+  return std::string(MULTIPART_RELATED) + "; type=\"" + rootType
+    + "\"; boundary=\"" + boundary + "\"";
+}
+
+bool ParseMultipartContentType(const std::string& contentType,
+                               std::string& rootType, std::string& boundary)
+{
+  size_t pos = contentType.find(';');
+  if (ToLower(Trim(contentType, 0, pos)) != MULTIPART_RELATED) {
+    return false;
+  }
+
+  rootType.clear();
+  boundary.clear();
+  while (pos < contentType.size()) {
+    const size_t equals = contentType.find('=', ++pos);
+    if (equals == std::string::npos) {
+      return false;
+    }
+    const auto name = ToLower(Trim(contentType, pos, equals));
+
+    pos = equals + 1;
+    while (pos < contentType.size() && contentType[pos] == ' ') {
+      ++pos;
+    }
+    std::string value;
+    if (pos < contentType.size() && contentType[pos] == '"') {
+      for (++pos; pos < contentType.size() && contentType[pos] != '"';
+           ++pos) {
+        if (contentType[pos] == '\\' && pos + 1 < contentType.size()) {
+          ++pos;
+        }
+        value += contentType[pos];
+      }
+      if (pos == contentType.size()) {
+        return false;
+      }
+      pos = contentType.find(';', pos);
+    }
+    else {
+      const size_t end = contentType.find(';', pos);
+      value = Trim(contentType, pos, end);
+      pos = end;
+    }
+
+    if (name == "type") {
+      rootType = std::move(value);
+    }
+    else if (name == "boundary") {
+      boundary = std::move(value);
+    }
+  }
+  return !rootType.empty() && !boundary.empty();
+}
+
+std::string CreateBoundary(const char* data, size_t size,
+                           const Attachments& attachments)
+{
+  for (unsigned i = 0; ; ++i) {
+    auto boundary = "xsonrpc-boundary-" + std::to_string(i);
+    bool isUnique = !Contains(data, size, boundary);
+    for (auto& attachment : attachments) {
+      isUnique = isUnique
+        && !Contains(attachment.Data.Data, attachment.Data.Size, boundary);
+    }
+    if (isUnique) {
+      return boundary;
+    }
+  }
+}
+
+void WriteMultipart(std::string& message, const std::string& boundary,
+                    const std::string& rootType, const char* data,
+                    size_t size, const Attachments& attachments)
+{
+  size_t total = size;
+  for (auto& attachment : attachments) {
+    total += attachment.Data.Size + attachment.Id.size();
+  }
+  message.reserve(message.size() + total
+                  + (attachments.size() + 2) * (boundary.size() + 80));
+
+  const auto delimiter = "--" + boundary;
+  message.append(delimiter).append(CRLF);
+  message.append("Content-Type: ").append(rootType).append(CRLF);
+  message.append(CRLF).append(data, size).append(CRLF);
+
+  for (auto& attachment : attachments) {
+    message.append(delimiter).append(CRLF);
+    message.append("Content-Type: ").append(APPLICATION_OCTET_STREAM)
+      .append(CRLF);
+    message.append("Content-ID: <").append(attachment.Id).append(">")
+      .append(CRLF);
+    message.append(CRLF).append(attachment.Data.Data, attachment.Data.Size)
+      .append(CRLF);
+  }
+  message.append(delimiter).append("--").append(CRLF);
+}
+
+Value::StringRef ReadMultipart(const std::string& message,
+                               const std::string& boundary,
+                               Attachments& attachments)
+{
+  // Each part ends with a line break and a delimiter line. The first
+  // delimiter may also start the message, without a preamble.
+  const auto delimiter = CRLF + ("--" + boundary);
+  size_t pos;
+  if (message.compare(0, delimiter.size() - 2, delimiter, 2,
+                      std::string::npos) == 0) {
+    pos = delimiter.size() - 2;
+  }
+  else {
+    pos = message.find(delimiter);
+    if (pos == std::string::npos) {
+      throw ParseErrorFault("Parse error: invalid multipart message");
+    }
+    pos += delimiter.size();
+  }
+
+  Attachments parts;
+  while (message.compare(pos, 2, "--") != 0) {
+    // The rest of the delimiter line, and then the headers of the part
+    pos = message.find(CRLF, pos);
+    if (pos == std::string::npos) {
+      throw ParseErrorFault("Parse error: invalid multipart message");
+    }
+    pos += 2;
+    std::string id;
+    size_t begin = pos + 2;
+    if (message.compare(pos, 2, CRLF) != 0) {
+      begin = message.find("\r\n\r\n", pos);
+      if (begin == std::string::npos) {
+        throw ParseErrorFault("Parse error: invalid multipart message");
+      }
+      begin += 4;
+      id = GetContentId(message, pos, begin - 2);
+    }
+
+    const size_t end = message.find(delimiter, begin);
+    if (end == std::string::npos) {
+      throw ParseErrorFault("Parse error: invalid multipart message");
+    }
+    parts.push_back({std::move(id), {message.data() + begin, end - begin}});
+    pos = end + delimiter.size();
+  }
+
+  if (parts.empty()) {
+    throw ParseErrorFault("Parse error: invalid multipart message");
+  }
+  attachments.assign(std::make_move_iterator(parts.begin() + 1),
+                     std::make_move_iterator(parts.end()));
+  return parts.front().Data;
+}
+
+Value ResolveAttachments(Value value, const Attachments& attachments,
+                         bool byReference)
+{
+  Value resolved;
+  if (attachments.empty()
+      || !Resolve(value, attachments, byReference, resolved)) {
+    return value;
+  }
+  return resolved;
+}
+
+std::unique_ptr<ParameterDecoder> CreateParameterDecoder(
+  const Dispatcher& dispatcher, const std::string& name,
+  const Attachments* attachments)
+{
+  if (!attachments) {
+    return dispatcher.CreateParameterDecoder(name);
+  }
+  auto method = dispatcher.FindMethod(name);
+  return method ? CreateParameterDecoder(*method, attachments) : nullptr;
+}
+
+std::unique_ptr<ParameterDecoder> CreateParameterDecoder(
+  const MethodWrapper& method, const Attachments* attachments)
+{
+  auto decoder = method.CreateParameterDecoder();
+  if (!attachments) {
+    return decoder;
+  }
+  if (!decoder) {
+    decoder.reset(new ValueParameterDecoder(method));
+  }
+  return std::unique_ptr<ParameterDecoder>(
+    new AttachmentDecoder(std::move(decoder), *attachments));
+}
+
+} // namespace xsonrpc
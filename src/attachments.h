@@ -0,0 +1,197 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_ATTACHMENTS_H
+#define XSONRPC_ATTACHMENTS_H
+
+#include "value.h"
+#include "writer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xsonrpc {
+
+class Dispatcher;
+class MethodWrapper;
+class ParameterDecoder;
+
+// Binary values can travel as raw parts of a multipart/related message
+// instead of inline in the body, which saves the base64 encoding of XML-RPC
+// and the escaping of JSON. The body then has a struct in their place, with
+// ATTACHMENT_NAME as only member and ATTACHMENT_PREFIX followed by the
+// Content-ID of the part as value. The ids are random for each message, so
+// a struct in the data is never taken for a reference.
+const char ATTACHMENT_NAME[] = "xsonrpc:attachment";
+const char ATTACHMENT_PREFIX[] = "cid:";
+// Smaller binary values are cheaper to write inline
+const size_t ATTACHMENT_MIN_SIZE = 1024;
+const char MULTIPART_RELATED[] = "multipart/related";
+
+struct Attachment
+{
+  std::string Id;
+  Value::StringRef Data;
+};
+
+typedef std::vector<Attachment> Attachments;
+
+// Writes through another writer, but collects large binary values as
+// attachments instead. The attachments reference the written values, which
+// must outlive the writer.
+class AttachmentWriter : public Writer
+{
+public:
+  explicit AttachmentWriter(std::unique_ptr<Writer> writer,
+                            bool collect = true);
+
+  const Attachments& GetAttachments() const { return myAttachments; }
+  // Binary values written after collection is turned off are inline
+  void SetCollect(bool collect) { myCollect = collect; }
+
+  // Writer
+  const char* GetData() override { return myWriter->GetData(); }
+  size_t GetSize() override { return myWriter->GetSize(); }
+  void ClearData() override { myWriter->ClearData(); }
+
+  void StartDocument() override { myWriter->StartDocument(); }
+  void EndDocument() override { myWriter->EndDocument(); }
+
+  void StartBatch() override { myWriter->StartBatch(); }
+  void EndBatch() override { myWriter->EndBatch(); }
+
+  void StartRequest(const std::string& methodName, const Value& id) override
+  {
+    myWriter->StartRequest(methodName, id);
+  }
+  void EndRequest() override { myWriter->EndRequest(); }
+  void StartParameter() override { myWriter->StartParameter(); }
+  void EndParameter() override { myWriter->EndParameter(); }
+
+  void StartResponse(const Value& id) override
+  {
+    myWriter->StartResponse(id);
+  }
+  void EndResponse() override { myWriter->EndResponse(); }
+  void StartFaultResponse(const Value& id) override
+  {
+    myWriter->StartFaultResponse(id);
+  }
+  void EndFaultResponse() override { myWriter->EndFaultResponse(); }
+  void WriteFault(int32_t code, const std::string& string) override
+  {
+    myWriter->WriteFault(code, string);
+  }
+
+  void StartArray() override { myWriter->StartArray(); }
+  void EndArray() override { myWriter->EndArray(); }
+  void StartStruct() override { myWriter->StartStruct(); }
+  void EndStruct() override { myWriter->EndStruct(); }
+  void StartStructElement(const std::string& name) override
+  {
+    myWriter->StartStructElement(name);
+  }
+  void StartStructElement(const char* name) override
+  {
+    myWriter->StartStructElement(name);
+  }
+  void EndStructElement() override { myWriter->EndStructElement(); }
+  void WriteArray(const int32_t* data, size_t size) override
+  {
+    myWriter->WriteArray(data, size);
+  }
+  void WriteArray(const int64_t* data, size_t size) override
+  {
+    myWriter->WriteArray(data, size);
+  }
+  void WriteArray(const double* data, size_t size) override
+  {
+    myWriter->WriteArray(data, size);
+  }
+  void WriteBinary(const char* data, size_t size) override;
+  void WriteNull() override { myWriter->WriteNull(); }
+  void Write(bool value) override { myWriter->Write(value); }
+  void Write(double value) override { myWriter->Write(value); }
+  void Write(int32_t value) override { myWriter->Write(value); }
+  void Write(int64_t value) override { myWriter->Write(value); }
+  void Write(const std::string& value) override { myWriter->Write(value); }
+  void Write(const char* data, size_t size) override
+  {
+    myWriter->Write(data, size);
+  }
+  void Write(const Value::DateTime& value) override
+  {
+    myWriter->Write(value);
+  }
+  bool WriteRaw(Value::Format format, const char* data, size_t size) override
+  {
+    return myWriter->WriteRaw(format, data, size);
+  }
+
+private:
+  std::unique_ptr<Writer> myWriter;
+  bool myCollect;
+  // Makes the ids of the attachments unique to the message
+  std::string myIdSuffix;
+  Attachments myAttachments;
+};
+
+// Content type of a multipart/related message whose root part has the
+// given type
+std::string GetMultipartContentType(const std::string& rootType,
+                                    const std::string& boundary);
+// Gets the type of the root part and the boundary from the content type of
+// a multipart/related message. Returns false for other content types.
+bool ParseMultipartContentType(const std::string& contentType,
+                               std::string& rootType, std::string& boundary);
+
+// Returns a boundary that is in neither the root part nor the attachments
+std::string CreateBoundary(const char* data, size_t size,
+                           const Attachments& attachments);
+// Appends a multipart/related message with the data as root part, followed
+// by the attachments
+void WriteMultipart(std::string& message, const std::string& boundary,
+                    const std::string& rootType, const char* data,
+                    size_t size, const Attachments& attachments);
+// Splits a multipart/related message into its root part and attachments,
+// which reference the message and get the Content-ID of their part as id.
+// Throws ParseErrorFault if it is malformed.
+Value::StringRef ReadMultipart(const std::string& message,
+                               const std::string& boundary,
+                               Attachments& attachments);
+
+// Returns the value with the attachments it references put in place. They
+// are referenced or copied, as for Reader::SetStringsByReference, while
+// arrays and structs that hold them are copied.
+Value ResolveAttachments(Value value, const Attachments& attachments,
+                         bool byReference);
+
+// As Dispatcher::CreateParameterDecoder, but if there are attachments the
+// decoder puts the ones that the parameters reference in place, as
+// references. Methods without a decoder of their own then get one that
+// builds the parameters as values.
+std::unique_ptr<ParameterDecoder> CreateParameterDecoder(
+  const Dispatcher& dispatcher, const std::string& name,
+  const Attachments* attachments);
+std::unique_ptr<ParameterDecoder> CreateParameterDecoder(
+  const MethodWrapper& method, const Attachments* attachments);
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,64 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "bufferedrequestparser.h"
+
+#include "fault.h"
+
+namespace xsonrpc {
+
+BufferedRequestParser::BufferedRequestParser(const Dispatcher& dispatcher,
+                                             ReaderFactory createReader)
+  : myDispatcher(dispatcher),
+    myCreateReader(std::move(createReader))
+{
+}
+
+void BufferedRequestParser::Parse(const char* data, size_t size)
+{
+  myData.append(data, size);
+}
+
+std::vector<Response> BufferedRequestParser::InvokeRequests()
+{
+  myReader = myCreateReader(std::move(myData));
+  myReader->SetStringsByReference(true);
+  if (myAttachments) {
+    myReader->SetAttachments(*myAttachments);
+  }
+
+  std::vector<Response> responses;
+  try {
+    auto response = myReader->InvokeRequest(myDispatcher);
+    if (!myReader->IsNotification()) {
+      responses.push_back(std::move(response));
+    }
+  }
+  catch (const Fault&) {
+    if (!myReader->IsNotification()) {
+      throw;
+    }
+  }
+  return responses;
+}
+
+bool BufferedRequestParser::IsBatch() const
+{
+  return false;
+}
+
+} // namespace xsonrpc
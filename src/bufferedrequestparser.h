@@ -0,0 +1,58 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef XSONRPC_BUFFEREDREQUESTPARSER_H
+#define XSONRPC_BUFFEREDREQUESTPARSER_H
+
+#include "bytereader.h"
+#include "requestparser.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace xsonrpc {
+
+// Collects a request in a binary format and reads it once complete, with a
+// reader from the factory, so that a notification gets no response. Not
+// even a fault gets one, if the request is known to be a notification when
+// it is found to be invalid.
+class BufferedRequestParser final : public RequestParser
+{
+public:
+  typedef std::function<std::unique_ptr<ByteReader>(std::string data)>
+    ReaderFactory;
+
+  BufferedRequestParser(const Dispatcher& dispatcher,
+                        ReaderFactory createReader);
+
+  // RequestParser
+  void Parse(const char* data, size_t size) override;
+  std::vector<Response> InvokeRequests() override;
+  bool IsBatch() const override;
+
+private:
+  const Dispatcher& myDispatcher;
+  ReaderFactory myCreateReader;
+  std::string myData;
+  // String values reference the reader's data
+  std::unique_ptr<ByteReader> myReader;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,78 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "bytereader.h"
+
+#include "fault.h"
+
+namespace xsonrpc {
+
+const size_t ByteReader::MAX_DEPTH;
+
+ByteReader::Nesting::Nesting(ByteReader& reader)
+  : myDepth(reader.myDepth)
+{
+  if (myDepth == MAX_DEPTH) {
+    throw InvalidRequestFault("Values are nested too deep");
+  }
+  ++myDepth;
+}
+
+ByteReader::Nesting::~Nesting()
+{
+  --myDepth;
+}
+
+ByteReader::ByteReader(std::string data)
+  : myData(std::move(data)),
+    myPosition(myData.data()),
+    myEnd(myData.data() + myData.size())
+{
+}
+
+void ByteReader::SetStringsByReference(bool byReference)
+{
+  myStringsByReference = byReference;
+}
+
+const char* ByteReader::ReadBytes(size_t size)
+{
+  if (size > GetBytesLeft()) {
+    throw ParseErrorFault("Parse error: unexpected end of data");
+  }
+  const char* data = myPosition;
+  myPosition += size;
+  return data;
+}
+
+bool ByteReader::ReadByte(uint8_t byte)
+{
+  if (myPosition != myEnd && static_cast<uint8_t>(*myPosition) == byte) {
+    ++myPosition;
+    return true;
+  }
+  return false;
+}
+
+void ByteReader::ReadEnd()
+{
+  if (myPosition != myEnd) {
+    throw InvalidRequestFault("Unexpected data after message");
+  }
+}
+
+} // namespace xsonrpc
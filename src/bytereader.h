@@ -0,0 +1,115 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef XSONRPC_BYTEREADER_H
+#define XSONRPC_BYTEREADER_H
+
+#include "reader.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace xsonrpc {
+
+// Base of the readers of binary formats, which read a single message in a
+// single pass
+class ByteReader : public Reader
+{
+public:
+  // How deep values can be nested, so that a message can't exhaust the
+  // stack
+  static const size_t MAX_DEPTH = 256;
+
+  explicit ByteReader(std::string data);
+
+  // True if the request that was read is a notification, which gets no
+  // response
+  bool IsNotification() const { return myIsNotification; }
+
+  // Reader
+  void SetStringsByReference(bool byReference) override;
+
+protected:
+  // Counts a value as nested while it is being read. Throws
+  // InvalidRequestFault if it is nested deeper than MAX_DEPTH.
+  class Nesting
+  {
+  public:
+    explicit Nesting(ByteReader& reader);
+    ~Nesting();
+
+    Nesting(const Nesting&) = delete;
+    Nesting& operator=(const Nesting&) = delete;
+
+  private:
+    size_t& myDepth;
+  };
+
+  // Throws ParseErrorFault if there is less data left
+  const char* ReadBytes(size_t size);
+  uint8_t ReadByte();
+  // Reads the byte and returns true if it is next
+  bool ReadByte(uint8_t byte);
+  template<typename T>
+  T ReadBigEndian();
+  template<typename T>
+  T ReadLittleEndian();
+  size_t GetBytesLeft() const { return myEnd - myPosition; }
+  // Throws InvalidRequestFault if there is data left
+  void ReadEnd();
+
+  bool myStringsByReference = false;
+  bool myIsNotification = false;
+
+private:
+  std::string myData;
+  const char* myPosition;
+  const char* myEnd;
+  size_t myDepth = 0;
+};
+
+inline uint8_t ByteReader::ReadByte()
+{
+  return static_cast<uint8_t>(*ReadBytes(1));
+}
+
+template<typename T>
+inline T ByteReader::ReadBigEndian()
+{
+  auto data = reinterpret_cast<const uint8_t*>(ReadBytes(sizeof(T)));
+  typename std::make_unsigned<T>::type bits = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bits = static_cast<decltype(bits)>((bits << 8) | data[i]);
+  }
+  return static_cast<T>(bits);
+}
+
+template<typename T>
+inline T ByteReader::ReadLittleEndian()
+{
+  auto data = reinterpret_cast<const uint8_t*>(ReadBytes(sizeof(T)));
+  typename std::make_unsigned<T>::type bits = 0;
+  for (size_t i = sizeof(T); i > 0; --i) {
+    bits = static_cast<decltype(bits)>((bits << 8) | data[i - 1]);
+  }
+  return static_cast<T>(bits);
+}
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,69 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "bytewriter.h"
+
+#include <cstring>
+
+namespace xsonrpc {
+
+const char* ByteWriter::GetData()
+{
+  return myBuffer.data();
+}
+
+size_t ByteWriter::GetSize()
+{
+  return myContainers.empty() ? myBuffer.size()
+    : myContainers.front().Offset;
+}
+
+void ByteWriter::ClearData()
+{
+  const size_t size = GetSize();
+  myBuffer.erase(0, size);
+  for (auto& container : myContainers) {
+    container.Offset -= size;
+  }
+}
+
+void ByteWriter::StartContainer(bool isMap, size_t headerSize)
+{
+  myContainers.push_back({myBuffer.size(), headerSize, 0, isMap});
+  myBuffer.append(headerSize, '\0');
+}
+
+ByteWriter::Container ByteWriter::EndContainer()
+{
+  const auto container = myContainers.back();
+  myContainers.pop_back();
+  return container;
+}
+
+void ByteWriter::WriteHeader(const Container& container, const char* header,
+                             size_t size)
+{
+  if (size < container.HeaderSize) {
+    const size_t begin = container.Offset + container.HeaderSize;
+    memmove(&myBuffer[container.Offset + size], &myBuffer[begin],
+            myBuffer.size() - begin);
+    myBuffer.resize(myBuffer.size() - (container.HeaderSize - size));
+  }
+  memcpy(&myBuffer[container.Offset], header, size);
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,121 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef XSONRPC_BYTEWRITER_H
+#define XSONRPC_BYTEWRITER_H
+
+#include "writer.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xsonrpc {
+
+// Base of the writers of binary formats. A container that starts with its
+// size gets room for the header when it starts, and the header is written
+// when it ends, so data is only available (see GetData) up to the first
+// such container that is still open.
+class ByteWriter : public Writer
+{
+public:
+  // Writer
+  const char* GetData() override;
+  size_t GetSize() override;
+  void ClearData() override;
+
+protected:
+  struct Container
+  {
+    size_t Offset;
+    // Of the room left for the header
+    size_t HeaderSize;
+    size_t Size;
+    bool IsMap;
+  };
+
+  // Counts a value as an element of the enclosing array
+  void AddElement();
+  // Counts a member of the enclosing map
+  void AddMember();
+  // Leaves room for a header of up to headerSize bytes
+  void StartContainer(bool isMap, size_t headerSize);
+  // Removes the innermost container, whose header is then written with
+  // WriteHeader
+  Container EndContainer();
+  // Writes the header of a container that has ended, moving the elements
+  // to right after it if it is shorter than the room left for it
+  void WriteHeader(const Container& container, const char* header,
+                   size_t size);
+
+  void Append(uint8_t byte);
+  template<typename T>
+  void AppendBigEndian(T value);
+  template<typename T>
+  void AppendLittleEndian(T value);
+
+  std::string myBuffer;
+
+private:
+  std::vector<Container> myContainers;
+};
+
+inline void ByteWriter::AddElement()
+{
+  if (!myContainers.empty() && !myContainers.back().IsMap) {
+    ++myContainers.back().Size;
+  }
+}
+
+inline void ByteWriter::AddMember()
+{
+  ++myContainers.back().Size;
+}
+
+inline void ByteWriter::Append(uint8_t byte)
+{
+  myBuffer += static_cast<char>(byte);
+}
+
+template<typename T>
+inline void ByteWriter::AppendBigEndian(T value)
+{
+  char data[sizeof(T)];
+  auto bits = static_cast<typename std::make_unsigned<T>::type>(value);
+  for (size_t i = sizeof(T); i > 0; --i) {
+    data[i - 1] = static_cast<char>(bits & 0xff);
+    bits = static_cast<decltype(bits)>(bits >> 8);
+  }
+  myBuffer.append(data, sizeof(T));
+}
+
+template<typename T>
+inline void ByteWriter::AppendLittleEndian(T value)
+{
+  char data[sizeof(T)];
+  auto bits = static_cast<typename std::make_unsigned<T>::type>(value);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    data[i] = static_cast<char>(bits & 0xff);
+    bits = static_cast<decltype(bits)>(bits >> 8);
+  }
+  myBuffer.append(data, sizeof(T));
+}
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,73 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_CBOR_H
+#define XSONRPC_CBOR_H
+
+#include <cstdint>
+
+namespace xsonrpc {
+namespace cbor {
+
+// Messages are arrays as in MessagePack-RPC: a request is [REQUEST, id,
+// method, params], a response [RESPONSE, id, error, result] and a
+// notification [NOTIFICATION, method, params]
+const uint8_t REQUEST = 0;
+const uint8_t RESPONSE = 1;
+const uint8_t NOTIFICATION = 2;
+
+const char ERROR_CODE_NAME[] = "code";
+const char ERROR_MESSAGE_NAME[] = "message";
+
+// Major types, in the high three bits of the initial byte
+const uint8_t UNSIGNED_INTEGER = 0 << 5;
+const uint8_t NEGATIVE_INTEGER = 1 << 5;
+const uint8_t BYTE_STRING = 2 << 5;
+const uint8_t TEXT_STRING = 3 << 5;
+const uint8_t ARRAY = 4 << 5;
+const uint8_t MAP = 5 << 5;
+const uint8_t TAG = 6 << 5;
+const uint8_t SIMPLE = 7 << 5;
+const uint8_t MAJOR_TYPE_MASK = 0xe0;
+
+// Additional information, in the low five bits. Smaller values are the
+// argument itself.
+const uint8_t ARGUMENT_MAX = 23;
+const uint8_t ARGUMENT_8 = 24;
+const uint8_t ARGUMENT_16 = 25;
+const uint8_t ARGUMENT_32 = 26;
+const uint8_t ARGUMENT_64 = 27;
+const uint8_t INDEFINITE = 31;
+const uint8_t ADDITIONAL_MASK = 0x1f;
+
+const uint8_t FALSE_VALUE = SIMPLE | 20;
+const uint8_t TRUE_VALUE = SIMPLE | 21;
+const uint8_t NULL_VALUE = SIMPLE | 22;
+const uint8_t UNDEFINED_VALUE = SIMPLE | 23;
+const uint8_t HALF_FLOAT = SIMPLE | ARGUMENT_16;
+const uint8_t SINGLE_FLOAT = SIMPLE | ARGUMENT_32;
+const uint8_t DOUBLE_FLOAT = SIMPLE | ARGUMENT_64;
+const uint8_t BREAK = SIMPLE | INDEFINITE;
+
+// Tag of a date/time as seconds since 1970-01-01T00:00:00 UTC
+const uint64_t EPOCH_DATE_TIME_TAG = 1;
+
+} // namespace cbor
+} // namespace xsonrpc
+
+#endif
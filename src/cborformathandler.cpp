@@ -0,0 +1,77 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "cborformathandler.h"
+
+#include "bufferedrequestparser.h"
+#include "cborreader.h"
+#include "cborwriter.h"
+
+namespace {
+
+const char APPLICATION_CBOR[] = "application/cbor";
+
+} // namespace
+
+namespace xsonrpc {
+
+CborFormatHandler::CborFormatHandler(std::string requestPath)
+  : myRequestPath(std::move(requestPath))
+{
+}
+
+bool CborFormatHandler::CanHandleRequest(
+  const std::string& path, const std::string& contentType)
+{
+  return path == myRequestPath
+    && contentType == APPLICATION_CBOR;
+}
+
+std::string CborFormatHandler::GetContentType()
+{
+  return APPLICATION_CBOR;
+}
+
+bool CborFormatHandler::UsesId()
+{
+  return true;
+}
+
+std::unique_ptr<Reader> CborFormatHandler::CreateReader(std::string data)
+{
+  return std::unique_ptr<Reader>(new CborReader(std::move(data)));
+}
+
+std::unique_ptr<RequestParser> CborFormatHandler::CreateRequestParser(
+  const Dispatcher& dispatcher)
+{
+  return std::unique_ptr<RequestParser>(new BufferedRequestParser(
+    dispatcher,
+    [] (std::string data)
+    {
+      return std::unique_ptr<ByteReader>(
+        new CborReader(std::move(data)));
+    }));
+}
+
+std::unique_ptr<Writer> CborFormatHandler::CreateWriter()
+{
+  return std::unique_ptr<Writer>(new CborWriter());
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,456 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "cborreader.h"
+
+#include "cbor.h"
+#include "fault.h"
+#include "request.h"
+#include "response.h"
+#include "value.h"
+#include "valuehandler.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const uint64_t INT32_MAX_ARGUMENT = std::numeric_limits<int32_t>::max();
+const uint64_t INT64_MAX_ARGUMENT = std::numeric_limits<int64_t>::max();
+
+} // namespace
+
+namespace xsonrpc {
+
+using namespace cbor;
+
+CborReader::CborReader(std::string data)
+  : ByteReader(std::move(data))
+{
+}
+
+Request CborReader::GetRequest()
+{
+  Value id;
+  auto name = ReadMethodName(id);
+  Request::Parameters parameters;
+  ReadParameters([&] { parameters.emplace_back(ReadValue()); });
+  return Request(std::move(name), std::move(parameters), std::move(id));
+}
+
+Response CborReader::GetResponse()
+{
+  if (ReadArraySize("Response is not an array") != 4
+      || ReadByte() != (UNSIGNED_INTEGER | RESPONSE)) {
+    throw InvalidRequestFault("Invalid response");
+  }
+
+  auto id = ReadValue();
+  auto error = ReadValue();
+  auto result = ReadValue();
+  ReadEnd();
+
+  if (error.IsNil()) {
+    return Response(std::move(result), std::move(id));
+  }
+
+  if (!error.IsStruct()) {
+    throw InvalidRequestFault("Response error is not a map");
+  }
+  auto& s = error.AsStruct();
+  auto code = s.find(ERROR_CODE_NAME);
+  if (code == s.end() || !code->second.IsInteger32()) {
+    throw InvalidRequestFault("Missing or invalid response error code");
+  }
+  auto message = s.find(ERROR_MESSAGE_NAME);
+  if (message == s.end() || !message->second.IsString()) {
+    throw InvalidRequestFault("Missing or invalid response error message");
+  }
+  return Response(code->second.AsInteger32(), message->second.AsString(),
+                  std::move(id));
+}
+
+Value CborReader::GetValue()
+{
+  auto value = ReadValue();
+  ReadEnd();
+  return value;
+}
+
+Response CborReader::InvokeRequest(const Dispatcher& dispatcher)
+{
+  Value id;
+  auto name = ReadMethodName(id);
+
+  auto decoder = CreateParameterDecoder(dispatcher, name, myAttachments);
+  if (!decoder) {
+    Request::Parameters parameters;
+    ReadParameters([&] { parameters.emplace_back(ReadValue()); });
+    return dispatcher.Invoke(name, parameters, id);
+  }
+
+  ReadParameters(
+    [&] ()
+    {
+      decoder->StartParameter();
+      ReadValue(*decoder);
+      decoder->EndParameter();
+    });
+  return dispatcher.Invoke(*decoder, id);
+}
+
+std::string CborReader::ReadMethodName(Value& id)
+{
+  const auto size = ReadArraySize("Request is not an array");
+  const auto type = ReadByte();
+  if (size == 4 && type == (UNSIGNED_INTEGER | REQUEST)) {
+    id = ReadValue();
+    if (!id.IsInteger32() && !id.IsInteger64() && !id.IsString()
+        && !id.IsNil()) {
+      throw InvalidRequestFault("Invalid request id");
+    }
+  }
+  else if (size == 3 && type == (UNSIGNED_INTEGER | NOTIFICATION)) {
+    myIsNotification = true;
+    id = false;
+  }
+  else {
+    throw InvalidRequestFault("Invalid message type");
+  }
+
+  const char* data;
+  size_t length;
+  if (!ReadText(data, length) || length == 0) {
+    throw InvalidRequestFault("Missing method name");
+  }
+  return std::string(data, length);
+}
+
+template<typename Function>
+void CborReader::ReadParameters(Function readParameter)
+{
+  const auto initial = ReadByte();
+  const uint8_t additional = initial & ADDITIONAL_MASK;
+  if ((initial & MAJOR_TYPE_MASK) != ARRAY) {
+    throw InvalidRequestFault("Params is not an array");
+  }
+
+  if (additional == INDEFINITE) {
+    while (!ReadBreak()) {
+      readParameter();
+    }
+  }
+  else {
+    for (auto size = ReadSize(additional); size > 0; --size) {
+      readParameter();
+    }
+  }
+  ReadEnd();
+}
+
+void CborReader::ReadValue(ValueHandler& handler)
+{
+  // Also counts each tag of a chain, as a tagged item is read as a value
+  Nesting nesting(*this);
+  const auto initial = ReadByte();
+  const uint8_t additional = initial & ADDITIONAL_MASK;
+
+  switch (initial & MAJOR_TYPE_MASK) {
+    case UNSIGNED_INTEGER: {
+      // A 64-bit argument is read as a 64-bit integer, so that it is kept
+      // as such in a round trip, see CborWriter::Pack
+      const auto value = ReadArgument(additional);
+      if (value <= INT32_MAX_ARGUMENT && additional != ARGUMENT_64) {
+        handler.Integer32(static_cast<int32_t>(value));
+      }
+      else if (value <= INT64_MAX_ARGUMENT) {
+        handler.Integer64(static_cast<int64_t>(value));
+      }
+      else {
+        handler.Double(static_cast<double>(value));
+      }
+      break;
+    }
+    case NEGATIVE_INTEGER: {
+      const auto value = ReadArgument(additional);
+      if (value <= INT32_MAX_ARGUMENT && additional != ARGUMENT_64) {
+        handler.Integer32(-1 - static_cast<int32_t>(value));
+      }
+      else if (value <= INT64_MAX_ARGUMENT) {
+        handler.Integer64(-1 - static_cast<int64_t>(value));
+      }
+      else {
+        handler.Double(-1 - static_cast<double>(value));
+      }
+      break;
+    }
+
+    case BYTE_STRING: {
+      const char* data;
+      size_t size;
+      ReadString(BYTE_STRING, additional, data, size);
+      handler.Binary(data, size);
+      break;
+    }
+    case TEXT_STRING: {
+      const char* data;
+      size_t size;
+      ReadString(TEXT_STRING, additional, data, size);
+      handler.String(data, size);
+      break;
+    }
+
+    case ARRAY:
+      ReadArray(handler, additional);
+      break;
+    case MAP:
+      ReadMap(handler, additional);
+      break;
+    case TAG:
+      ReadTag(handler, ReadArgument(additional));
+      break;
+    default:
+      ReadSimple(handler, additional);
+      break;
+  }
+}
+
+Value CborReader::ReadValue()
+{
+  ValueBuilder builder(myStringsByReference);
+  ReadValue(builder);
+  return std::move(builder.GetValue());
+}
+
+void CborReader::ReadArray(ValueHandler& handler, uint8_t additional)
+{
+  const bool indefinite = additional == INDEFINITE;
+  size_t size = indefinite ? 0 : ReadSize(additional);
+
+  handler.StartArray();
+  while (indefinite ? !ReadBreak() : size-- > 0) {
+    ReadValue(handler);
+  }
+  handler.EndArray();
+}
+
+void CborReader::ReadMap(ValueHandler& handler, uint8_t additional)
+{
+  const bool indefinite = additional == INDEFINITE;
+  size_t size = indefinite ? 0 : ReadSize(additional);
+  if (size > GetBytesLeft() / 2) {
+    throw ParseErrorFault("Parse error: unexpected end of data");
+  }
+
+  handler.StartStruct();
+  while (indefinite ? !ReadBreak() : size-- > 0) {
+    const char* name;
+    size_t length;
+    if (!ReadText(name, length)) {
+      throw InvalidRequestFault("Map key is not a text string");
+    }
+    handler.StartStructElement(name, length);
+    ReadValue(handler);
+  }
+  handler.EndStruct();
+}
+
+void CborReader::ReadTag(ValueHandler& handler, uint64_t tag)
+{
+  // Other tags, e.g. for bignums, are not supported, so the item is read
+  // as if it wasn't tagged
+  if (tag != EPOCH_DATE_TIME_TAG) {
+    ReadValue(handler);
+    return;
+  }
+
+  const auto initial = ReadByte();
+  const uint8_t additional = initial & ADDITIONAL_MASK;
+  int64_t seconds;
+  switch (initial & MAJOR_TYPE_MASK) {
+    case UNSIGNED_INTEGER:
+    case NEGATIVE_INTEGER: {
+      const auto value = ReadArgument(additional);
+      if (value > INT64_MAX_ARGUMENT) {
+        throw InvalidRequestFault("Invalid date/time");
+      }
+      seconds = (initial & MAJOR_TYPE_MASK) == UNSIGNED_INTEGER
+        ? static_cast<int64_t>(value) : -1 - static_cast<int64_t>(value);
+      break;
+    }
+    case SIMPLE:
+      if (additional >= ARGUMENT_16 && additional <= ARGUMENT_64) {
+        // Fractions of a second are dropped, as a date/time has seconds
+        const auto value = std::floor(ReadFloat(additional));
+        if (value >= -9223372036854775808.0
+            && value < 9223372036854775808.0) {
+          seconds = static_cast<int64_t>(value);
+          break;
+        }
+      }
+      throw InvalidRequestFault("Invalid date/time");
+    default:
+      throw InvalidRequestFault("Invalid date/time");
+  }
+  handler.DateTime(Value::DateTime(seconds));
+}
+
+void CborReader::ReadSimple(ValueHandler& handler, uint8_t additional)
+{
+  switch (SIMPLE | additional) {
+    case FALSE_VALUE:
+      handler.Boolean(false);
+      break;
+    case TRUE_VALUE:
+      handler.Boolean(true);
+      break;
+    case NULL_VALUE:
+    case UNDEFINED_VALUE:
+      handler.Nil();
+      break;
+    case HALF_FLOAT:
+    case SINGLE_FLOAT:
+    case DOUBLE_FLOAT:
+      handler.Double(ReadFloat(additional));
+      break;
+    case BREAK:
+      throw InvalidRequestFault("Unexpected break");
+    default:
+      throw InvalidRequestFault("Invalid type");
+  }
+}
+
+double CborReader::ReadFloat(uint8_t additional)
+{
+  if (additional == ARGUMENT_16) {
+    // See RFC 8949, appendix D
+    const auto half = ReadBigEndian<uint16_t>();
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0) {
+      value = std::ldexp(mantissa, -24);
+    }
+    else if (exponent != 31) {
+      value = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    else if (mantissa == 0) {
+      value = std::numeric_limits<double>::infinity();
+    }
+    else {
+      value = std::numeric_limits<double>::quiet_NaN();
+    }
+    return (half & 0x8000) ? -value : value;
+  }
+  else if (additional == ARGUMENT_32) {
+    auto bits = ReadBigEndian<uint32_t>();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  auto bits = ReadBigEndian<uint64_t>();
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void CborReader::ReadString(uint8_t majorType, uint8_t additional,
+                            const char*& data, size_t& size)
+{
+  if (additional != INDEFINITE) {
+    size = ReadSize(additional);
+    data = ReadBytes(size);
+    return;
+  }
+
+  // The chunks are definite strings of the same major type
+  std::string joined;
+  while (!ReadBreak()) {
+    const auto initial = ReadByte();
+    const uint8_t chunkAdditional = initial & ADDITIONAL_MASK;
+    if ((initial & MAJOR_TYPE_MASK) != majorType
+        || chunkAdditional == INDEFINITE) {
+      throw InvalidRequestFault("Invalid string chunk");
+    }
+    const auto chunkSize = ReadSize(chunkAdditional);
+    joined.append(ReadBytes(chunkSize), chunkSize);
+  }
+  myStrings.push_back(std::move(joined));
+  data = myStrings.back().data();
+  size = myStrings.back().size();
+}
+
+bool CborReader::ReadText(const char*& data, size_t& size)
+{
+  const auto initial = ReadByte();
+  if ((initial & MAJOR_TYPE_MASK) != TEXT_STRING) {
+    return false;
+  }
+  ReadString(TEXT_STRING, initial & ADDITIONAL_MASK, data, size);
+  return true;
+}
+
+size_t CborReader::ReadArraySize(const char* error)
+{
+  const auto initial = ReadByte();
+  const uint8_t additional = initial & ADDITIONAL_MASK;
+  if ((initial & MAJOR_TYPE_MASK) != ARRAY || additional == INDEFINITE) {
+    throw InvalidRequestFault(error);
+  }
+  return ReadSize(additional);
+}
+
+size_t CborReader::ReadSize(uint8_t additional)
+{
+  // Each byte or element takes at least a byte, so a size larger than the
+  // data left is rejected before anything is read
+  const auto size = ReadArgument(additional);
+  if (size > GetBytesLeft()) {
+    throw ParseErrorFault("Parse error: unexpected end of data");
+  }
+  return static_cast<size_t>(size);
+}
+
+uint64_t CborReader::ReadArgument(uint8_t additional)
+{
+  if (additional <= ARGUMENT_MAX) {
+    return additional;
+  }
+
+  switch (additional) {
+    case ARGUMENT_8:
+      return ReadBigEndian<uint8_t>();
+    case ARGUMENT_16:
+      return ReadBigEndian<uint16_t>();
+    case ARGUMENT_32:
+      return ReadBigEndian<uint32_t>();
+    case ARGUMENT_64:
+      return ReadBigEndian<uint64_t>();
+    default:
+      throw InvalidRequestFault("Invalid additional information");
+  }
+}
+
+bool CborReader::ReadBreak()
+{
+  return ReadByte(BREAK);
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,80 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_CBORREADER_H
+#define XSONRPC_CBORREADER_H
+
+#include "bytereader.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace xsonrpc {
+
+class ValueHandler;
+
+// Reads CBOR messages, see cbor.h, in a single pass, so only one of
+// GetRequest, GetResponse, GetValue and InvokeRequest can be called. Both
+// definite and indefinite lengths are accepted.
+class CborReader final : public ByteReader
+{
+public:
+  explicit CborReader(std::string data);
+
+  // Reader
+  Request GetRequest() override;
+  Response GetResponse() override;
+  Value GetValue() override;
+  Response InvokeRequest(const Dispatcher& dispatcher) override;
+
+private:
+  std::string ReadMethodName(Value& id);
+  template<typename Function>
+  void ReadParameters(Function readParameter);
+  void ReadValue(ValueHandler& handler);
+  Value ReadValue();
+  void ReadArray(ValueHandler& handler, uint8_t additional);
+  void ReadMap(ValueHandler& handler, uint8_t additional);
+  void ReadTag(ValueHandler& handler, uint64_t tag);
+  void ReadSimple(ValueHandler& handler, uint8_t additional);
+  double ReadFloat(uint8_t additional);
+  // Reads the rest of a string of the major type, joining the chunks of an
+  // indefinite one
+  void ReadString(uint8_t majorType, uint8_t additional, const char*& data,
+                  size_t& size);
+  // Reads a text string, or returns false if it is something else
+  bool ReadText(const char*& data, size_t& size);
+  // Reads the size of a definite array, throwing InvalidRequestFault with
+  // the error if it is something else
+  size_t ReadArraySize(const char* error);
+  // Reads the size of a string or container. Throws ParseErrorFault if
+  // there are fewer bytes left.
+  size_t ReadSize(uint8_t additional);
+  uint64_t ReadArgument(uint8_t additional);
+  // Reads the break that ends an indefinite item, or returns false if
+  // there is none
+  bool ReadBreak();
+
+  // Indefinite strings, joined
+  std::deque<std::string> myStrings;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,328 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "cborwriter.h"
+
+#include "cbor.h"
+#include "value.h"
+#include "valueserializer.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace xsonrpc {
+
+using namespace cbor;
+
+void CborWriter::AppendHeader(uint8_t majorType, uint64_t argument)
+{
+  if (argument <= ARGUMENT_MAX) {
+    Append(static_cast<uint8_t>(majorType | argument));
+  }
+  else if (argument <= std::numeric_limits<uint8_t>::max()) {
+    Append(majorType | ARGUMENT_8);
+    AppendBigEndian(static_cast<uint8_t>(argument));
+  }
+  else if (argument <= std::numeric_limits<uint16_t>::max()) {
+    Append(majorType | ARGUMENT_16);
+    AppendBigEndian(static_cast<uint16_t>(argument));
+  }
+  else if (argument <= std::numeric_limits<uint32_t>::max()) {
+    Append(majorType | ARGUMENT_32);
+    AppendBigEndian(static_cast<uint32_t>(argument));
+  }
+  else {
+    Append(majorType | ARGUMENT_64);
+    AppendBigEndian(argument);
+  }
+}
+
+void CborWriter::StartContainer(bool isMap)
+{
+  Append((isMap ? MAP : ARRAY) | INDEFINITE);
+}
+
+void CborWriter::EndContainer()
+{
+  Append(BREAK);
+}
+
+void CborWriter::WriteId(const Value& id)
+{
+  if (id.IsInteger32()) {
+    Pack(id.AsInteger32());
+  }
+  else if (id.IsInteger64()) {
+    Pack(id.AsInteger64());
+  }
+  else if (id.IsString()) {
+    PackString(TEXT_STRING, id.AsString().data(), id.AsString().size());
+  }
+  else {
+    Append(NULL_VALUE);
+  }
+}
+
+void CborWriter::Pack(double value)
+{
+  uint64_t bits;
+  static_assert(sizeof(bits) == sizeof(value), "double is not 64 bits");
+  memcpy(&bits, &value, sizeof(bits));
+  Append(DOUBLE_FLOAT);
+  AppendBigEndian(bits);
+}
+
+void CborWriter::Pack(int32_t value)
+{
+  if (value >= 0) {
+    AppendHeader(UNSIGNED_INTEGER, static_cast<uint64_t>(value));
+  }
+  else {
+    AppendHeader(NEGATIVE_INTEGER, static_cast<uint64_t>(-1 - value));
+  }
+}
+
+void CborWriter::Pack(int64_t value)
+{
+  // Always with a 64-bit argument, so that the value is read back as a
+  // 64-bit integer
+  if (value >= 0) {
+    Append(UNSIGNED_INTEGER | ARGUMENT_64);
+    AppendBigEndian(static_cast<uint64_t>(value));
+  }
+  else {
+    Append(NEGATIVE_INTEGER | ARGUMENT_64);
+    AppendBigEndian(static_cast<uint64_t>(-1 - value));
+  }
+}
+
+void CborWriter::PackString(uint8_t majorType, const char* data,
+                            size_t size)
+{
+  AppendHeader(majorType, size);
+  myBuffer.append(data, size);
+}
+
+void CborWriter::StartDocument()
+{
+  // Empty
+}
+
+void CborWriter::EndDocument()
+{
+  // Empty
+}
+
+void CborWriter::StartBatch()
+{
+  throw std::logic_error("cbor: batches are not supported");
+}
+
+void CborWriter::EndBatch()
+{
+  throw std::logic_error("cbor: batches are not supported");
+}
+
+void CborWriter::StartRequest(const std::string& methodName,
+                              const Value& id)
+{
+  // A request without id is a notification, see Client::Notify
+  if (id.IsBoolean()) {
+    Append(ARRAY | 3);
+    Append(UNSIGNED_INTEGER | NOTIFICATION);
+  }
+  else {
+    Append(ARRAY | 4);
+    Append(UNSIGNED_INTEGER | REQUEST);
+    WriteId(id);
+  }
+  PackString(TEXT_STRING, methodName.data(), methodName.size());
+  StartContainer(false);
+}
+
+void CborWriter::EndRequest()
+{
+  EndContainer();
+}
+
+void CborWriter::StartParameter()
+{
+  // Empty
+}
+
+void CborWriter::EndParameter()
+{
+  // Empty
+}
+
+void CborWriter::StartResponse(const Value& id)
+{
+  Append(ARRAY | 4);
+  Append(UNSIGNED_INTEGER | RESPONSE);
+  WriteId(id);
+  // No error
+  Append(NULL_VALUE);
+}
+
+void CborWriter::EndResponse()
+{
+  // Empty
+}
+
+void CborWriter::StartFaultResponse(const Value& id)
+{
+  Append(ARRAY | 4);
+  Append(UNSIGNED_INTEGER | RESPONSE);
+  WriteId(id);
+}
+
+void CborWriter::EndFaultResponse()
+{
+  // No result
+  Append(NULL_VALUE);
+}
+
+void CborWriter::WriteFault(int32_t code, const std::string& string)
+{
+  Append(MAP | 2);
+  PackString(TEXT_STRING, ERROR_CODE_NAME, sizeof(ERROR_CODE_NAME) - 1);
+  Pack(code);
+  PackString(TEXT_STRING, ERROR_MESSAGE_NAME,
+             sizeof(ERROR_MESSAGE_NAME) - 1);
+  PackString(TEXT_STRING, string.data(), string.size());
+}
+
+void CborWriter::StartArray()
+{
+  StartContainer(false);
+}
+
+void CborWriter::EndArray()
+{
+  EndContainer();
+}
+
+void CborWriter::StartStruct()
+{
+  StartContainer(true);
+}
+
+void CborWriter::EndStruct()
+{
+  EndContainer();
+}
+
+void CborWriter::StartStructElement(const std::string& name)
+{
+  PackString(TEXT_STRING, name.data(), name.size());
+}
+
+void CborWriter::StartStructElement(const char* name)
+{
+  PackString(TEXT_STRING, name, strlen(name));
+}
+
+void CborWriter::EndStructElement()
+{
+  // Empty
+}
+
+void CborWriter::WriteArray(const int32_t* data, size_t size)
+{
+  AppendHeader(ARRAY, size);
+  for (size_t i = 0; i < size; ++i) {
+    Pack(data[i]);
+  }
+}
+
+void CborWriter::WriteArray(const int64_t* data, size_t size)
+{
+  AppendHeader(ARRAY, size);
+  for (size_t i = 0; i < size; ++i) {
+    Pack(data[i]);
+  }
+}
+
+void CborWriter::WriteArray(const double* data, size_t size)
+{
+  AppendHeader(ARRAY, size);
+  for (size_t i = 0; i < size; ++i) {
+    Pack(data[i]);
+  }
+}
+
+void CborWriter::WriteBinary(const char* data, size_t size)
+{
+  PackString(BYTE_STRING, data, size);
+}
+
+void CborWriter::WriteNull()
+{
+  Append(NULL_VALUE);
+}
+
+void CborWriter::Write(bool value)
+{
+  Append(value ? TRUE_VALUE : FALSE_VALUE);
+}
+
+void CborWriter::Write(double value)
+{
+  Pack(value);
+}
+
+void CborWriter::Write(int32_t value)
+{
+  Pack(value);
+}
+
+void CborWriter::Write(int64_t value)
+{
+  Pack(value);
+}
+
+void CborWriter::Write(const std::string& value)
+{
+  Write(value.data(), value.size());
+}
+
+void CborWriter::Write(const char* data, size_t size)
+{
+  PackString(TEXT_STRING, data, size);
+}
+
+void CborWriter::Write(const Value::DateTime& value)
+{
+  // Tagged seconds since the epoch, taking the date/time to be in UTC
+  AppendHeader(TAG, EPOCH_DATE_TIME_TAG);
+  const auto seconds = value.GetSecondsSinceEpoch();
+  if (seconds >= 0) {
+    AppendHeader(UNSIGNED_INTEGER, static_cast<uint64_t>(seconds));
+  }
+  else {
+    AppendHeader(NEGATIVE_INTEGER, static_cast<uint64_t>(-1 - seconds));
+  }
+}
+
+void CborWriter::WriteValue(const Value& value)
+{
+  SerializeValue(value, *this);
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,85 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_CBORWRITER_H
+#define XSONRPC_CBORWRITER_H
+
+#include "bytewriter.h"
+
+#include <string>
+
+namespace xsonrpc {
+
+// Writes CBOR (RFC 8949) messages, see cbor.h. Arrays and maps are given
+// an indefinite length, so that all data is available (see GetData) as it
+// is written, also while a generated array is written (see
+// ResponseStream). Packed arrays have a definite length.
+class CborWriter final : public ByteWriter
+{
+public:
+  // Writer
+  void StartDocument() override;
+  void EndDocument() override;
+  void StartBatch() override;
+  void EndBatch() override;
+  void StartRequest(const std::string& methodName, const Value& id) override;
+  void EndRequest() override;
+  void StartParameter() override;
+  void EndParameter() override;
+  void StartResponse(const Value& id) override;
+  void EndResponse() override;
+  void StartFaultResponse(const Value& id) override;
+  void EndFaultResponse() override;
+  void WriteFault(int32_t code, const std::string& string) override;
+  void StartArray() override;
+  void EndArray() override;
+  void StartStruct() override;
+  void EndStruct() override;
+  void StartStructElement(const std::string& name) override;
+  void StartStructElement(const char* name) override;
+  void EndStructElement() override;
+  void WriteArray(const int32_t* data, size_t size) override;
+  void WriteArray(const int64_t* data, size_t size) override;
+  void WriteArray(const double* data, size_t size) override;
+  void WriteBinary(const char* data, size_t size) override;
+  void WriteNull() override;
+  void Write(bool value) override;
+  void Write(double value) override;
+  void Write(int32_t value) override;
+  void Write(int64_t value) override;
+  void Write(const std::string& value) override;
+  void Write(const char* data, size_t size) override;
+  void Write(const Value::DateTime& value) override;
+  void WriteValue(const Value& value) override;
+
+private:
+  void StartContainer(bool isMap);
+  void EndContainer();
+  void WriteId(const Value& id);
+  // Write without counting the value as an element
+  void Pack(double value);
+  void Pack(int32_t value);
+  void Pack(int64_t value);
+  void PackString(uint8_t majorType, const char* data, size_t size);
+  // The initial byte and the argument in as few bytes as possible
+  void AppendHeader(uint8_t majorType, uint64_t argument);
+};
+
+} // namespace xsonrpc
+
+#endif
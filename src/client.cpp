@@ -17,6 +17,7 @@
 
 #include "client.h"
 
+#include "attachments.h"
 #include "fault.h"
 #include "formathandler.h"
 #include "reader.h"
@@ -25,11 +26,20 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 
 namespace {
 
+const char SYSTEM_GETCAPABILITIES[] = "system.getCapabilities";
+
+// Content type negotiated per URL and set of format handlers, see
+// Client::SetFormatHandlers
+std::map<std::string, std::string> NegotiatedFormats;
+std::mutex NegotiatedFormatsMutex;
+
 size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
 {
   std::string* buffer = static_cast<std::string*>(userdata);
@@ -41,6 +51,16 @@ size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
 
 namespace xsonrpc {
 
+size_t Batch::AddInternal(const std::string& methodName,
+                          const Request::Parameters& params)
+{
+  // The index is used as id, to match responses to calls
+  const auto index = myRequests.size();
+  myRequests.emplace_back(methodName, params,
+                          static_cast<int32_t>(index));
+  return index;
+}
+
 void Client::GlobalInit()
 {
   if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
@@ -51,7 +71,8 @@ void Client::GlobalInit()
 Client::Client(const std::string& host, unsigned short port,
                FormatHandler& formatHandler,
                const std::string& uri)
-  : myFormatHandler(formatHandler),
+  : myFormatHandler(&formatHandler),
+    myUrl("http://" + host + ":" + std::to_string(port) + uri),
     myHandle(curl_easy_init()),
     myId(0)
 {
@@ -61,8 +82,7 @@ Client::Client(const std::string& host, unsigned short port,
   curl_easy_setopt(myHandle, CURLOPT_FOLLOWLOCATION, 1L);
   curl_easy_setopt(myHandle, CURLOPT_MAXREDIRS, 20L);
 
-  std::string url = "http://" + host + ":" + std::to_string(port) + uri;
-  curl_easy_setopt(myHandle, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(myHandle, CURLOPT_URL, myUrl.c_str());
 
   curl_easy_setopt(myHandle, CURLOPT_USERAGENT, "xsonrpc/" XSONRPC_VERSION);
   curl_easy_setopt(myHandle, CURLOPT_WRITEFUNCTION, &WriteCallback);
@@ -73,21 +93,207 @@ Client::~Client()
   curl_easy_cleanup(myHandle);
 }
 
+void Client::SetFormatHandlers(std::vector<FormatHandler*> formatHandlers)
+{
+  myFormatHandlers = std::move(formatHandlers);
+}
+
 Value Client::CallInternal(const std::string& methodName,
                            const Request::Parameters& params)
 {
-  auto writer = myFormatHandler.CreateWriter();
+  auto& formatHandler = GetFormatHandler();
+  AttachmentWriter writer(formatHandler.CreateWriter(), myAttachments);
   const auto id = myId++;
-  Request::Write(methodName, params, id, *writer);
+  Request::Write(methodName, params, id, writer);
+
+  std::string message;
+  Attachments attachments;
+  auto reader = formatHandler.CreateReader(
+    Post(writer, message, attachments));
+  Response response = reader->GetResponse();
+  if (formatHandler.UsesId()
+      && (!response.GetId().IsInteger32()
+          || response.GetId().AsInteger32() != id)) {
+    throw InvalidRequestFault();
+  }
+  response.ThrowIfFault();
+  return ResolveAttachments(
+    std::move(response.GetResult()), attachments, false);
+}
+
+void Client::NotifyInternal(const std::string& methodName,
+                             const Request::Parameters& params)
+{
+  // A request without id is a notification, which the server does not
+  // reply to. Formats without ids reply anyway, but the reply is ignored.
+  AttachmentWriter writer(GetFormatHandler().CreateWriter(), myAttachments);
+  Request::Write(methodName, params, false, writer);
+  std::string message;
+  Attachments attachments;
+  Post(writer, message, attachments);
+}
+
+std::vector<Response> Client::CallBatch(const Batch& batch)
+{
+  auto& requests = batch.GetRequests();
+  if (requests.empty()) {
+    return {};
+  }
+
+  auto& formatHandler = GetFormatHandler();
+  AttachmentWriter writer(formatHandler.CreateWriter(), myAttachments);
+  Request::WriteBatch(requests, writer);
+
+  std::string message;
+  Attachments attachments;
+  auto reader = formatHandler.CreateReader(
+    Post(writer, message, attachments));
+  auto received = reader->GetBatchResponse();
+
+  // The responses may be in any order, so they are matched by id
+  std::vector<Response*> matched(requests.size(), nullptr);
+  for (auto& response : received) {
+    auto& id = response.GetId();
+    if (id.IsInteger32() && id.AsInteger32() >= 0
+        && static_cast<size_t>(id.AsInteger32()) < matched.size()
+        && !matched[id.AsInteger32()]) {
+      response.GetResult() = ResolveAttachments(
+        std::move(response.GetResult()), attachments, false);
+      matched[id.AsInteger32()] = &response;
+    }
+    else {
+      // A fault without a matching id is for the batch itself
+      response.ThrowIfFault();
+      throw InvalidRequestFault();
+    }
+  }
+
+  std::vector<Response> responses;
+  responses.reserve(matched.size());
+  for (auto response : matched) {
+    if (!response) {
+      throw InvalidRequestFault();
+    }
+    responses.push_back(std::move(*response));
+  }
+  return responses;
+}
+
+FormatHandler& Client::GetFormatHandler()
+{
+  if (!myFormatHandlers.empty()) {
+    // Cleared first, as the query itself is a call
+    auto formatHandlers = std::move(myFormatHandlers);
+    myFormatHandlers.clear();
+    try {
+      NegotiateFormat(formatHandlers);
+    }
+    catch (...) {
+      // Tried again on the next call
+      myFormatHandlers = std::move(formatHandlers);
+      throw;
+    }
+  }
+  return *myFormatHandler;
+}
+
+void Client::NegotiateFormat(std::vector<FormatHandler*>& formatHandlers)
+{
+  // The handler given to the constructor is tried first, as the one known
+  // to work, and is also the fallback
+  std::vector<FormatHandler*> candidates{myFormatHandler};
+  candidates.insert(candidates.end(),
+                    formatHandlers.begin(), formatHandlers.end());
+  std::string key = myUrl;
+  for (auto formatHandler : candidates) {
+    key += '\n' + formatHandler->GetContentType();
+  }
+
+  std::string contentType;
+  {
+    std::lock_guard<std::mutex> lock(NegotiatedFormatsMutex);
+    auto it = NegotiatedFormats.find(key);
+    if (it != NegotiatedFormats.end()) {
+      contentType = it->second;
+    }
+  }
 
-  curl_easy_setopt(myHandle, CURLOPT_POSTFIELDSIZE_LARGE,
-                   static_cast<curl_off_t>(writer->GetSize()));
-  curl_easy_setopt(myHandle, CURLOPT_POSTFIELDS, writer->GetData());
+  if (contentType.empty()) {
+    // The query is sent in each format until the server reads one
+    auto original = myFormatHandler;
+    Value capabilities;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      myFormatHandler = candidates[i];
+      try {
+        capabilities = CallInternal(SYSTEM_GETCAPABILITIES, {});
+        break;
+      }
+      catch (const Fault&) {
+        // The server has no system methods, so it gets the format that it
+        // just read, but is asked again by the next client
+        return;
+      }
+      catch (const std::runtime_error&) {
+        if (i + 1 == candidates.size()) {
+          myFormatHandler = original;
+          throw;
+        }
+      }
+    }
+
+    contentType = myFormatHandler->GetContentType();
+    if (capabilities.IsStruct()) {
+      auto& names = capabilities.AsStruct();
+      for (auto formatHandler : formatHandlers) {
+        if (names.find(formatHandler->GetContentType()) != names.end()) {
+          contentType = formatHandler->GetContentType();
+          break;
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(NegotiatedFormatsMutex);
+    NegotiatedFormats.emplace(std::move(key), contentType);
+  }
 
-  const std::string contentType =
-    "Content-Type: " + myFormatHandler.GetContentType();
+  for (auto formatHandler : candidates) {
+    if (formatHandler->GetContentType() == contentType) {
+      myFormatHandler = formatHandler;
+      break;
+    }
+  }
+}
+
+std::string Client::Post(AttachmentWriter& writer, std::string& message,
+                         Attachments& attachments)
+{
+  std::string contentType = myFormatHandler->GetContentType();
+  std::string request;
+  if (writer.GetAttachments().empty()) {
+    curl_easy_setopt(myHandle, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(writer.GetSize()));
+    curl_easy_setopt(myHandle, CURLOPT_POSTFIELDS, writer.GetData());
+  }
+  else {
+    auto boundary = CreateBoundary(
+      writer.GetData(), writer.GetSize(), writer.GetAttachments());
+    WriteMultipart(request, boundary, contentType, writer.GetData(),
+                   writer.GetSize(), writer.GetAttachments());
+    curl_easy_setopt(myHandle, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(request.size()));
+    curl_easy_setopt(myHandle, CURLOPT_POSTFIELDS, request.data());
+    contentType = GetMultipartContentType(contentType, boundary);
+  }
+
+  contentType = "Content-Type: " + contentType;
   std::unique_ptr<curl_slist, void(*)(curl_slist*)> headers(
     curl_slist_append(NULL, contentType.c_str()), &curl_slist_free_all);
+  std::string accept;
+  if (myAttachments) {
+    accept = std::string("Accept: ") + MULTIPART_RELATED + ", "
+      + myFormatHandler->GetContentType();
+    headers.reset(curl_slist_append(headers.release(), accept.c_str()));
+  }
   curl_easy_setopt(myHandle, CURLOPT_HTTPHEADER, headers.get());
 
   std::string buffer;
@@ -100,19 +306,21 @@ Value Client::CallInternal(const std::string& methodName,
 
   long responseCode;
   if (curl_easy_getinfo(myHandle, CURLINFO_RESPONSE_CODE, &responseCode)
-      != CURLE_OK || responseCode != 200) {
+      != CURLE_OK || (responseCode != 200 && responseCode != 204)) {
     throw std::runtime_error("client: HTTP request failed");
   }
 
-  auto reader = myFormatHandler.CreateReader(std::move(buffer));
-  Response response = reader->GetResponse();
-  if (myFormatHandler.UsesId()
-      && (!response.GetId().IsInteger32()
-          || response.GetId().AsInteger32() != id)) {
-    throw InvalidRequestFault();
+  char* replyType = nullptr;
+  std::string rootType;
+  std::string boundary;
+  if (curl_easy_getinfo(myHandle, CURLINFO_CONTENT_TYPE, &replyType)
+      == CURLE_OK && replyType
+      && ParseMultipartContentType(replyType, rootType, boundary)) {
+    message = std::move(buffer);
+    auto root = ReadMultipart(message, boundary, attachments);
+    return std::string(root.Data, root.Size);
   }
-  response.ThrowIfFault();
-  return std::move(response.GetResult());
+  return buffer;
 }
 
 } // namespace xsonrpc
@@ -0,0 +1,126 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_COMPACT_H
+#define XSONRPC_COMPACT_H
+
+#include "value.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xsonrpc {
+namespace compact {
+
+// Numbers are little-endian and fixed-width. Strings, and the names of
+// struct members, are a 32-bit size followed by the data.
+//
+// A request is REQUEST, the id as a typed value, the method name, the
+// schema hash (32 bits) and the parameters. A notification is the same,
+// but starts with NOTIFICATION and has no id. For a schema hash of
+// UNTYPED, the parameters are a 32-bit count followed by typed values.
+// Otherwise, each parameter is written by its type in the signature,
+// without a type of its own.
+//
+// A response is RESPONSE, the id and the result as a typed value. A fault
+// response is FAULT_RESPONSE, the id, the fault code (32 bits) and the
+// fault string.
+const uint8_t REQUEST = 0;
+const uint8_t RESPONSE = 1;
+const uint8_t NOTIFICATION = 2;
+const uint8_t FAULT_RESPONSE = 3;
+
+const uint32_t UNTYPED = 0;
+
+// A typed value is one of these, followed by the value. Arrays and structs
+// have a 32-bit count of elements. Packed arrays have the elements without
+// types.
+const uint8_t NIL = 0;
+const uint8_t FALSE_VALUE = 1;
+const uint8_t TRUE_VALUE = 2;
+const uint8_t INTEGER_32 = 3;
+const uint8_t INTEGER_64 = 4;
+const uint8_t DOUBLE = 5;
+const uint8_t STRING = 6;
+const uint8_t BINARY = 7;
+const uint8_t DATE_TIME = 8;
+const uint8_t ARRAY = 9;
+const uint8_t STRUCT = 10;
+const uint8_t INTEGER_32_ARRAY = 11;
+const uint8_t INTEGER_64_ARRAY = 12;
+const uint8_t DOUBLE_ARRAY = 13;
+
+// Parameters typed as array or struct are typed values, as signatures
+// don't describe the elements. Booleans are a byte, nil is nothing and a
+// date/time is 64-bit seconds since the epoch, in UTC.
+
+// The code of a type in the schema hash. Unlike the values of Value::Type,
+// the codes are part of the format.
+inline uint8_t GetTypeCode(Value::Type type)
+{
+  switch (type) {
+    case Value::Type::ARRAY:
+      return ARRAY;
+    case Value::Type::BINARY:
+      return BINARY;
+    case Value::Type::BOOLEAN:
+      return TRUE_VALUE;
+    case Value::Type::DATE_TIME:
+      return DATE_TIME;
+    case Value::Type::DOUBLE:
+      return DOUBLE;
+    case Value::Type::INTEGER_32:
+      return INTEGER_32;
+    case Value::Type::INTEGER_64:
+      return INTEGER_64;
+    case Value::Type::STRING:
+      return STRING;
+    case Value::Type::STRUCT:
+      return STRUCT;
+    case Value::Type::NIL:
+    default:
+      return NIL;
+  }
+}
+
+// FNV-1a over the method name and the types of the signature. Never
+// UNTYPED.
+inline uint32_t GetSchemaHash(const std::string& methodName,
+                              const std::vector<Value::Type>& signature)
+{
+  uint32_t hash = 2166136261u;
+  auto add = [&hash] (uint8_t byte)
+  {
+    hash = (hash ^ byte) * 16777619u;
+  };
+
+  for (auto c : methodName) {
+    add(static_cast<uint8_t>(c));
+  }
+  add(0);
+  for (auto type : signature) {
+    add(GetTypeCode(type));
+  }
+  return hash != UNTYPED ? hash : 1;
+}
+
+} // namespace compact
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,83 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "compactformathandler.h"
+
+#include "bufferedrequestparser.h"
+#include "compactreader.h"
+#include "compactwriter.h"
+
+namespace {
+
+const char APPLICATION_COMPACT[] = "application/x-xsonrpc-compact";
+
+} // namespace
+
+namespace xsonrpc {
+
+CompactFormatHandler::CompactFormatHandler(std::string requestPath)
+  : myRequestPath(std::move(requestPath))
+{
+}
+
+void CompactFormatHandler::RemoveSignature(const std::string& methodName)
+{
+  mySignatures.erase(methodName);
+}
+
+bool CompactFormatHandler::CanHandleRequest(
+  const std::string& path, const std::string& contentType)
+{
+  return path == myRequestPath
+    && contentType == APPLICATION_COMPACT;
+}
+
+std::string CompactFormatHandler::GetContentType()
+{
+  return APPLICATION_COMPACT;
+}
+
+bool CompactFormatHandler::UsesId()
+{
+  return true;
+}
+
+std::unique_ptr<Reader> CompactFormatHandler::CreateReader(std::string data)
+{
+  return std::unique_ptr<Reader>(
+    new CompactReader(std::move(data), mySignatures));
+}
+
+std::unique_ptr<RequestParser> CompactFormatHandler::CreateRequestParser(
+  const Dispatcher& dispatcher)
+{
+  return std::unique_ptr<RequestParser>(new BufferedRequestParser(
+    dispatcher,
+    [this] (std::string data)
+    {
+      return std::unique_ptr<ByteReader>(
+        new CompactReader(std::move(data), mySignatures));
+    }));
+}
+
+std::unique_ptr<Writer> CompactFormatHandler::CreateWriter()
+{
+  return std::unique_ptr<Writer>(new CompactWriter(mySignatures));
+}
+
+} // namespace xsonrpc
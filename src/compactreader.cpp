@@ -0,0 +1,387 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "compactreader.h"
+
+#include "compact.h"
+#include "fault.h"
+#include "request.h"
+#include "response.h"
+#include "value.h"
+#include "valuehandler.h"
+
+#include <cstring>
+
+namespace xsonrpc {
+
+using namespace compact;
+
+CompactReader::CompactReader(
+  std::string data, const CompactFormatHandler::Signatures& signatures)
+  : ByteReader(std::move(data)),
+    mySignatures(signatures)
+{
+}
+
+Request CompactReader::GetRequest()
+{
+  Value id;
+  std::string name;
+  const auto hash = ReadHeader(id, name);
+
+  // Without a dispatcher, only the signatures of the format handler are
+  // known (see InvokeRequest for the server side)
+  const std::vector<Value::Type>* signature = nullptr;
+  if (hash != UNTYPED) {
+    auto it = mySignatures.find(name);
+    if (it == mySignatures.end() || GetSchemaHash(name, it->second) != hash) {
+      throw InvalidRequestFault("Unknown schema");
+    }
+    signature = &it->second;
+  }
+
+  Request::Parameters parameters;
+  ReadParameters(
+    signature,
+    [&] (const Value::Type* type)
+    {
+      ValueBuilder builder(myStringsByReference);
+      ReadParameter(type, builder);
+      parameters.emplace_back(std::move(builder.GetValue()));
+    });
+  return Request(std::move(name), std::move(parameters), std::move(id));
+}
+
+Response CompactReader::GetResponse()
+{
+  const auto kind = ReadByte();
+  if (kind != RESPONSE && kind != FAULT_RESPONSE) {
+    throw InvalidRequestFault("Invalid response");
+  }
+
+  auto id = ReadValue();
+  if (kind == FAULT_RESPONSE) {
+    const auto code = ReadLittleEndian<int32_t>();
+    const char* data;
+    size_t size;
+    ReadString(data, size);
+    ReadEnd();
+    return Response(code, std::string(data, size), std::move(id));
+  }
+
+  auto result = ReadValue();
+  ReadEnd();
+  return Response(std::move(result), std::move(id));
+}
+
+Value CompactReader::GetValue()
+{
+  auto value = ReadValue();
+  ReadEnd();
+  return value;
+}
+
+Response CompactReader::InvokeRequest(const Dispatcher& dispatcher)
+{
+  Value id;
+  std::string name;
+  const auto hash = ReadHeader(id, name);
+
+  // The parameters can't be read without the signature, so the fault is
+  // returned without reading them
+  const std::vector<Value::Type>* signature = nullptr;
+  const auto method = dispatcher.FindMethod(name);
+  if (hash != UNTYPED) {
+    if (!method) {
+      MethodNotFoundFault fault("Method not found: " + name);
+      return Response(fault.GetCode(), fault.GetString(), std::move(id));
+    }
+    for (auto& candidate : method->GetSignatures()) {
+      if (GetSchemaHash(name, candidate) == hash) {
+        signature = &candidate;
+        break;
+      }
+    }
+    if (!signature) {
+      InvalidParametersFault fault("Unknown schema");
+      return Response(fault.GetCode(), fault.GetString(), std::move(id));
+    }
+  }
+
+  auto decoder = method
+    ? CreateParameterDecoder(*method, myAttachments) : nullptr;
+  if (!decoder) {
+    Request::Parameters parameters;
+    ReadParameters(
+      signature,
+      [&] (const Value::Type* type)
+      {
+        ValueBuilder builder(myStringsByReference);
+        ReadParameter(type, builder);
+        parameters.emplace_back(std::move(builder.GetValue()));
+      });
+    return dispatcher.Invoke(name, parameters, id);
+  }
+
+  ReadParameters(
+    signature,
+    [&] (const Value::Type* type)
+    {
+      decoder->StartParameter();
+      ReadParameter(type, *decoder);
+      decoder->EndParameter();
+    });
+  return dispatcher.Invoke(*decoder, id);
+}
+
+uint32_t CompactReader::ReadHeader(Value& id, std::string& methodName)
+{
+  const auto kind = ReadByte();
+  if (kind == REQUEST) {
+    id = ReadValue();
+    if (!id.IsInteger32() && !id.IsInteger64() && !id.IsString()
+        && !id.IsNil()) {
+      throw InvalidRequestFault("Invalid request id");
+    }
+  }
+  else if (kind == NOTIFICATION) {
+    myIsNotification = true;
+    id = false;
+  }
+  else {
+    throw InvalidRequestFault("Invalid message type");
+  }
+
+  const char* data;
+  size_t size;
+  ReadString(data, size);
+  if (size == 0) {
+    throw InvalidRequestFault("Missing method name");
+  }
+  methodName.assign(data, size);
+  return ReadLittleEndian<uint32_t>();
+}
+
+template<typename Function>
+void CompactReader::ReadParameters(
+  const std::vector<Value::Type>* signature, Function readParameter)
+{
+  if (signature) {
+    for (size_t i = 1; i < signature->size(); ++i) {
+      readParameter(&(*signature)[i]);
+    }
+  }
+  else {
+    for (auto count = ReadCount(1); count > 0; --count) {
+      readParameter(nullptr);
+    }
+  }
+  ReadEnd();
+}
+
+void CompactReader::ReadParameter(const Value::Type* type,
+                                  ValueHandler& handler)
+{
+  if (!type) {
+    ReadValue(handler);
+    return;
+  }
+
+  switch (*type) {
+    case Value::Type::ARRAY: {
+      const auto valueType = ReadByte();
+      if (valueType != ARRAY && valueType != INTEGER_32_ARRAY
+          && valueType != INTEGER_64_ARRAY && valueType != DOUBLE_ARRAY) {
+        throw InvalidRequestFault("Parameter is not an array");
+      }
+      ReadValue(valueType, handler);
+      break;
+    }
+    case Value::Type::BINARY: {
+      const char* data;
+      size_t size;
+      ReadString(data, size);
+      handler.Binary(data, size);
+      break;
+    }
+    case Value::Type::BOOLEAN:
+      handler.Boolean(ReadByte() != 0);
+      break;
+    case Value::Type::DATE_TIME:
+      handler.DateTime(Value::DateTime(ReadLittleEndian<int64_t>()));
+      break;
+    case Value::Type::DOUBLE:
+      handler.Double(ReadDouble());
+      break;
+    case Value::Type::INTEGER_32:
+      handler.Integer32(ReadLittleEndian<int32_t>());
+      break;
+    case Value::Type::INTEGER_64:
+      handler.Integer64(ReadLittleEndian<int64_t>());
+      break;
+    case Value::Type::NIL:
+      handler.Nil();
+      break;
+    case Value::Type::STRING: {
+      const char* data;
+      size_t size;
+      ReadString(data, size);
+      handler.String(data, size);
+      break;
+    }
+    case Value::Type::STRUCT:
+      if (ReadByte() != STRUCT) {
+        throw InvalidRequestFault("Parameter is not a struct");
+      }
+      ReadValue(STRUCT, handler);
+      break;
+  }
+}
+
+void CompactReader::ReadValue(ValueHandler& handler)
+{
+  ReadValue(ReadByte(), handler);
+}
+
+void CompactReader::ReadValue(uint8_t type, ValueHandler& handler)
+{
+  Nesting nesting(*this);
+  switch (type) {
+    case NIL:
+      handler.Nil();
+      break;
+    case FALSE_VALUE:
+      handler.Boolean(false);
+      break;
+    case TRUE_VALUE:
+      handler.Boolean(true);
+      break;
+    case INTEGER_32:
+      handler.Integer32(ReadLittleEndian<int32_t>());
+      break;
+    case INTEGER_64:
+      handler.Integer64(ReadLittleEndian<int64_t>());
+      break;
+    case DOUBLE:
+      handler.Double(ReadDouble());
+      break;
+    case STRING:
+    case BINARY: {
+      const char* data;
+      size_t size;
+      ReadString(data, size);
+      if (type == STRING) {
+        handler.String(data, size);
+      }
+      else {
+        handler.Binary(data, size);
+      }
+      break;
+    }
+    case DATE_TIME:
+      handler.DateTime(Value::DateTime(ReadLittleEndian<int64_t>()));
+      break;
+
+    case ARRAY: {
+      auto count = ReadCount(1);
+      handler.StartArray();
+      for (; count > 0; --count) {
+        ReadValue(handler);
+      }
+      handler.EndArray();
+      break;
+    }
+    case STRUCT: {
+      // A member is at least the size of its name and a type
+      auto count = ReadCount(sizeof(uint32_t) + 1);
+      handler.StartStruct();
+      for (; count > 0; --count) {
+        const char* name;
+        size_t size;
+        ReadString(name, size);
+        handler.StartStructElement(name, size);
+        ReadValue(handler);
+      }
+      handler.EndStruct();
+      break;
+    }
+
+    case INTEGER_32_ARRAY: {
+      auto count = ReadCount(sizeof(int32_t));
+      handler.StartArray();
+      for (; count > 0; --count) {
+        handler.Integer32(ReadLittleEndian<int32_t>());
+      }
+      handler.EndArray();
+      break;
+    }
+    case INTEGER_64_ARRAY: {
+      auto count = ReadCount(sizeof(int64_t));
+      handler.StartArray();
+      for (; count > 0; --count) {
+        handler.Integer64(ReadLittleEndian<int64_t>());
+      }
+      handler.EndArray();
+      break;
+    }
+    case DOUBLE_ARRAY: {
+      auto count = ReadCount(sizeof(double));
+      handler.StartArray();
+      for (; count > 0; --count) {
+        handler.Double(ReadDouble());
+      }
+      handler.EndArray();
+      break;
+    }
+
+    default:
+      throw InvalidRequestFault("Invalid type");
+  }
+}
+
+Value CompactReader::ReadValue()
+{
+  ValueBuilder builder(myStringsByReference);
+  ReadValue(builder);
+  return std::move(builder.GetValue());
+}
+
+void CompactReader::ReadString(const char*& data, size_t& size)
+{
+  size = ReadCount(1);
+  data = ReadBytes(size);
+}
+
+size_t CompactReader::ReadCount(size_t elementSize)
+{
+  const auto count = ReadLittleEndian<uint32_t>();
+  if (count > GetBytesLeft() / elementSize) {
+    throw ParseErrorFault("Parse error: unexpected end of data");
+  }
+  return count;
+}
+
+double CompactReader::ReadDouble()
+{
+  auto bits = ReadLittleEndian<uint64_t>();
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+} // namespace xsonrpc
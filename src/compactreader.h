@@ -0,0 +1,78 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_COMPACTREADER_H
+#define XSONRPC_COMPACTREADER_H
+
+#include "bytereader.h"
+#include "compactformathandler.h"
+
+#include <cstdint>
+#include <string>
+
+namespace xsonrpc {
+
+class ValueHandler;
+
+// Reads messages in the compact format, see compact.h, in a single pass,
+// so only one of GetRequest, GetResponse, GetValue and InvokeRequest can be
+// called. The parameters of a call with a signature are read by the
+// signature that matches the schema hash.
+//
+// InvokeRequest, which the server uses, looks the signature up among those
+// of the method in the dispatcher. GetRequest has no dispatcher, so it can
+// only use the signatures added to the format handler, i.e. the ones a
+// client writes calls with. It is meant for reading calls written with the
+// same handler, e.g. in tests, and throws InvalidRequestFault for a typed
+// call whose signature the handler doesn't have, even if the server has it.
+class CompactReader final : public ByteReader
+{
+public:
+  CompactReader(std::string data,
+                const CompactFormatHandler::Signatures& signatures);
+
+  // Reader
+  Request GetRequest() override;
+  Response GetResponse() override;
+  Value GetValue() override;
+  Response InvokeRequest(const Dispatcher& dispatcher) override;
+
+private:
+  // Returns the schema hash
+  uint32_t ReadHeader(Value& id, std::string& methodName);
+  // Calls readParameter with the type of each parameter in the signature,
+  // or with null for each typed parameter if there is no signature
+  template<typename Function>
+  void ReadParameters(const std::vector<Value::Type>* signature,
+                      Function readParameter);
+  void ReadParameter(const Value::Type* type, ValueHandler& handler);
+  void ReadValue(ValueHandler& handler);
+  void ReadValue(uint8_t type, ValueHandler& handler);
+  Value ReadValue();
+  void ReadString(const char*& data, size_t& size);
+  // Reads a count of elements that take at least elementSize bytes each.
+  // Throws ParseErrorFault if there are fewer bytes left.
+  size_t ReadCount(size_t elementSize);
+  double ReadDouble();
+
+  const CompactFormatHandler::Signatures& mySignatures;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,452 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "compactwriter.h"
+
+#include "compact.h"
+#include "valueserializer.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const size_t COUNT_SIZE = sizeof(uint32_t);
+
+[[noreturn]] void ThrowMismatch()
+{
+  throw std::invalid_argument("compact: parameter does not match signature");
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+using namespace compact;
+
+CompactWriter::CompactWriter(
+  const CompactFormatHandler::Signatures& signatures)
+  : mySignatures(signatures)
+{
+}
+
+inline void CompactWriter::AppendLittleEndian(double value)
+{
+  uint64_t bits;
+  static_assert(sizeof(bits) == sizeof(value), "double is not 64 bits");
+  memcpy(&bits, &value, sizeof(bits));
+  AppendLittleEndian(bits);
+}
+
+void CompactWriter::AppendSize(size_t size)
+{
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("compact: too large");
+  }
+  AppendLittleEndian(static_cast<uint32_t>(size));
+}
+
+void CompactWriter::AppendString(const char* data, size_t size)
+{
+  AppendSize(size);
+  myBuffer.append(data, size);
+}
+
+bool CompactWriter::TakeParameterType(Value::Type& type)
+{
+  if (!myIsInParameter) {
+    return false;
+  }
+  // Values inside the parameter are typed
+  myIsInParameter = false;
+  type = (*mySignature)[myParameterCount + 1];
+  return true;
+}
+
+inline void CompactWriter::StartValue(uint8_t type)
+{
+  AddElement();
+  Append(type);
+}
+
+void CompactWriter::StartContainer(bool isStruct)
+{
+  ByteWriter::StartContainer(isStruct, COUNT_SIZE);
+}
+
+void CompactWriter::EndContainer()
+{
+  const auto container = ByteWriter::EndContainer();
+  if (container.Size > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("compact: too large");
+  }
+  auto size = static_cast<uint32_t>(container.Size);
+  char header[COUNT_SIZE];
+  for (size_t i = 0; i < COUNT_SIZE; ++i) {
+    header[i] = static_cast<char>(size & 0xff);
+    size >>= 8;
+  }
+  WriteHeader(container, header, COUNT_SIZE);
+}
+
+void CompactWriter::WriteId(const Value& id)
+{
+  if (id.IsInteger32()) {
+    Append(INTEGER_32);
+    AppendLittleEndian(id.AsInteger32());
+  }
+  else if (id.IsInteger64()) {
+    Append(INTEGER_64);
+    AppendLittleEndian(id.AsInteger64());
+  }
+  else if (id.IsString()) {
+    Append(STRING);
+    AppendString(id.AsString().data(), id.AsString().size());
+  }
+  else {
+    Append(NIL);
+  }
+}
+
+template<typename T>
+void CompactWriter::WriteArray(uint8_t type, const T* data, size_t size)
+{
+  Value::Type parameterType;
+  if (TakeParameterType(parameterType)
+      && parameterType != Value::Type::ARRAY) {
+    ThrowMismatch();
+  }
+
+  StartValue(type);
+  AppendSize(size);
+  myBuffer.reserve(myBuffer.size() + size * sizeof(T));
+  for (size_t i = 0; i < size; ++i) {
+    AppendLittleEndian(data[i]);
+  }
+}
+
+void CompactWriter::StartDocument()
+{
+  // Empty
+}
+
+void CompactWriter::EndDocument()
+{
+  // Empty
+}
+
+void CompactWriter::StartBatch()
+{
+  throw std::logic_error("compact: batches are not supported");
+}
+
+void CompactWriter::EndBatch()
+{
+  throw std::logic_error("compact: batches are not supported");
+}
+
+void CompactWriter::StartRequest(const std::string& methodName,
+                                 const Value& id)
+{
+  // A request without id is a notification, see Client::Notify
+  if (id.IsBoolean()) {
+    Append(NOTIFICATION);
+  }
+  else {
+    Append(REQUEST);
+    WriteId(id);
+  }
+  AppendString(methodName.data(), methodName.size());
+
+  auto signature = mySignatures.find(methodName);
+  if (signature != mySignatures.end() && !signature->second.empty()) {
+    mySignature = &signature->second;
+    myParameterCount = 0;
+    AppendLittleEndian(GetSchemaHash(methodName, *mySignature));
+  }
+  else {
+    AppendLittleEndian(UNTYPED);
+    StartContainer(false);
+  }
+}
+
+void CompactWriter::EndRequest()
+{
+  if (!mySignature) {
+    EndContainer();
+    return;
+  }
+
+  if (myParameterCount + 1 != mySignature->size()) {
+    throw std::invalid_argument(
+      "compact: fewer parameters than in signature");
+  }
+  mySignature = nullptr;
+}
+
+void CompactWriter::StartParameter()
+{
+  if (mySignature) {
+    if (myParameterCount + 1 >= mySignature->size()) {
+      throw std::invalid_argument(
+        "compact: more parameters than in signature");
+    }
+    myIsInParameter = true;
+  }
+}
+
+void CompactWriter::EndParameter()
+{
+  if (mySignature) {
+    if (myIsInParameter) {
+      // Nothing was written, which only matches nil
+      Value::Type type;
+      if (TakeParameterType(type) && type != Value::Type::NIL) {
+        ThrowMismatch();
+      }
+    }
+    ++myParameterCount;
+  }
+}
+
+void CompactWriter::StartResponse(const Value& id)
+{
+  Append(RESPONSE);
+  WriteId(id);
+}
+
+void CompactWriter::EndResponse()
+{
+  // Empty
+}
+
+void CompactWriter::StartFaultResponse(const Value& id)
+{
+  Append(FAULT_RESPONSE);
+  WriteId(id);
+}
+
+void CompactWriter::EndFaultResponse()
+{
+  // Empty
+}
+
+void CompactWriter::WriteFault(int32_t code, const std::string& string)
+{
+  AppendLittleEndian(code);
+  AppendString(string.data(), string.size());
+}
+
+void CompactWriter::StartArray()
+{
+  Value::Type type;
+  if (TakeParameterType(type) && type != Value::Type::ARRAY) {
+    ThrowMismatch();
+  }
+  StartValue(ARRAY);
+  StartContainer(false);
+}
+
+void CompactWriter::EndArray()
+{
+  EndContainer();
+}
+
+void CompactWriter::StartStruct()
+{
+  Value::Type type;
+  if (TakeParameterType(type) && type != Value::Type::STRUCT) {
+    ThrowMismatch();
+  }
+  StartValue(STRUCT);
+  StartContainer(true);
+}
+
+void CompactWriter::EndStruct()
+{
+  EndContainer();
+}
+
+void CompactWriter::StartStructElement(const std::string& name)
+{
+  AddMember();
+  AppendString(name.data(), name.size());
+}
+
+void CompactWriter::StartStructElement(const char* name)
+{
+  AddMember();
+  AppendString(name, strlen(name));
+}
+
+void CompactWriter::EndStructElement()
+{
+  // Empty
+}
+
+void CompactWriter::WriteArray(const int32_t* data, size_t size)
+{
+  WriteArray(INTEGER_32_ARRAY, data, size);
+}
+
+void CompactWriter::WriteArray(const int64_t* data, size_t size)
+{
+  WriteArray(INTEGER_64_ARRAY, data, size);
+}
+
+void CompactWriter::WriteArray(const double* data, size_t size)
+{
+  WriteArray(DOUBLE_ARRAY, data, size);
+}
+
+void CompactWriter::WriteBinary(const char* data, size_t size)
+{
+  Value::Type type;
+  if (TakeParameterType(type)) {
+    if (type != Value::Type::BINARY) {
+      ThrowMismatch();
+    }
+  }
+  else {
+    StartValue(BINARY);
+  }
+  AppendString(data, size);
+}
+
+void CompactWriter::WriteNull()
+{
+  Value::Type type;
+  if (TakeParameterType(type)) {
+    if (type != Value::Type::NIL) {
+      ThrowMismatch();
+    }
+  }
+  else {
+    StartValue(NIL);
+  }
+}
+
+void CompactWriter::Write(bool value)
+{
+  Value::Type type;
+  if (TakeParameterType(type)) {
+    if (type != Value::Type::BOOLEAN) {
+      ThrowMismatch();
+    }
+    Append(value ? 1 : 0);
+  }
+  else {
+    StartValue(value ? TRUE_VALUE : FALSE_VALUE);
+  }
+}
+
+void CompactWriter::Write(double value)
+{
+  Value::Type type;
+  if (TakeParameterType(type)) {
+    if (type != Value::Type::DOUBLE) {
+      ThrowMismatch();
+    }
+  }
+  else {
+    StartValue(DOUBLE);
+  }
+  AppendLittleEndian(value);
+}
+
+void CompactWriter::Write(int32_t value)
+{
+  Value::Type type;
+  if (!TakeParameterType(type)) {
+    StartValue(INTEGER_32);
+    AppendLittleEndian(value);
+  }
+  else if (type == Value::Type::INTEGER_32) {
+    AppendLittleEndian(value);
+  }
+  else if (type == Value::Type::INTEGER_64) {
+    AppendLittleEndian(static_cast<int64_t>(value));
+  }
+  else if (type == Value::Type::DOUBLE) {
+    AppendLittleEndian(static_cast<double>(value));
+  }
+  else {
+    ThrowMismatch();
+  }
+}
+
+void CompactWriter::Write(int64_t value)
+{
+  Value::Type type;
+  if (!TakeParameterType(type)) {
+    StartValue(INTEGER_64);
+    AppendLittleEndian(value);
+  }
+  else if (type == Value::Type::INTEGER_64) {
+    AppendLittleEndian(value);
+  }
+  else if (type == Value::Type::INTEGER_32
+           && value >= std::numeric_limits<int32_t>::min()
+           && value <= std::numeric_limits<int32_t>::max()) {
+    AppendLittleEndian(static_cast<int32_t>(value));
+  }
+  else {
+    ThrowMismatch();
+  }
+}
+
+void CompactWriter::Write(const std::string& value)
+{
+  Write(value.data(), value.size());
+}
+
+void CompactWriter::Write(const char* data, size_t size)
+{
+  Value::Type type;
+  if (TakeParameterType(type)) {
+    if (type != Value::Type::STRING) {
+      ThrowMismatch();
+    }
+  }
+  else {
+    StartValue(STRING);
+  }
+  AppendString(data, size);
+}
+
+void CompactWriter::Write(const Value::DateTime& value)
+{
+  Value::Type type;
+  if (TakeParameterType(type)) {
+    if (type != Value::Type::DATE_TIME) {
+      ThrowMismatch();
+    }
+  }
+  else {
+    StartValue(DATE_TIME);
+  }
+  AppendLittleEndian(value.GetSecondsSinceEpoch());
+}
+
+void CompactWriter::WriteValue(const Value& value)
+{
+  SerializeValue(value, *this);
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,102 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_COMPACTWRITER_H
+#define XSONRPC_COMPACTWRITER_H
+
+#include "bytewriter.h"
+#include "compactformathandler.h"
+
+namespace xsonrpc {
+
+// Writes messages in the compact format, see compact.h. The parameters of
+// a call with a signature are written by it, converting numbers where no
+// precision is lost, and throw std::invalid_argument if they don't match.
+// As in MsgPackWriter, the count of an array, struct or untyped parameters
+// is written when it ends, so data is only available (see GetData) up to
+// the first one that is still open, and a generated array is produced in
+// full before any of it can be sent.
+class CompactWriter final : public ByteWriter
+{
+public:
+  explicit CompactWriter(const CompactFormatHandler::Signatures& signatures);
+
+  // Writer
+  void StartDocument() override;
+  void EndDocument() override;
+  void StartBatch() override;
+  void EndBatch() override;
+  void StartRequest(const std::string& methodName, const Value& id) override;
+  void EndRequest() override;
+  void StartParameter() override;
+  void EndParameter() override;
+  void StartResponse(const Value& id) override;
+  void EndResponse() override;
+  void StartFaultResponse(const Value& id) override;
+  void EndFaultResponse() override;
+  void WriteFault(int32_t code, const std::string& string) override;
+  void StartArray() override;
+  void EndArray() override;
+  void StartStruct() override;
+  void EndStruct() override;
+  void StartStructElement(const std::string& name) override;
+  void StartStructElement(const char* name) override;
+  void EndStructElement() override;
+  void WriteArray(const int32_t* data, size_t size) override;
+  void WriteArray(const int64_t* data, size_t size) override;
+  void WriteArray(const double* data, size_t size) override;
+  void WriteBinary(const char* data, size_t size) override;
+  void WriteNull() override;
+  void Write(bool value) override;
+  void Write(double value) override;
+  void Write(int32_t value) override;
+  void Write(int64_t value) override;
+  void Write(const std::string& value) override;
+  void Write(const char* data, size_t size) override;
+  void Write(const Value::DateTime& value) override;
+  void WriteValue(const Value& value) override;
+
+private:
+  // Returns true, with the type in the signature, if the value to write is
+  // a parameter of a call with a signature
+  bool TakeParameterType(Value::Type& type);
+  // Starts a typed value, counting it as an element of the enclosing array
+  // or untyped parameters. Members of structs are counted by
+  // StartStructElement.
+  void StartValue(uint8_t type);
+  // Leaves room for the count
+  void StartContainer(bool isStruct);
+  void EndContainer();
+  void WriteId(const Value& id);
+  template<typename T>
+  void WriteArray(uint8_t type, const T* data, size_t size);
+  void AppendString(const char* data, size_t size);
+  void AppendSize(size_t size);
+  using ByteWriter::AppendLittleEndian;
+  void AppendLittleEndian(double value);
+
+  const CompactFormatHandler::Signatures& mySignatures;
+  // Of the call being written, if it has one
+  const std::vector<Value::Type>* mySignature = nullptr;
+  size_t myParameterCount = 0;
+  bool myIsInParameter = false;
+};
+
+} // namespace xsonrpc
+
+#endif
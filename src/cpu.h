@@ -0,0 +1,42 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_CPU_H
+#define XSONRPC_CPU_H
+
+// x86 kernels are compiled with target attributes instead of for the whole
+// library, so that it runs on any x86 CPU and uses e.g. AVX2 only if the
+// CPU supports it
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) \
+  && defined(__GNUC__)
+#define XSONRPC_X86_SIMD
+#endif
+
+namespace xsonrpc {
+namespace util {
+
+#ifdef XSONRPC_X86_SIMD
+// Support for instruction sets beyond SSE2, checked once
+bool HasSsse3();
+bool HasAvx2();
+#endif
+
+} // namespace util
+} // namespace xsonrpc
+
+#endif
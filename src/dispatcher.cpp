@@ -17,8 +17,36 @@
 
 #include "dispatcher.h"
 
+#include <algorithm>
 #include <stdexcept>
 
+namespace {
+
+template<typename Function>
+xsonrpc::Response InvokeAndCatch(Function function, const xsonrpc::Value& id)
+{
+  using namespace xsonrpc;
+
+  try {
+    return {function(), Value(id)};
+  }
+  catch (const Fault& fault) {
+    return Response(fault.GetCode(), fault.GetString(), Value(id));
+  }
+  catch (const std::out_of_range&) {
+    InvalidParametersFault fault;
+    return Response(fault.GetCode(), fault.GetString(), Value(id));
+  }
+  catch (const std::exception& ex) {
+    return Response(0, ex.what(), Value(id));
+  }
+  catch (...) {
+    return Response(0, "unknown error", Value(id));
+  }
+}
+
+} // namespace
+
 namespace xsonrpc {
 
 MethodWrapper& MethodWrapper::SetHelpText(std::string help)
@@ -47,6 +75,12 @@ MethodWrapper& Dispatcher::GetMethod(const std::string& name)
   return myMethods.at(name);
 }
 
+const MethodWrapper* Dispatcher::FindMethod(const std::string& name) const
+{
+  auto method = myMethods.find(name);
+  return method != myMethods.end() ? &method->second : nullptr;
+}
+
 MethodWrapper& Dispatcher::AddMethod(
   std::string name, MethodWrapper::Method method)
 {
@@ -65,30 +99,42 @@ void Dispatcher::RemoveMethod(const std::string& name)
   myMethods.erase(name);
 }
 
+void Dispatcher::AddFormat(std::string contentType)
+{
+  if (std::find(myFormats.begin(), myFormats.end(), contentType)
+      == myFormats.end()) {
+    myFormats.push_back(std::move(contentType));
+  }
+}
+
 Response Dispatcher::Invoke(const std::string& name,
                             const Request::Parameters& parameters,
                             const Value& id) const
 {
-  try {
-    auto method = myMethods.find(name);
-    if (method == myMethods.end()) {
-      throw MethodNotFoundFault("Method not found: " + name);
-    }
-    return {method->second(parameters), Value(id)};
-  }
-  catch (const Fault& fault) {
-    return Response(fault.GetCode(), fault.GetString(), Value(id));
-  }
-  catch (const std::out_of_range&) {
-    InvalidParametersFault fault;
-    return Response(fault.GetCode(), fault.GetString(), Value(id));
-  }
-  catch (const std::exception& ex) {
-    return Response(0, ex.what(), Value(id));
-  }
-  catch (...) {
-    return Response(0, "unknown error", Value(id));
+  return InvokeAndCatch(
+    [&] ()
+    {
+      auto method = myMethods.find(name);
+      if (method == myMethods.end()) {
+        throw MethodNotFoundFault("Method not found: " + name);
+      }
+      return method->second(parameters);
+    }, id);
+}
+
+std::unique_ptr<ParameterDecoder> Dispatcher::CreateParameterDecoder(
+  const std::string& name) const
+{
+  auto method = myMethods.find(name);
+  if (method == myMethods.end()) {
+    return nullptr;
   }
+  return method->second.CreateParameterDecoder();
+}
+
+Response Dispatcher::Invoke(ParameterDecoder& decoder, const Value& id) const
+{
+  return InvokeAndCatch([&] () { return decoder.Invoke(); }, id);
 }
 
 } // namespace xsonrpc
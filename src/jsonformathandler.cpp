@@ -18,6 +18,7 @@
 #include "jsonformathandler.h"
 
 #include "jsonreader.h"
+#include "jsonrequestparser.h"
 #include "jsonwriter.h"
 
 namespace {
@@ -29,7 +30,8 @@ const char APPLICATION_JSON[] = "application/json";
 namespace xsonrpc {
 
 JsonFormatHandler::JsonFormatHandler(std::string requestPath)
-  : myRequestPath(std::move(requestPath))
+  : myRequestPath(std::move(requestPath)),
+    myAllocatorPool(std::make_shared<JsonAllocatorPool>())
 {
 }
 
@@ -51,7 +53,17 @@ bool JsonFormatHandler::UsesId()
 
 std::unique_ptr<Reader> JsonFormatHandler::CreateReader(std::string data)
 {
-  return std::unique_ptr<Reader>(new JsonReader(std::move(data)));
+  return std::unique_ptr<Reader>(
+    new JsonReader(std::move(data), myTypeInference, myValidateUtf8,
+                   myAllocatorPool));
+}
+
+std::unique_ptr<RequestParser> JsonFormatHandler::CreateRequestParser(
+  const Dispatcher& dispatcher)
+{
+  return std::unique_ptr<RequestParser>(
+    new JsonRequestParser(dispatcher, myTypeInference, myValidateUtf8,
+                          myAllocatorPool));
 }
 
 std::unique_ptr<Writer> JsonFormatHandler::CreateWriter()
@@ -19,31 +19,145 @@
 
 #include "fault.h"
 #include "json.h"
+#include "jsonrequesthandler.h"
 #include "request.h"
 #include "response.h"
+#include "textscan.h"
 #include "util.h"
 #include "value.h"
 
+#include <cstring>
+#include <limits>
+#include <rapidjson/reader.h>
+
+namespace {
+
+const size_t STACK_CAPACITY = 1024;
+
+// The type GetValue gives a number
+xsonrpc::Value::Type GetNumberType(const rapidjson::Value& value)
+{
+  if (value.IsInt()) {
+    return xsonrpc::Value::Type::INTEGER_32;
+  }
+  else if (value.IsInt64()) {
+    return xsonrpc::Value::Type::INTEGER_64;
+  }
+  return xsonrpc::Value::Type::DOUBLE;
+}
+
+// The type of all elements if they are numbers of the same type, so that
+// the array can be packed, otherwise NIL
+xsonrpc::Value::Type GetPackableType(const rapidjson::Value& array)
+{
+  if (array.Empty() || !array.Begin()->IsNumber()) {
+    return xsonrpc::Value::Type::NIL;
+  }
+
+  const auto type = GetNumberType(*array.Begin());
+  for (auto it = array.Begin() + 1; it != array.End(); ++it) {
+    if (!it->IsNumber() || GetNumberType(*it) != type) {
+      return xsonrpc::Value::Type::NIL;
+    }
+  }
+  return type;
+}
+
+} // namespace
+
 namespace xsonrpc {
 
 using namespace json;
 
-JsonReader::JsonReader(std::string data)
+JsonAllocatorPool::Arena::Arena(size_t capacity)
+  : myCapacity(capacity),
+    myBuffer(new char[capacity]),
+    myAllocator(myBuffer.get(), capacity)
 {
-  myDocument.Parse(data.c_str());
-  if (myDocument.HasParseError()) {
-    throw ParseErrorFault(
-      "Parse error: " + std::to_string(myDocument.GetParseError()));
+}
+
+JsonAllocatorPool::Lease::Lease(std::shared_ptr<JsonAllocatorPool> pool)
+  : myPool(std::move(pool)),
+    myArena(myPool->Acquire())
+{
+}
+
+JsonAllocatorPool::Lease::~Lease()
+{
+  myPool->Release(std::move(myArena));
+}
+
+size_t JsonAllocatorPool::GetCapacity() const
+{
+  std::lock_guard<std::mutex> lock(myMutex);
+  return myCapacity;
+}
+
+std::unique_ptr<JsonAllocatorPool::Arena> JsonAllocatorPool::Acquire()
+{
+  size_t capacity;
+  {
+    std::lock_guard<std::mutex> lock(myMutex);
+    if (!myArenas.empty()) {
+      auto arena = std::move(myArenas.back());
+      myArenas.pop_back();
+      return arena;
+    }
+    capacity = myCapacity;
   }
+  // Allocated without holding the lock
+  return std::unique_ptr<Arena>(new Arena(capacity));
+}
+
+void JsonAllocatorPool::Release(std::unique_ptr<Arena> arena)
+{
+  auto& allocator = arena->GetAllocator();
+  const bool tooSmall = allocator.Capacity() > arena->GetCapacity();
+  const size_t size = allocator.Size();
+  allocator.Clear();
+
+  std::lock_guard<std::mutex> lock(myMutex);
+  // More chunks than the preallocated one means that the arena was too
+  // small, so make new arenas larger and drop the smaller ones
+  if (tooSmall) {
+    while (myCapacity < MAX_CAPACITY && myCapacity < 2 * size) {
+      myCapacity *= 2;
+    }
+  }
+  if (arena->GetCapacity() < myCapacity
+      || myArenas.size() >= MAX_IDLE_ARENAS) {
+    return;
+  }
+
+  myArenas.push_back(std::move(arena));
+}
+
+JsonReader::JsonReader(std::string data, bool typeInference,
+                       bool validateUtf8,
+                       std::shared_ptr<JsonAllocatorPool> pool)
+  : myData(std::move(data)),
+    myLease(pool ? std::move(pool) : std::make_shared<JsonAllocatorPool>()),
+    myDocument(&myLease.GetAllocator(), STACK_CAPACITY,
+               &myLease.GetAllocator()),
+    myTypeInference(typeInference),
+    myValidateUtf8(validateUtf8)
+{
+}
+
+void JsonReader::SetStringsByReference(bool byReference)
+{
+  myStringsByReference = byReference;
 }
 
 Request JsonReader::GetRequest()
 {
+  Parse();
+
   if (!myDocument.IsObject()) {
     throw InvalidRequestFault();
   }
 
-  ValidateJsonrpcVersion();
+  ValidateJsonrpcVersion(myDocument);
 
   auto method = myDocument.FindMember(METHOD_NAME);
   if (method == myDocument.MemberEnd() || !method->value.IsString()) {
@@ -75,28 +189,106 @@ Request JsonReader::GetRequest()
 
 Response JsonReader::GetResponse()
 {
-  if (!myDocument.IsObject()) {
+  Parse();
+  return GetResponse(myDocument);
+}
+
+std::vector<Response> JsonReader::GetBatchResponse()
+{
+  Parse();
+
+  std::vector<Response> responses;
+  if (!myDocument.IsArray()) {
+    responses.push_back(GetResponse(myDocument));
+    return responses;
+  }
+
+  responses.reserve(myDocument.Size());
+  for (auto it = myDocument.Begin(); it != myDocument.End(); ++it) {
+    responses.push_back(GetResponse(*it));
+  }
+  return responses;
+}
+
+Value JsonReader::GetValue()
+{
+  Parse();
+  return GetValue(myDocument);
+}
+
+Response JsonReader::InvokeRequest(const Dispatcher& dispatcher)
+{
+  JsonRequestHandler handler(
+    dispatcher, myTypeInference, myStringsByReference, myAttachments);
+  rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>,
+                           JsonAllocatorPool::Allocator>
+    reader(&myLease.GetAllocator());
+  rapidjson::InsituStringStream stream(&myData[0]);
+  reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+
+  if (handler.IsInvalid()) {
     throw InvalidRequestFault();
   }
+  else if (reader.HasParseError()) {
+    throw ParseErrorFault(
+      "Parse error: " + std::to_string(reader.GetParseErrorCode()));
+  }
+  return handler.Invoke();
+}
 
-  ValidateJsonrpcVersion();
+void JsonReader::Parse()
+{
+  if (!myIsParsed) {
+    // Only strings can contain non-ASCII characters, so checking the whole
+    // document checks them all
+    if (myValidateUtf8 && !util::IsValidUtf8(myData.data(), myData.size())) {
+      throw ParseErrorFault("Parse error: invalid UTF-8");
+    }
+    // Parse in place so that strings in the document point into myData
+    // instead of being copied into the document's allocator
+    myDocument.ParseInsitu(&myData[0]);
+    myIsParsed = true;
+  }
+  if (myDocument.HasParseError()) {
+    throw ParseErrorFault(
+      "Parse error: " + std::to_string(myDocument.GetParseError()));
+  }
+}
 
-  auto id = myDocument.FindMember(ID_NAME);
-  if (id == myDocument.MemberEnd()) {
+void JsonReader::ValidateJsonrpcVersion(const rapidjson::Value& object) const
+{
+  auto jsonrpc = object.FindMember(JSONRPC_NAME);
+  if (jsonrpc == object.MemberEnd()
+      || !jsonrpc->value.IsString()
+      || strcmp(jsonrpc->value.GetString(), JSONRPC_VERSION_2_0) != 0) {
     throw InvalidRequestFault();
   }
+}
 
-  auto result = myDocument.FindMember(RESULT_NAME);
-  auto error = myDocument.FindMember(ERROR_NAME);
+Response JsonReader::GetResponse(const rapidjson::Value& response) const
+{
+  if (!response.IsObject()) {
+    throw InvalidRequestFault();
+  }
+
+  ValidateJsonrpcVersion(response);
 
-  if (result != myDocument.MemberEnd()) {
-    if (error != myDocument.MemberEnd()) {
+  auto id = response.FindMember(ID_NAME);
+  if (id == response.MemberEnd()) {
+    throw InvalidRequestFault();
+  }
+
+  auto result = response.FindMember(RESULT_NAME);
+  auto error = response.FindMember(ERROR_NAME);
+
+  if (result != response.MemberEnd()) {
+    if (error != response.MemberEnd()) {
       throw InvalidRequestFault();
     }
     return Response(GetValue(result->value), GetId(id->value));
   }
-  else if (error != myDocument.MemberEnd()) {
-    if (result != myDocument.MemberEnd()) {
+  else if (error != response.MemberEnd()) {
+    if (result != response.MemberEnd()) {
       throw InvalidRequestFault();
     }
     if (!error->value.IsObject()) {
@@ -119,21 +311,6 @@ Response JsonReader::GetResponse()
   }
 }
 
-Value JsonReader::GetValue()
-{
-  return GetValue(myDocument);
-}
-
-void JsonReader::ValidateJsonrpcVersion() const
-{
-  auto jsonrpc = myDocument.FindMember(JSONRPC_NAME);
-  if (jsonrpc == myDocument.MemberEnd()
-      || !jsonrpc->value.IsString()
-      || strcmp(jsonrpc->value.GetString(), JSONRPC_VERSION_2_0) != 0) {
-    throw InvalidRequestFault();
-  }
-}
-
 Value JsonReader::GetValue(const rapidjson::Value& value) const
 {
   switch (value.GetType()) {
@@ -151,6 +328,35 @@ Value JsonReader::GetValue(const rapidjson::Value& value) const
       return Value(std::move(data));
     }
     case rapidjson::kArrayType: {
+      switch (GetPackableType(value)) {
+        case Value::Type::INTEGER_32: {
+          std::vector<int32_t> array;
+          array.reserve(value.Size());
+          for (auto it = value.Begin(); it != value.End(); ++it) {
+            array.push_back(it->GetInt());
+          }
+          return Value(std::move(array));
+        }
+        case Value::Type::INTEGER_64: {
+          std::vector<int64_t> array;
+          array.reserve(value.Size());
+          for (auto it = value.Begin(); it != value.End(); ++it) {
+            array.push_back(it->GetInt64());
+          }
+          return Value(std::move(array));
+        }
+        case Value::Type::DOUBLE: {
+          std::vector<double> array;
+          array.reserve(value.Size());
+          for (auto it = value.Begin(); it != value.End(); ++it) {
+            array.push_back(it->GetDouble());
+          }
+          return Value(std::move(array));
+        }
+        default:
+          break;
+      }
+
       Value::Array array;
       array.reserve(value.Size());
       for (auto it = value.Begin(); it != value.End(); ++it) {
@@ -159,14 +365,21 @@ Value JsonReader::GetValue(const rapidjson::Value& value) const
       return Value(std::move(array));
     }
     case rapidjson::kStringType: {
-      tm dt;
-      if (util::ParseIso8601DateTime(value.GetString(), dt)) {
+      const char* data = value.GetString();
+      const size_t size = value.GetStringLength();
+
+      Value::DateTime dt;
+      if (myTypeInference && util::MaybeIso8601DateTime(data, size)
+          && util::ParseIso8601DateTime(data, size, dt)) {
         return Value(dt);
       }
 
-      std::string str(value.GetString(), value.GetStringLength());
-      const bool binary = str.find('\0') != std::string::npos;
-      return Value(std::move(str), binary);
+      const bool binary =
+        myTypeInference && memchr(data, '\0', size) != nullptr;
+      if (myStringsByReference) {
+        return Value(Value::StringRef{data, size}, binary);
+      }
+      return Value(std::string(data, size), binary);
     }
     case rapidjson::kNumberType:
       if (value.IsDouble()) {
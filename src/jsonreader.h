@@ -20,28 +20,103 @@
 
 #include "reader.h"
 
+#include <memory>
+#include <mutex>
 #include <rapidjson/document.h>
 #include <string>
+#include <vector>
 
 namespace xsonrpc {
 
+// Keeps the allocators of readers between requests. The first chunk of
+// each allocator is preallocated, sized after the largest parse seen so
+// far, so once warmed up a reader does not allocate while parsing. Arenas
+// are borrowed and returned under a lock, so readers on different threads
+// may share a pool (as the clients of a shared JsonFormatHandler do).
+class JsonAllocatorPool
+{
+public:
+  typedef rapidjson::MemoryPoolAllocator<> Allocator;
+
+  class Arena
+  {
+  public:
+    explicit Arena(size_t capacity);
+
+    Allocator& GetAllocator() { return myAllocator; }
+    size_t GetCapacity() const { return myCapacity; }
+
+  private:
+    size_t myCapacity;
+    std::unique_ptr<char[]> myBuffer;
+    Allocator myAllocator;
+  };
+
+  // Borrows an arena from a pool for as long as it lives
+  class Lease
+  {
+  public:
+    explicit Lease(std::shared_ptr<JsonAllocatorPool> pool);
+    ~Lease();
+
+    Allocator& GetAllocator() { return myArena->GetAllocator(); }
+
+  private:
+    std::shared_ptr<JsonAllocatorPool> myPool;
+    std::unique_ptr<Arena> myArena;
+  };
+
+  // The capacity of new arenas
+  size_t GetCapacity() const;
+
+private:
+  std::unique_ptr<Arena> Acquire();
+  void Release(std::unique_ptr<Arena> arena);
+
+  mutable std::mutex myMutex;
+  size_t myCapacity = INITIAL_CAPACITY;
+  std::vector<std::unique_ptr<Arena>> myArenas;
+
+  static const size_t INITIAL_CAPACITY = 4 * 1024;
+  static const size_t MAX_CAPACITY = 1024 * 1024;
+  static const size_t MAX_IDLE_ARENAS = 4;
+};
+
 class JsonReader final : public Reader
 {
 public:
-  JsonReader(std::string data);
+  // Without a pool the reader gets an allocator of its own
+  JsonReader(std::string data, bool typeInference = true,
+             bool validateUtf8 = false,
+             std::shared_ptr<JsonAllocatorPool> pool = nullptr);
 
   // Reader
+  void SetStringsByReference(bool byReference) override;
   Request GetRequest() override;
   Response GetResponse() override;
   Value GetValue() override;
+  std::vector<Response> GetBatchResponse() override;
+  // Parses the data in place, so nothing else can be read afterwards
+  Response InvokeRequest(const Dispatcher& dispatcher) override;
 
 private:
-  void ValidateJsonrpcVersion() const;
+  void Parse();
+  void ValidateJsonrpcVersion(const rapidjson::Value& object) const;
+  Response GetResponse(const rapidjson::Value& response) const;
   Value GetValue(const rapidjson::Value& value) const;
   Value GetId(const rapidjson::Value& id) const;
 
+  typedef rapidjson::GenericDocument<
+    rapidjson::UTF8<>, JsonAllocatorPool::Allocator,
+    JsonAllocatorPool::Allocator> Document;
+
   std::string myData;
-  rapidjson::Document myDocument;
+  JsonAllocatorPool::Lease myLease;
+  Document myDocument;
+  bool myTypeInference;
+  bool myValidateUtf8;
+  bool myStringsByReference = false;
+  bool myIsParsed = false;
 };
 
 } // namespace xsonrpc
@@ -0,0 +1,324 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "jsonrequesthandler.h"
+
+#include "fault.h"
+#include "json.h"
+#include "util.h"
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+template<size_t N>
+bool IsName(const char* str, size_t length, const char (&name)[N])
+{
+  return length == N - 1 && memcmp(str, name, length) == 0;
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+JsonRequestHandler::JsonRequestHandler(
+  const Dispatcher& dispatcher, bool typeInference, bool stringsByReference,
+  const Attachments* attachments)
+  : myDispatcher(dispatcher),
+    myTypeInference(typeInference),
+    myAttachments(attachments),
+    myBuilder(stringsByReference)
+{
+}
+
+Response JsonRequestHandler::Invoke()
+{
+  if (!myHasVersion || !myHasMethod) {
+    throw InvalidRequestFault();
+  }
+
+  if (myDecoder) {
+    return myDispatcher.Invoke(*myDecoder, myId);
+  }
+  if (myAttachments) {
+    for (auto& parameter : myParameters) {
+      parameter = ResolveAttachments(
+        std::move(parameter), *myAttachments, true);
+    }
+  }
+  return myDispatcher.Invoke(myMethodName, myParameters, myId);
+}
+
+bool JsonRequestHandler::Null()
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->Nil();
+    return EndValue();
+  }
+  return Scalar(true, {});
+}
+
+bool JsonRequestHandler::Bool(bool b)
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->Boolean(b);
+    return EndValue();
+  }
+  return Scalar(false);
+}
+
+bool JsonRequestHandler::Int(int i)
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->Integer32(i);
+    return EndValue();
+  }
+  return Scalar(true, i);
+}
+
+bool JsonRequestHandler::Uint(unsigned u)
+{
+  if (u <= static_cast<unsigned>(std::numeric_limits<int32_t>::max())) {
+    return Int(static_cast<int>(u));
+  }
+  return Int64(u);
+}
+
+bool JsonRequestHandler::Int64(int64_t i)
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->Integer64(i);
+    return EndValue();
+  }
+  return Scalar(true, i);
+}
+
+bool JsonRequestHandler::Uint64(uint64_t u)
+{
+  if (u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    return Int64(static_cast<int64_t>(u));
+  }
+  if (IsInParameters()) {
+    return Double(static_cast<double>(u));
+  }
+  return Scalar(false);
+}
+
+bool JsonRequestHandler::Double(double d)
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->Double(d);
+    return EndValue();
+  }
+  return Scalar(false);
+}
+
+bool JsonRequestHandler::String(
+  const char* str, rapidjson::SizeType length, bool /*copy*/)
+{
+  if (IsInParameters()) {
+    StartValue();
+    Value::DateTime dt;
+    if (myTypeInference && util::MaybeIso8601DateTime(str, length)
+        && util::ParseIso8601DateTime(str, length, dt)) {
+      myHandler->DateTime(dt);
+    }
+    else if (myTypeInference && memchr(str, '\0', length) != nullptr) {
+      myHandler->Binary(str, length);
+    }
+    else {
+      myHandler->String(str, length);
+    }
+    return EndValue();
+  }
+
+  if (myDepth == 1 && myMember == Member::JSONRPC) {
+    myHasVersion = true;
+    return IsName(str, length, json::JSONRPC_VERSION_2_0) || Invalid();
+  }
+  else if (myDepth == 1 && myMember == Member::METHOD) {
+    myHasMethod = true;
+    myMethodName.assign(str, length);
+    if (!myHasParams) {
+      myDecoder = CreateParameterDecoder(
+        myDispatcher, myMethodName, myAttachments);
+    }
+    return true;
+  }
+  return Scalar(true, std::string(str, length));
+}
+
+bool JsonRequestHandler::StartObject()
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->StartStruct();
+  }
+  else if (myDepth == 1 && myMember != Member::OTHER) {
+    return Invalid();
+  }
+  ++myDepth;
+  return true;
+}
+
+bool JsonRequestHandler::Key(
+  const char* str, rapidjson::SizeType length, bool /*copy*/)
+{
+  using namespace json;
+
+  if (IsInParameters()) {
+    myHandler->StartStructElement(str, length);
+  }
+  else if (myDepth == 1) {
+    if (IsName(str, length, JSONRPC_NAME)) {
+      myMember = Member::JSONRPC;
+      return !myHasVersion || Invalid();
+    }
+    else if (IsName(str, length, METHOD_NAME)) {
+      myMember = Member::METHOD;
+      return !myHasMethod || Invalid();
+    }
+    else if (IsName(str, length, PARAMS_NAME)) {
+      myMember = Member::PARAMS;
+      return !myHasParams || Invalid();
+    }
+    else if (IsName(str, length, ID_NAME)) {
+      myMember = Member::ID;
+      return !myHasId || Invalid();
+    }
+    myMember = Member::OTHER;
+  }
+  return true;
+}
+
+bool JsonRequestHandler::EndObject(rapidjson::SizeType /*memberCount*/)
+{
+  --myDepth;
+  if (IsInParameters()) {
+    myHandler->EndStruct();
+    return EndValue();
+  }
+  return true;
+}
+
+bool JsonRequestHandler::StartArray()
+{
+  if (IsInParameters()) {
+    StartValue();
+    myHandler->StartArray();
+  }
+  else if (myDepth == 1 && myMember == Member::PARAMS) {
+    myHasParams = true;
+    myParametersDepth = myDepth + 1;
+    if (myDecoder) {
+      myHandler = myDecoder.get();
+    }
+    else {
+      myHandler = &myBuilder;
+    }
+  }
+  else if (myDepth == 0
+           || (myDepth == 1 && myMember != Member::OTHER)) {
+    return Invalid();
+  }
+  ++myDepth;
+  return true;
+}
+
+bool JsonRequestHandler::EndArray(rapidjson::SizeType /*elementCount*/)
+{
+  if (IsInParameters() && myDepth == myParametersDepth) {
+    myParametersDepth = 0;
+  }
+  --myDepth;
+  if (IsInParameters()) {
+    myHandler->EndArray();
+    return EndValue();
+  }
+  return true;
+}
+
+bool JsonRequestHandler::Invalid()
+{
+  myIsInvalid = true;
+  return false;
+}
+
+bool JsonRequestHandler::Scalar(bool isValidId, Value id)
+{
+  if (myDepth == 0) {
+    return Invalid();
+  }
+  else if (myDepth > 1) {
+    return true;
+  }
+
+  switch (myMember) {
+    case Member::ID:
+      myHasId = true;
+      if (!isValidId) {
+        return Invalid();
+      }
+      myId = std::move(id);
+      return true;
+    case Member::OTHER:
+      return true;
+    default:
+      return Invalid();
+  }
+}
+
+bool JsonRequestHandler::IsInParameters() const
+{
+  return myParametersDepth != 0 && myDepth >= myParametersDepth;
+}
+
+void JsonRequestHandler::StartValue()
+{
+  if (myDepth != myParametersDepth) {
+    return;
+  }
+  if (myDecoder) {
+    myDecoder->StartParameter();
+  }
+  else {
+    myBuilder.Reset();
+  }
+}
+
+bool JsonRequestHandler::EndValue()
+{
+  if (myDepth != myParametersDepth) {
+    return true;
+  }
+  if (myDecoder) {
+    myDecoder->EndParameter();
+  }
+  else {
+    myParameters.push_back(std::move(myBuilder.GetValue()));
+  }
+  return true;
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,110 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_JSONREQUESTHANDLER_H
+#define XSONRPC_JSONREQUESTHANDLER_H
+
+#include "attachments.h"
+#include "dispatcher.h"
+#include "request.h"
+#include "response.h"
+#include "valuehandler.h"
+
+#include <memory>
+#include <rapidjson/rapidjson.h>
+#include <string>
+
+namespace xsonrpc {
+
+// Reads a request from the events of a rapidjson SAX parser. If the method
+// is known before the parameters, they are passed to the decoder of the
+// method instead of being built as values. The parameters may reference
+// attachments, see Reader::SetAttachments.
+class JsonRequestHandler
+{
+public:
+  JsonRequestHandler(const Dispatcher& dispatcher,
+                     bool typeInference, bool stringsByReference,
+                     const Attachments* attachments = nullptr);
+
+  // Set when an event was rejected because the request is invalid
+  bool IsInvalid() const { return myIsInvalid; }
+  // A request without an id gets no response
+  bool IsNotification() const { return !myHasId; }
+
+  // Throws InvalidRequestFault if the request is incomplete
+  Response Invoke();
+
+  // rapidjson handler
+  bool Null();
+  bool Bool(bool b);
+  bool Int(int i);
+  bool Uint(unsigned u);
+  bool Int64(int64_t i);
+  bool Uint64(uint64_t u);
+  bool Double(double d);
+  bool String(const char* str, rapidjson::SizeType length, bool copy);
+  bool StartObject();
+  bool Key(const char* str, rapidjson::SizeType length, bool copy);
+  bool EndObject(rapidjson::SizeType memberCount);
+  bool StartArray();
+  bool EndArray(rapidjson::SizeType elementCount);
+
+private:
+  enum class Member
+  {
+    JSONRPC,
+    METHOD,
+    PARAMS,
+    ID,
+    OTHER
+  };
+
+  bool Invalid();
+  // A scalar outside of the parameters
+  bool Scalar(bool isValidId, Value id = {});
+  bool IsInParameters() const;
+  // Called around each value in the parameters
+  void StartValue();
+  bool EndValue();
+
+  const Dispatcher& myDispatcher;
+  const bool myTypeInference;
+  const Attachments* myAttachments;
+
+  size_t myDepth = 0;
+  size_t myParametersDepth = 0;
+  Member myMember = Member::OTHER;
+  bool myIsInvalid = false;
+
+  bool myHasVersion = false;
+  bool myHasMethod = false;
+  bool myHasParams = false;
+  bool myHasId = false;
+  std::string myMethodName;
+  Value myId = false;
+
+  std::unique_ptr<ParameterDecoder> myDecoder;
+  ValueBuilder myBuilder;
+  Request::Parameters myParameters;
+  ValueHandler* myHandler = nullptr;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,584 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "jsonrequestparser.h"
+
+#include "fault.h"
+#include "textscan.h"
+#include "util.h"
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+bool IsWhitespace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsDigit(char c)
+{
+  return static_cast<unsigned>(c - '0') <= 9;
+}
+
+bool IsNumberCharacter(char c)
+{
+  return IsDigit(c) || c == '-' || c == '+' || c == '.'
+    || c == 'e' || c == 'E';
+}
+
+// Validates a number against the JSON grammar and tells if it is an integer
+bool IsValidNumber(const std::string& number, bool& isInteger)
+{
+  auto it = number.begin();
+  const auto end = number.end();
+  if (it != end && *it == '-') {
+    ++it;
+  }
+  if (it == end || !IsDigit(*it)) {
+    return false;
+  }
+  if (*it++ == '0' && it != end && IsDigit(*it)) {
+    return false;
+  }
+  while (it != end && IsDigit(*it)) {
+    ++it;
+  }
+
+  isInteger = it == end;
+  if (it != end && *it == '.') {
+    if (++it == end || !IsDigit(*it)) {
+      return false;
+    }
+    while (it != end && IsDigit(*it)) {
+      ++it;
+    }
+  }
+  if (it != end && (*it == 'e' || *it == 'E')) {
+    if (++it != end && (*it == '+' || *it == '-')) {
+      ++it;
+    }
+    if (it == end || !IsDigit(*it)) {
+      return false;
+    }
+    while (it != end && IsDigit(*it)) {
+      ++it;
+    }
+  }
+  return it == end;
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+JsonRequestParser::JsonRequestParser(
+  const Dispatcher& dispatcher, bool typeInference, bool validateUtf8,
+  std::shared_ptr<JsonAllocatorPool> pool)
+  : myDispatcher(dispatcher),
+    myTypeInference(typeInference),
+    myValidateUtf8(validateUtf8),
+    myLease(std::move(pool))
+{
+}
+
+void JsonRequestParser::Parse(const char* data, size_t size)
+{
+  const char* pos = data;
+  const char* const end = data + size;
+
+  while (pos != end) {
+    switch (myState) {
+      case State::STRING:
+        pos = ParseString(pos, end);
+        break;
+      case State::ESCAPE:
+        ParseEscape(*pos++);
+        break;
+      case State::UNICODE_ESCAPE:
+        ParseUnicodeEscape(*pos++);
+        break;
+      case State::NUMBER:
+        pos = ParseNumber(pos, end);
+        break;
+      case State::LITERAL:
+        pos = ParseLiteral(pos, end);
+        break;
+      default:
+        ParseStructural(*pos++);
+        break;
+    }
+  }
+}
+
+std::vector<Response> JsonRequestParser::InvokeRequests()
+{
+  // A number at the end of the data has nothing after it to end it
+  if (myState == State::NUMBER) {
+    EndNumber();
+  }
+  if (myState != State::DONE) {
+    throw ParseErrorFault("Parse error: incomplete request");
+  }
+  else if (myRequests.empty()) {
+    // An empty batch
+    throw InvalidRequestFault();
+  }
+
+  std::vector<Response> responses;
+  if (!myIsBatch) {
+    auto& request = *myRequests.front();
+    auto response = request.Invoke();
+    if (!request.IsNotification()) {
+      responses.push_back(std::move(response));
+    }
+    return responses;
+  }
+
+  // Methods need not be thread safe, so the requests are invoked in order
+  for (auto& request : myRequests) {
+    try {
+      if (request->IsInvalid()) {
+        throw InvalidRequestFault();
+      }
+      auto response = request->Invoke();
+      if (!request->IsNotification()) {
+        responses.push_back(std::move(response));
+      }
+    }
+    catch (const Fault& ex) {
+      responses.emplace_back(ex.GetCode(), ex.GetString(), Value());
+    }
+  }
+  return responses;
+}
+
+bool JsonRequestParser::IsBatch() const
+{
+  return myIsBatch;
+}
+
+void JsonRequestParser::ParseStructural(char c)
+{
+  if (IsWhitespace(c)) {
+    return;
+  }
+
+  switch (myState) {
+    case State::VALUE:
+      StartValue(c);
+      return;
+
+    case State::FIRST_ELEMENT:
+      if (c == ']') {
+        EndContainer(false);
+      }
+      else {
+        StartValue(c);
+      }
+      return;
+
+    case State::FIRST_MEMBER:
+      if (c == '}') {
+        EndContainer(true);
+        return;
+      }
+      // Fall through
+    case State::KEY:
+      if (c != '"') {
+        break;
+      }
+      myToken.clear();
+      myIsKey = true;
+      myState = State::STRING;
+      return;
+
+    case State::COLON:
+      if (c != ':') {
+        break;
+      }
+      myState = State::VALUE;
+      return;
+
+    case State::SEPARATOR:
+      if (c == ',') {
+        myState = myContainers.back().IsObject ? State::KEY : State::VALUE;
+        return;
+      }
+      else if (c == '}' || c == ']') {
+        EndContainer(c == '}');
+        return;
+      }
+      break;
+
+    default:
+      break;
+  }
+  throw ParseErrorFault(
+    std::string("Parse error: unexpected character '") + c + "'");
+}
+
+void JsonRequestParser::StartValue(char c)
+{
+  switch (c) {
+    case '{':
+      Emit(true, [] (JsonRequestHandler& request) {
+        return request.StartObject();
+      });
+      myContainers.push_back({true, 0});
+      myState = State::FIRST_MEMBER;
+      break;
+    case '[':
+      if (myContainers.empty()) {
+        myIsBatch = true;
+      }
+      Emit(true, [] (JsonRequestHandler& request) {
+        return request.StartArray();
+      });
+      myContainers.push_back({false, 0});
+      myState = State::FIRST_ELEMENT;
+      break;
+    case '"':
+      myToken.clear();
+      myIsKey = false;
+      myState = State::STRING;
+      break;
+    case 't':
+    case 'f':
+    case 'n':
+      myLiteral = c == 't' ? "true" : c == 'f' ? "false" : "null";
+      myToken.assign(1, c);
+      myState = State::LITERAL;
+      break;
+    default:
+      if (c != '-' && !IsDigit(c)) {
+        throw ParseErrorFault(
+          std::string("Parse error: unexpected character '") + c + "'");
+      }
+      myToken.assign(1, c);
+      myState = State::NUMBER;
+      break;
+  }
+}
+
+void JsonRequestParser::EndValue()
+{
+  if (myContainers.empty()) {
+    myState = State::DONE;
+  }
+  else {
+    ++myContainers.back().Count;
+    myState = State::SEPARATOR;
+  }
+}
+
+void JsonRequestParser::EndContainer(bool isObject)
+{
+  const auto container = myContainers.back();
+  if (container.IsObject != isObject) {
+    throw ParseErrorFault("Parse error: mismatched brackets");
+  }
+  myContainers.pop_back();
+
+  if (isObject) {
+    Emit(false, [&] (JsonRequestHandler& request) {
+      return request.EndObject(container.Count);
+    });
+  }
+  else {
+    Emit(false, [&] (JsonRequestHandler& request) {
+      return request.EndArray(container.Count);
+    });
+  }
+  EndValue();
+}
+
+const char* JsonRequestParser::ParseString(const char* pos, const char* end)
+{
+  // The low surrogate must follow the high one directly
+  if (myHighSurrogate != 0 && *pos != '\\') {
+    throw ParseErrorFault("Parse error: unpaired surrogate");
+  }
+
+  const char* start = pos;
+  pos += util::FindJsonEscape(pos, end - pos);
+  myToken.append(start, pos);
+
+  if (pos == end) {
+    return pos;
+  }
+  else if (*pos == '"') {
+    EndString();
+  }
+  else if (*pos == '\\') {
+    myState = State::ESCAPE;
+  }
+  else {
+    throw ParseErrorFault("Parse error: control character in string");
+  }
+  return pos + 1;
+}
+
+void JsonRequestParser::ParseEscape(char c)
+{
+  if (myHighSurrogate != 0 && c != 'u') {
+    throw ParseErrorFault("Parse error: unpaired surrogate");
+  }
+
+  myState = State::STRING;
+  switch (c) {
+    case '"': myToken += '"'; break;
+    case '\\': myToken += '\\'; break;
+    case '/': myToken += '/'; break;
+    case 'b': myToken += '\b'; break;
+    case 'f': myToken += '\f'; break;
+    case 'n': myToken += '\n'; break;
+    case 'r': myToken += '\r'; break;
+    case 't': myToken += '\t'; break;
+    case 'u':
+      myCodePoint = 0;
+      myHexDigits = 0;
+      myState = State::UNICODE_ESCAPE;
+      break;
+    default:
+      throw ParseErrorFault("Parse error: invalid escape");
+  }
+}
+
+void JsonRequestParser::ParseUnicodeEscape(char c)
+{
+  unsigned digit;
+  if (IsDigit(c)) {
+    digit = c - '0';
+  }
+  else if (c >= 'a' && c <= 'f') {
+    digit = c - 'a' + 10;
+  }
+  else if (c >= 'A' && c <= 'F') {
+    digit = c - 'A' + 10;
+  }
+  else {
+    throw ParseErrorFault("Parse error: invalid unicode escape");
+  }
+
+  myCodePoint = (myCodePoint << 4) | digit;
+  if (++myHexDigits < 4) {
+    return;
+  }
+
+  myState = State::STRING;
+  if (myHighSurrogate != 0) {
+    if (myCodePoint < 0xDC00 || myCodePoint > 0xDFFF) {
+      throw ParseErrorFault("Parse error: unpaired surrogate");
+    }
+    AppendUtf8(0x10000 + ((myHighSurrogate - 0xD800) << 10)
+               + (myCodePoint - 0xDC00));
+    myHighSurrogate = 0;
+  }
+  else if (myCodePoint >= 0xD800 && myCodePoint <= 0xDBFF) {
+    myHighSurrogate = myCodePoint;
+  }
+  else if (myCodePoint >= 0xDC00 && myCodePoint <= 0xDFFF) {
+    throw ParseErrorFault("Parse error: unpaired surrogate");
+  }
+  else {
+    AppendUtf8(myCodePoint);
+  }
+}
+
+void JsonRequestParser::AppendUtf8(uint32_t c)
+{
+  if (c < 0x80) {
+    myToken += static_cast<char>(c);
+  }
+  else if (c < 0x800) {
+    myToken += static_cast<char>(0xC0 | (c >> 6));
+    myToken += static_cast<char>(0x80 | (c & 0x3F));
+  }
+  else if (c < 0x10000) {
+    myToken += static_cast<char>(0xE0 | (c >> 12));
+    myToken += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    myToken += static_cast<char>(0x80 | (c & 0x3F));
+  }
+  else {
+    myToken += static_cast<char>(0xF0 | (c >> 18));
+    myToken += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    myToken += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    myToken += static_cast<char>(0x80 | (c & 0x3F));
+  }
+}
+
+void JsonRequestParser::EndString()
+{
+  if (myValidateUtf8 && !util::IsValidUtf8(myToken.data(), myToken.size())) {
+    throw ParseErrorFault("Parse error: invalid UTF-8");
+  }
+
+  // Values may reference the string until the request has been invoked
+  const auto length = static_cast<rapidjson::SizeType>(myToken.size());
+  char* str = static_cast<char*>(myLease.GetAllocator().Malloc(length + 1));
+  memcpy(str, myToken.data(), length);
+  str[length] = '\0';
+
+  if (myIsKey) {
+    Emit(false, [&] (JsonRequestHandler& request) {
+      return request.Key(str, length, false);
+    });
+    myState = State::COLON;
+  }
+  else {
+    Emit(true, [&] (JsonRequestHandler& request) {
+      return request.String(str, length, false);
+    });
+    EndValue();
+  }
+}
+
+const char* JsonRequestParser::ParseNumber(const char* pos, const char* end)
+{
+  const char* start = pos;
+  while (pos != end && IsNumberCharacter(*pos)) {
+    ++pos;
+  }
+  myToken.append(start, pos);
+
+  if (pos != end) {
+    // The character after the number is parsed in the next state
+    EndNumber();
+  }
+  return pos;
+}
+
+void JsonRequestParser::EndNumber()
+{
+  bool isInteger;
+  if (!IsValidNumber(myToken, isInteger)) {
+    throw ParseErrorFault("Parse error: invalid number");
+  }
+
+  if (isInteger) {
+    const bool negative = myToken[0] == '-';
+    const uint64_t limit = negative
+      ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1
+      : std::numeric_limits<uint64_t>::max();
+
+    uint64_t value = 0;
+    bool overflow = false;
+    for (size_t i = negative ? 1 : 0; i < myToken.size(); ++i) {
+      const unsigned digit = myToken[i] - '0';
+      if (value > (limit - digit) / 10) {
+        overflow = true;
+        break;
+      }
+      value = value * 10 + digit;
+    }
+
+    if (!overflow) {
+      if (negative) {
+        if (value <= static_cast<uint64_t>(
+              std::numeric_limits<int32_t>::max()) + 1) {
+          const auto i = static_cast<int>(-static_cast<int64_t>(value));
+          Emit(true, [&] (JsonRequestHandler& request) {
+            return request.Int(i);
+          });
+        }
+        else {
+          const auto i = static_cast<int64_t>(0 - value);
+          Emit(true, [&] (JsonRequestHandler& request) {
+            return request.Int64(i);
+          });
+        }
+      }
+      else if (value <= std::numeric_limits<uint32_t>::max()) {
+        const auto u = static_cast<unsigned>(value);
+        Emit(true, [&] (JsonRequestHandler& request) {
+          return request.Uint(u);
+        });
+      }
+      else {
+        Emit(true, [&] (JsonRequestHandler& request) {
+          return request.Uint64(value);
+        });
+      }
+      EndValue();
+      return;
+    }
+  }
+
+  double value;
+  if (!util::ParseDouble(myToken.data(), myToken.size(), value)) {
+    throw ParseErrorFault("Parse error: invalid number");
+  }
+  Emit(true, [&] (JsonRequestHandler& request) {
+    return request.Double(value);
+  });
+  EndValue();
+}
+
+const char* JsonRequestParser::ParseLiteral(const char* pos, const char* end)
+{
+  const size_t length = strlen(myLiteral);
+  while (pos != end && myToken.size() < length) {
+    if (*pos != myLiteral[myToken.size()]) {
+      throw ParseErrorFault("Parse error: invalid literal");
+    }
+    myToken += *pos++;
+  }
+
+  if (myToken.size() == length) {
+    const char literal = myLiteral[0];
+    Emit(true, [&] (JsonRequestHandler& request) {
+      return literal == 'n' ? request.Null() : request.Bool(literal == 't');
+    });
+    EndValue();
+  }
+  return pos;
+}
+
+template<typename Event>
+void JsonRequestParser::Emit(bool startsValue, Event event)
+{
+  // In a batch, the requests are the elements of the array
+  const size_t depth = myIsBatch ? 1 : 0;
+  if (myContainers.size() < depth) {
+    return;
+  }
+  if (startsValue && myContainers.size() == depth) {
+    myRequests.emplace_back(
+      new JsonRequestHandler(myDispatcher, myTypeInference, true,
+                             myAttachments));
+  }
+
+  // An invalid request in a batch gets a fault response of its own, so
+  // the rest of it is skipped, while a single one fails right away
+  auto& request = *myRequests.back();
+  if (myIsBatch) {
+    if (!request.IsInvalid()) {
+      event(request);
+    }
+  }
+  else if (!event(request)) {
+    if (request.IsInvalid()) {
+      throw InvalidRequestFault();
+    }
+    throw ParseErrorFault("Parse error: request rejected");
+  }
+}
+
+} // namespace xsonrpc
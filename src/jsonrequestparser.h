@@ -0,0 +1,109 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_JSONREQUESTPARSER_H
+#define XSONRPC_JSONREQUESTPARSER_H
+
+#include "jsonreader.h"
+#include "jsonrequesthandler.h"
+#include "requestparser.h"
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace xsonrpc {
+
+// Push parser for JSON-RPC requests and batches. Tokens split between parts
+// of the data are collected in a buffer; strings are then copied to an arena
+// from the pool, so that values can reference them.
+class JsonRequestParser final : public RequestParser
+{
+public:
+  JsonRequestParser(const Dispatcher& dispatcher, bool typeInference,
+                    bool validateUtf8,
+                    std::shared_ptr<JsonAllocatorPool> pool);
+
+  // RequestParser
+  void Parse(const char* data, size_t size) override;
+  std::vector<Response> InvokeRequests() override;
+  bool IsBatch() const override;
+
+private:
+  enum class State
+  {
+    VALUE,
+    FIRST_ELEMENT,
+    FIRST_MEMBER,
+    KEY,
+    COLON,
+    SEPARATOR,
+    DONE,
+
+    STRING,
+    ESCAPE,
+    UNICODE_ESCAPE,
+    NUMBER,
+    LITERAL
+  };
+
+  struct Container
+  {
+    bool IsObject;
+    rapidjson::SizeType Count;
+  };
+
+  void ParseStructural(char c);
+  void StartValue(char c);
+  void EndValue();
+  void EndContainer(bool isObject);
+
+  const char* ParseString(const char* pos, const char* end);
+  void ParseEscape(char c);
+  void ParseUnicodeEscape(char c);
+  void AppendUtf8(uint32_t c);
+  void EndString();
+  const char* ParseNumber(const char* pos, const char* end);
+  void EndNumber();
+  const char* ParseLiteral(const char* pos, const char* end);
+
+  // Passes an event to the request it belongs to
+  template<typename Event>
+  void Emit(bool startsValue, Event event);
+
+  const Dispatcher& myDispatcher;
+  const bool myTypeInference;
+  const bool myValidateUtf8;
+  JsonAllocatorPool::Lease myLease;
+  std::vector<std::unique_ptr<JsonRequestHandler>> myRequests;
+  bool myIsBatch = false;
+
+  State myState = State::VALUE;
+  std::vector<Container> myContainers;
+  std::string myToken;
+  bool myIsKey = false;
+  const char* myLiteral = nullptr;
+  uint32_t myCodePoint = 0;
+  unsigned myHexDigits = 0;
+  uint32_t myHighSurrogate = 0;
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -18,13 +18,80 @@
 #include "jsonwriter.h"
 
 #include "json.h"
+#include "textscan.h"
 #include "util.h"
 #include "value.h"
+#include "valueserializer.h"
+
+#include <cstring>
 
 namespace xsonrpc {
 
 using namespace json;
 
+JsonWriter::StringWriter::StringWriter(rapidjson::StringBuffer& buffer)
+  : Writer(buffer)
+{
+}
+
+bool JsonWriter::StringWriter::String(
+  const char* str, rapidjson::SizeType length, bool /*copy*/)
+{
+  Prefix(rapidjson::kStringType);
+  WriteEscaped(str, length);
+  return true;
+}
+
+bool JsonWriter::StringWriter::Key(
+  const char* str, rapidjson::SizeType length, bool copy)
+{
+  return String(str, length, copy);
+}
+
+void JsonWriter::StringWriter::RawValue(const char* data, size_t size)
+{
+  // Any type but string, which is only checked for keys
+  Prefix(rapidjson::kNullType);
+  memcpy(os_->Push(size), data, size);
+}
+
+void JsonWriter::StringWriter::WriteEscaped(const char* str, size_t length)
+{
+  // Escaped as by rapidjson::Writer::WriteString, with UTF-8 copied as is
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+  const char* end = str + length;
+  os_->Put('"');
+  while (true) {
+    const size_t size = util::FindJsonEscape(str, end - str);
+    memcpy(os_->Push(size), str, size);
+    str += size;
+    if (str == end) {
+      break;
+    }
+
+    const unsigned char c = *str++;
+    os_->Put('\\');
+    switch (c) {
+      case '"': os_->Put('"'); break;
+      case '\\': os_->Put('\\'); break;
+      case '\b': os_->Put('b'); break;
+      case '\f': os_->Put('f'); break;
+      case '\n': os_->Put('n'); break;
+      case '\r': os_->Put('r'); break;
+      case '\t': os_->Put('t'); break;
+      default:
+        os_->Put('u');
+        os_->Put('0');
+        os_->Put('0');
+        os_->Put(HEX_DIGITS[c >> 4]);
+        os_->Put(HEX_DIGITS[c & 0xf]);
+        break;
+    }
+  }
+  os_->Put('"');
+}
+
 JsonWriter::JsonWriter()
   : myWriter(myStringBuffer)
 {
@@ -40,6 +107,11 @@ size_t JsonWriter::GetSize()
   return myStringBuffer.GetSize();
 }
 
+void JsonWriter::ClearData()
+{
+  myStringBuffer.Clear();
+}
+
 void JsonWriter::StartDocument()
 {
   // Empty
@@ -50,6 +122,16 @@ void JsonWriter::EndDocument()
   // Empty
 }
 
+void JsonWriter::StartBatch()
+{
+  myWriter.StartArray();
+}
+
+void JsonWriter::EndBatch()
+{
+  myWriter.EndArray();
+}
+
 void JsonWriter::StartRequest(const std::string& methodName, const Value& id)
 {
   myWriter.StartObject();
@@ -153,11 +235,43 @@ void JsonWriter::StartStructElement(const std::string& name)
   myWriter.Key(name.data(), name.size(), true);
 }
 
+void JsonWriter::StartStructElement(const char* name)
+{
+  myWriter.Key(name, strlen(name), true);
+}
+
 void JsonWriter::EndStructElement()
 {
   // Empty
 }
 
+void JsonWriter::WriteArray(const int32_t* data, size_t size)
+{
+  myWriter.StartArray();
+  for (size_t i = 0; i < size; ++i) {
+    myWriter.Int(data[i]);
+  }
+  myWriter.EndArray();
+}
+
+void JsonWriter::WriteArray(const int64_t* data, size_t size)
+{
+  myWriter.StartArray();
+  for (size_t i = 0; i < size; ++i) {
+    myWriter.Int64(data[i]);
+  }
+  myWriter.EndArray();
+}
+
+void JsonWriter::WriteArray(const double* data, size_t size)
+{
+  myWriter.StartArray();
+  for (size_t i = 0; i < size; ++i) {
+    myWriter.Double(data[i]);
+  }
+  myWriter.EndArray();
+}
+
 void JsonWriter::WriteBinary(const char* data, size_t size)
 {
   myWriter.String(data, size, true);
@@ -193,9 +307,31 @@ void JsonWriter::Write(const std::string& value)
   myWriter.String(value.data(), value.size(), true);
 }
 
-void JsonWriter::Write(const tm& value)
+void JsonWriter::Write(const char* data, size_t size)
+{
+  myWriter.String(data, size, true);
+}
+
+void JsonWriter::Write(const Value::DateTime& value)
+{
+  char str[util::ISO_8601_DATE_TIME_MAX_LENGTH];
+  auto end = util::FormatIso8601DateTime(value, str);
+  myWriter.String(str, end - str, true);
+}
+
+bool JsonWriter::WriteRaw(Value::Format format, const char* data,
+                          size_t size)
+{
+  if (format != Value::Format::JSON) {
+    return false;
+  }
+  myWriter.RawValue(data, size);
+  return true;
+}
+
+void JsonWriter::WriteValue(const Value& value)
 {
-  Write(util::FormatIso8601DateTime(value));
+  SerializeValue(value, *this);
 }
 
 void JsonWriter::WriteId(const Value& id)
@@ -33,8 +33,11 @@ public:
   // Writer
   const char* GetData() override;
   size_t GetSize() override;
+  void ClearData() override;
   void StartDocument() override;
   void EndDocument() override;
+  void StartBatch() override;
+  void EndBatch() override;
   void StartRequest(const std::string& methodName, const Value& id) override;
   void EndRequest() override;
   void StartParameter() override;
@@ -49,7 +52,11 @@ public:
   void StartStruct() override;
   void EndStruct() override;
   void StartStructElement(const std::string& name) override;
+  void StartStructElement(const char* name) override;
   void EndStructElement() override;
+  void WriteArray(const int32_t* data, size_t size) override;
+  void WriteArray(const int64_t* data, size_t size) override;
+  void WriteArray(const double* data, size_t size) override;
   void WriteBinary(const char* data, size_t size) override;
   void WriteNull() override;
   void Write(bool value) override;
@@ -57,13 +64,34 @@ public:
   void Write(int32_t value) override;
   void Write(int64_t value) override;
   void Write(const std::string& value) override;
-  void Write(const tm& value) override;
+  void Write(const char* data, size_t size) override;
+  void Write(const Value::DateTime& value) override;
+  bool WriteRaw(Value::Format format, const char* data, size_t size) override;
+  void WriteValue(const Value& value) override;
 
 private:
+  // rapidjson's writer, but copying the runs of a string that need no
+  // escaping in one go, and able to copy raw values
+  class StringWriter : public rapidjson::Writer<rapidjson::StringBuffer>
+  {
+  public:
+    explicit StringWriter(rapidjson::StringBuffer& buffer);
+
+    using Writer::String;
+    bool String(const char* str, rapidjson::SizeType length,
+                bool copy = false);
+    using Writer::Key;
+    bool Key(const char* str, rapidjson::SizeType length, bool copy = false);
+    void RawValue(const char* data, size_t size);
+
+  private:
+    void WriteEscaped(const char* str, size_t length);
+  };
+
   void WriteId(const Value& id);
 
   rapidjson::StringBuffer myStringBuffer;
-  rapidjson::Writer<rapidjson::StringBuffer> myWriter;
+  StringWriter myWriter;
 };
 
 } // namespace xsonrpc
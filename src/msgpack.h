@@ -0,0 +1,87 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_MSGPACK_H
+#define XSONRPC_MSGPACK_H
+
+#include <cstdint>
+
+namespace xsonrpc {
+namespace msgpack {
+
+// Message types of MessagePack-RPC. A request is [REQUEST, id, method,
+// params], a response [RESPONSE, id, error, result] and a notification
+// [NOTIFICATION, method, params].
+const uint8_t REQUEST = 0;
+const uint8_t RESPONSE = 1;
+const uint8_t NOTIFICATION = 2;
+
+const char ERROR_CODE_NAME[] = "code";
+const char ERROR_MESSAGE_NAME[] = "message";
+
+// Format bytes. Those marked FIX hold the value or size in the low bits.
+const uint8_t POSITIVE_FIXINT_MAX = 0x7f;
+const uint8_t FIXMAP = 0x80;
+const uint8_t FIXARRAY = 0x90;
+const uint8_t FIXSTR = 0xa0;
+const uint8_t NIL = 0xc0;
+const uint8_t BOOLEAN_FALSE = 0xc2;
+const uint8_t BOOLEAN_TRUE = 0xc3;
+const uint8_t BIN_8 = 0xc4;
+const uint8_t BIN_16 = 0xc5;
+const uint8_t BIN_32 = 0xc6;
+const uint8_t EXT_8 = 0xc7;
+const uint8_t EXT_16 = 0xc8;
+const uint8_t EXT_32 = 0xc9;
+const uint8_t FLOAT_32 = 0xca;
+const uint8_t FLOAT_64 = 0xcb;
+const uint8_t UINT_8 = 0xcc;
+const uint8_t UINT_16 = 0xcd;
+const uint8_t UINT_32 = 0xce;
+const uint8_t UINT_64 = 0xcf;
+const uint8_t INT_8 = 0xd0;
+const uint8_t INT_16 = 0xd1;
+const uint8_t INT_32 = 0xd2;
+const uint8_t INT_64 = 0xd3;
+const uint8_t FIXEXT_1 = 0xd4;
+const uint8_t FIXEXT_2 = 0xd5;
+const uint8_t FIXEXT_4 = 0xd6;
+const uint8_t FIXEXT_8 = 0xd7;
+const uint8_t FIXEXT_16 = 0xd8;
+const uint8_t STR_8 = 0xd9;
+const uint8_t STR_16 = 0xda;
+const uint8_t STR_32 = 0xdb;
+const uint8_t ARRAY_16 = 0xdc;
+const uint8_t ARRAY_32 = 0xdd;
+const uint8_t MAP_16 = 0xde;
+const uint8_t MAP_32 = 0xdf;
+const uint8_t NEGATIVE_FIXINT_MIN = 0xe0;
+
+const uint8_t FIXMAP_MAX_SIZE = 15;
+const uint8_t FIXARRAY_MAX_SIZE = 15;
+const uint8_t FIXSTR_MAX_SIZE = 31;
+
+// The timestamp extension, with seconds since 1970-01-01T00:00:00 UTC as
+// 32 bits, as 34 bits after 30 bits of nanoseconds, or as 64 bits after 32
+// bits of nanoseconds
+const int8_t TIMESTAMP_TYPE = -1;
+
+} // namespace msgpack
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,80 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "msgpackformathandler.h"
+
+#include "bufferedrequestparser.h"
+#include "msgpackreader.h"
+#include "msgpackwriter.h"
+
+namespace {
+
+const char APPLICATION_MSGPACK[] = "application/msgpack";
+// Used before the type was registered
+const char APPLICATION_X_MSGPACK[] = "application/x-msgpack";
+
+} // namespace
+
+namespace xsonrpc {
+
+MsgPackFormatHandler::MsgPackFormatHandler(std::string requestPath)
+  : myRequestPath(std::move(requestPath))
+{
+}
+
+bool MsgPackFormatHandler::CanHandleRequest(
+  const std::string& path, const std::string& contentType)
+{
+  return path == myRequestPath
+    && (contentType == APPLICATION_MSGPACK
+        || contentType == APPLICATION_X_MSGPACK);
+}
+
+std::string MsgPackFormatHandler::GetContentType()
+{
+  return APPLICATION_MSGPACK;
+}
+
+bool MsgPackFormatHandler::UsesId()
+{
+  return true;
+}
+
+std::unique_ptr<Reader> MsgPackFormatHandler::CreateReader(std::string data)
+{
+  return std::unique_ptr<Reader>(new MsgPackReader(std::move(data)));
+}
+
+std::unique_ptr<RequestParser> MsgPackFormatHandler::CreateRequestParser(
+  const Dispatcher& dispatcher)
+{
+  return std::unique_ptr<RequestParser>(new BufferedRequestParser(
+    dispatcher,
+    [] (std::string data)
+    {
+      return std::unique_ptr<ByteReader>(
+        new MsgPackReader(std::move(data)));
+    }));
+}
+
+std::unique_ptr<Writer> MsgPackFormatHandler::CreateWriter()
+{
+  return std::unique_ptr<Writer>(new MsgPackWriter());
+}
+
+} // namespace xsonrpc
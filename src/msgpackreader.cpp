@@ -0,0 +1,398 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "msgpackreader.h"
+
+#include "fault.h"
+#include "msgpack.h"
+#include "request.h"
+#include "response.h"
+#include "value.h"
+#include "valuehandler.h"
+
+#include <cstring>
+#include <limits>
+
+namespace xsonrpc {
+
+using namespace msgpack;
+
+MsgPackReader::MsgPackReader(std::string data)
+  : ByteReader(std::move(data))
+{
+}
+
+Request MsgPackReader::GetRequest()
+{
+  Value id;
+  auto name = ReadMethodName(id);
+  Request::Parameters parameters;
+  ReadParameters([&] { parameters.emplace_back(ReadValue()); });
+  return Request(std::move(name), std::move(parameters), std::move(id));
+}
+
+Response MsgPackReader::GetResponse()
+{
+  if (ReadArraySize("Response is not an array") != 4
+      || ReadByte() != RESPONSE) {
+    throw InvalidRequestFault("Invalid response");
+  }
+
+  auto id = ReadValue();
+  auto error = ReadValue();
+  auto result = ReadValue();
+  ReadEnd();
+
+  if (error.IsNil()) {
+    return Response(std::move(result), std::move(id));
+  }
+
+  if (!error.IsStruct()) {
+    throw InvalidRequestFault("Response error is not a map");
+  }
+  auto& s = error.AsStruct();
+  auto code = s.find(ERROR_CODE_NAME);
+  if (code == s.end() || !code->second.IsInteger32()) {
+    throw InvalidRequestFault("Missing or invalid response error code");
+  }
+  auto message = s.find(ERROR_MESSAGE_NAME);
+  if (message == s.end() || !message->second.IsString()) {
+    throw InvalidRequestFault("Missing or invalid response error message");
+  }
+  return Response(code->second.AsInteger32(), message->second.AsString(),
+                  std::move(id));
+}
+
+Value MsgPackReader::GetValue()
+{
+  auto value = ReadValue();
+  ReadEnd();
+  return value;
+}
+
+Response MsgPackReader::InvokeRequest(const Dispatcher& dispatcher)
+{
+  Value id;
+  auto name = ReadMethodName(id);
+
+  auto decoder = CreateParameterDecoder(dispatcher, name, myAttachments);
+  if (!decoder) {
+    Request::Parameters parameters;
+    ReadParameters([&] { parameters.emplace_back(ReadValue()); });
+    return dispatcher.Invoke(name, parameters, id);
+  }
+
+  ReadParameters(
+    [&] ()
+    {
+      decoder->StartParameter();
+      ReadValue(*decoder);
+      decoder->EndParameter();
+    });
+  return dispatcher.Invoke(*decoder, id);
+}
+
+std::string MsgPackReader::ReadMethodName(Value& id)
+{
+  const auto size = ReadArraySize("Request is not an array");
+  const auto type = ReadByte();
+  if (size == 4 && type == REQUEST) {
+    id = ReadValue();
+    if (!id.IsInteger32() && !id.IsInteger64() && !id.IsString()
+        && !id.IsNil()) {
+      throw InvalidRequestFault("Invalid request id");
+    }
+  }
+  else if (size == 3 && type == NOTIFICATION) {
+    myIsNotification = true;
+    id = false;
+  }
+  else {
+    throw InvalidRequestFault("Invalid message type");
+  }
+
+  const char* data;
+  size_t length;
+  if (!ReadString(data, length) || length == 0) {
+    throw InvalidRequestFault("Missing method name");
+  }
+  return std::string(data, length);
+}
+
+template<typename Function>
+void MsgPackReader::ReadParameters(Function readParameter)
+{
+  for (auto size = ReadArraySize("Params is not an array"); size > 0;
+       --size) {
+    readParameter();
+  }
+  ReadEnd();
+}
+
+void MsgPackReader::ReadValue(ValueHandler& handler)
+{
+  Nesting nesting(*this);
+  const auto format = ReadByte();
+  if (format <= POSITIVE_FIXINT_MAX) {
+    handler.Integer32(format);
+    return;
+  }
+  else if (format >= NEGATIVE_FIXINT_MIN) {
+    handler.Integer32(static_cast<int8_t>(format));
+    return;
+  }
+  else if (format < FIXARRAY) {
+    ReadMap(handler, format & FIXMAP_MAX_SIZE);
+    return;
+  }
+  else if (format < FIXSTR) {
+    ReadArray(handler, format & FIXARRAY_MAX_SIZE);
+    return;
+  }
+  else if (format < NIL) {
+    const size_t size = format & FIXSTR_MAX_SIZE;
+    handler.String(ReadBytes(size), size);
+    return;
+  }
+
+  switch (format) {
+    case NIL:
+      handler.Nil();
+      break;
+    case BOOLEAN_FALSE:
+      handler.Boolean(false);
+      break;
+    case BOOLEAN_TRUE:
+      handler.Boolean(true);
+      break;
+
+    case BIN_8:
+    case BIN_16:
+    case BIN_32: {
+      const size_t size = format == BIN_8 ? ReadBigEndian<uint8_t>()
+        : format == BIN_16 ? ReadBigEndian<uint16_t>()
+        : ReadBigEndian<uint32_t>();
+      handler.Binary(ReadBytes(size), size);
+      break;
+    }
+
+    case EXT_8:
+      ReadExtension(handler, ReadBigEndian<uint8_t>());
+      break;
+    case EXT_16:
+      ReadExtension(handler, ReadBigEndian<uint16_t>());
+      break;
+    case EXT_32:
+      ReadExtension(handler, ReadBigEndian<uint32_t>());
+      break;
+
+    case FLOAT_32: {
+      auto bits = ReadBigEndian<uint32_t>();
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      handler.Double(value);
+      break;
+    }
+    case FLOAT_64: {
+      auto bits = ReadBigEndian<uint64_t>();
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      handler.Double(value);
+      break;
+    }
+
+    case UINT_8:
+      handler.Integer32(ReadBigEndian<uint8_t>());
+      break;
+    case UINT_16:
+      handler.Integer32(ReadBigEndian<uint16_t>());
+      break;
+    case UINT_32: {
+      auto value = ReadBigEndian<uint32_t>();
+      if (value <= static_cast<uint32_t>(
+            std::numeric_limits<int32_t>::max())) {
+        handler.Integer32(static_cast<int32_t>(value));
+      }
+      else {
+        handler.Integer64(value);
+      }
+      break;
+    }
+    case UINT_64: {
+      auto value = ReadBigEndian<uint64_t>();
+      if (value <= static_cast<uint64_t>(
+            std::numeric_limits<int64_t>::max())) {
+        handler.Integer64(static_cast<int64_t>(value));
+      }
+      else {
+        handler.Double(static_cast<double>(value));
+      }
+      break;
+    }
+    case INT_8:
+      handler.Integer32(ReadBigEndian<int8_t>());
+      break;
+    case INT_16:
+      handler.Integer32(ReadBigEndian<int16_t>());
+      break;
+    case INT_32:
+      handler.Integer32(ReadBigEndian<int32_t>());
+      break;
+    case INT_64:
+      handler.Integer64(ReadBigEndian<int64_t>());
+      break;
+
+    case FIXEXT_1:
+    case FIXEXT_2:
+    case FIXEXT_4:
+    case FIXEXT_8:
+    case FIXEXT_16:
+      ReadExtension(handler, size_t(1) << (format - FIXEXT_1));
+      break;
+
+    case STR_8:
+    case STR_16:
+    case STR_32: {
+      const size_t size = format == STR_8 ? ReadBigEndian<uint8_t>()
+        : format == STR_16 ? ReadBigEndian<uint16_t>()
+        : ReadBigEndian<uint32_t>();
+      handler.String(ReadBytes(size), size);
+      break;
+    }
+
+    case ARRAY_16:
+      ReadArray(handler, ReadBigEndian<uint16_t>());
+      break;
+    case ARRAY_32:
+      ReadArray(handler, ReadBigEndian<uint32_t>());
+      break;
+    case MAP_16:
+      ReadMap(handler, ReadBigEndian<uint16_t>());
+      break;
+    case MAP_32:
+      ReadMap(handler, ReadBigEndian<uint32_t>());
+      break;
+
+    default:
+      throw InvalidRequestFault("Invalid type");
+  }
+}
+
+Value MsgPackReader::ReadValue()
+{
+  ValueBuilder builder(myStringsByReference);
+  ReadValue(builder);
+  return std::move(builder.GetValue());
+}
+
+void MsgPackReader::ReadArray(ValueHandler& handler, size_t size)
+{
+  // Each element takes at least a byte, so a size larger than the data
+  // left is rejected before anything is read
+  if (size > GetBytesLeft()) {
+    throw ParseErrorFault("Parse error: unexpected end of data");
+  }
+  handler.StartArray();
+  for (; size > 0; --size) {
+    ReadValue(handler);
+  }
+  handler.EndArray();
+}
+
+void MsgPackReader::ReadMap(ValueHandler& handler, size_t size)
+{
+  if (size > GetBytesLeft() / 2) {
+    throw ParseErrorFault("Parse error: unexpected end of data");
+  }
+  handler.StartStruct();
+  for (; size > 0; --size) {
+    const char* name;
+    size_t length;
+    if (!ReadString(name, length)) {
+      throw InvalidRequestFault("Map key is not a string");
+    }
+    handler.StartStructElement(name, length);
+    ReadValue(handler);
+  }
+  handler.EndStruct();
+}
+
+void MsgPackReader::ReadExtension(ValueHandler& handler, size_t size)
+{
+  // Only timestamps are supported. Nanoseconds are dropped, as a
+  // date/time has seconds.
+  if (static_cast<int8_t>(ReadByte()) != TIMESTAMP_TYPE) {
+    throw InvalidRequestFault("Invalid type");
+  }
+
+  int64_t seconds;
+  if (size == 4) {
+    seconds = ReadBigEndian<uint32_t>();
+  }
+  else if (size == 8) {
+    seconds = static_cast<int64_t>(
+      ReadBigEndian<uint64_t>() & 0x3ffffffffull);
+  }
+  else if (size == 12) {
+    ReadBigEndian<uint32_t>();
+    seconds = ReadBigEndian<int64_t>();
+  }
+  else {
+    throw InvalidRequestFault("Invalid timestamp");
+  }
+  handler.DateTime(Value::DateTime(seconds));
+}
+
+size_t MsgPackReader::ReadArraySize(const char* error)
+{
+  const auto format = ReadByte();
+  if (format >= FIXARRAY && format < FIXSTR) {
+    return format & FIXARRAY_MAX_SIZE;
+  }
+  else if (format == ARRAY_16) {
+    return ReadBigEndian<uint16_t>();
+  }
+  else if (format == ARRAY_32) {
+    return ReadBigEndian<uint32_t>();
+  }
+  throw InvalidRequestFault(error);
+}
+
+bool MsgPackReader::ReadString(const char*& data, size_t& size)
+{
+  const auto format = ReadByte();
+  if (format >= FIXSTR && format < NIL) {
+    size = format & FIXSTR_MAX_SIZE;
+  }
+  else if (format == STR_8) {
+    size = ReadBigEndian<uint8_t>();
+  }
+  else if (format == STR_16) {
+    size = ReadBigEndian<uint16_t>();
+  }
+  else if (format == STR_32) {
+    size = ReadBigEndian<uint32_t>();
+  }
+  else {
+    return false;
+  }
+  data = ReadBytes(size);
+  return true;
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,62 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_MSGPACKREADER_H
+#define XSONRPC_MSGPACKREADER_H
+
+#include "bytereader.h"
+
+#include <cstdint>
+#include <string>
+
+namespace xsonrpc {
+
+class ValueHandler;
+
+// Reads MessagePack-RPC in a single pass, so only one of GetRequest,
+// GetResponse, GetValue and InvokeRequest can be called
+class MsgPackReader final : public ByteReader
+{
+public:
+  explicit MsgPackReader(std::string data);
+
+  // Reader
+  Request GetRequest() override;
+  Response GetResponse() override;
+  Value GetValue() override;
+  Response InvokeRequest(const Dispatcher& dispatcher) override;
+
+private:
+  std::string ReadMethodName(Value& id);
+  template<typename Function>
+  void ReadParameters(Function readParameter);
+  void ReadValue(ValueHandler& handler);
+  Value ReadValue();
+  void ReadArray(ValueHandler& handler, size_t size);
+  void ReadMap(ValueHandler& handler, size_t size);
+  void ReadExtension(ValueHandler& handler, size_t size);
+  // Reads the size of an array, throwing InvalidRequestFault with the
+  // error if it is something else
+  size_t ReadArraySize(const char* error);
+  // Reads a string, or returns false if it is something else
+  bool ReadString(const char*& data, size_t& size);
+};
+
+} // namespace xsonrpc
+
+#endif
@@ -0,0 +1,418 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "msgpackwriter.h"
+
+#include "msgpack.h"
+#include "value.h"
+#include "valueserializer.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+using namespace xsonrpc::msgpack;
+
+const size_t MAX_HEADER_SIZE = 5;
+
+// Writes the header of an array or map with size elements and returns its
+// size
+size_t FormatHeader(char (&header)[MAX_HEADER_SIZE], size_t size,
+                    bool isMap)
+{
+  if (size <= (isMap ? FIXMAP_MAX_SIZE : FIXARRAY_MAX_SIZE)) {
+    header[0] = static_cast<char>((isMap ? FIXMAP : FIXARRAY) | size);
+    return 1;
+  }
+
+  size_t length;
+  if (size <= std::numeric_limits<uint16_t>::max()) {
+    header[0] = static_cast<char>(isMap ? MAP_16 : ARRAY_16);
+    length = 2;
+  }
+  else if (size <= std::numeric_limits<uint32_t>::max()) {
+    header[0] = static_cast<char>(isMap ? MAP_32 : ARRAY_32);
+    length = 4;
+  }
+  else {
+    throw std::length_error("msgpack: too many elements");
+  }
+  for (size_t i = length; i > 0; --i) {
+    header[i] = static_cast<char>(size & 0xff);
+    size >>= 8;
+  }
+  return length + 1;
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+using namespace msgpack;
+
+void MsgPackWriter::StartContainer(bool isMap)
+{
+  AddElement();
+  ByteWriter::StartContainer(isMap, MAX_HEADER_SIZE);
+}
+
+void MsgPackWriter::EndContainer()
+{
+  const auto container = ByteWriter::EndContainer();
+  char header[MAX_HEADER_SIZE];
+  const size_t size = FormatHeader(header, container.Size, container.IsMap);
+  WriteHeader(container, header, size);
+}
+
+void MsgPackWriter::WriteId(const Value& id)
+{
+  if (id.IsInteger32()) {
+    Pack(id.AsInteger32());
+  }
+  else if (id.IsInteger64()) {
+    Pack(id.AsInteger64());
+  }
+  else if (id.IsString()) {
+    PackString(id.AsString().data(), id.AsString().size());
+  }
+  else {
+    Append(NIL);
+  }
+}
+
+void MsgPackWriter::Pack(double value)
+{
+  uint64_t bits;
+  static_assert(sizeof(bits) == sizeof(value), "double is not 64 bits");
+  memcpy(&bits, &value, sizeof(bits));
+  Append(FLOAT_64);
+  AppendBigEndian(bits);
+}
+
+void MsgPackWriter::Pack(int32_t value)
+{
+  // The smallest format that holds the value
+  if (value >= 0) {
+    if (value <= POSITIVE_FIXINT_MAX) {
+      Append(static_cast<uint8_t>(value));
+    }
+    else if (value <= std::numeric_limits<uint8_t>::max()) {
+      Append(UINT_8);
+      AppendBigEndian(static_cast<uint8_t>(value));
+    }
+    else if (value <= std::numeric_limits<uint16_t>::max()) {
+      Append(UINT_16);
+      AppendBigEndian(static_cast<uint16_t>(value));
+    }
+    else {
+      Append(UINT_32);
+      AppendBigEndian(static_cast<uint32_t>(value));
+    }
+  }
+  else if (value >= -32) {
+    Append(static_cast<uint8_t>(value));
+  }
+  else if (value >= std::numeric_limits<int8_t>::min()) {
+    Append(INT_8);
+    AppendBigEndian(static_cast<int8_t>(value));
+  }
+  else if (value >= std::numeric_limits<int16_t>::min()) {
+    Append(INT_16);
+    AppendBigEndian(static_cast<int16_t>(value));
+  }
+  else {
+    Append(INT_32);
+    AppendBigEndian(value);
+  }
+}
+
+void MsgPackWriter::Pack(int64_t value)
+{
+  // Always 64 bits, so that the value is read back as a 64-bit integer
+  Append(INT_64);
+  AppendBigEndian(value);
+}
+
+void MsgPackWriter::PackString(const char* data, size_t size)
+{
+  if (size <= FIXSTR_MAX_SIZE) {
+    Append(static_cast<uint8_t>(FIXSTR | size));
+  }
+  else if (size <= std::numeric_limits<uint8_t>::max()) {
+    Append(STR_8);
+    AppendBigEndian(static_cast<uint8_t>(size));
+  }
+  else if (size <= std::numeric_limits<uint16_t>::max()) {
+    Append(STR_16);
+    AppendBigEndian(static_cast<uint16_t>(size));
+  }
+  else if (size <= std::numeric_limits<uint32_t>::max()) {
+    Append(STR_32);
+    AppendBigEndian(static_cast<uint32_t>(size));
+  }
+  else {
+    throw std::length_error("msgpack: string too long");
+  }
+  myBuffer.append(data, size);
+}
+
+void MsgPackWriter::StartDocument()
+{
+  // Empty
+}
+
+void MsgPackWriter::EndDocument()
+{
+  // Empty
+}
+
+void MsgPackWriter::StartBatch()
+{
+  throw std::logic_error("msgpack-rpc: batches are not supported");
+}
+
+void MsgPackWriter::EndBatch()
+{
+  throw std::logic_error("msgpack-rpc: batches are not supported");
+}
+
+void MsgPackWriter::StartRequest(const std::string& methodName,
+                                 const Value& id)
+{
+  // A request without id is a notification, see Client::Notify
+  if (id.IsBoolean()) {
+    Append(FIXARRAY | 3);
+    Append(NOTIFICATION);
+  }
+  else {
+    Append(FIXARRAY | 4);
+    Append(REQUEST);
+    WriteId(id);
+  }
+  PackString(methodName.data(), methodName.size());
+  StartContainer(false);
+}
+
+void MsgPackWriter::EndRequest()
+{
+  EndContainer();
+}
+
+void MsgPackWriter::StartParameter()
+{
+  // Empty
+}
+
+void MsgPackWriter::EndParameter()
+{
+  // Empty
+}
+
+void MsgPackWriter::StartResponse(const Value& id)
+{
+  Append(FIXARRAY | 4);
+  Append(RESPONSE);
+  WriteId(id);
+  // No error
+  Append(NIL);
+}
+
+void MsgPackWriter::EndResponse()
+{
+  // Empty
+}
+
+void MsgPackWriter::StartFaultResponse(const Value& id)
+{
+  Append(FIXARRAY | 4);
+  Append(RESPONSE);
+  WriteId(id);
+}
+
+void MsgPackWriter::EndFaultResponse()
+{
+  // No result
+  Append(NIL);
+}
+
+void MsgPackWriter::WriteFault(int32_t code, const std::string& string)
+{
+  Append(FIXMAP | 2);
+  PackString(ERROR_CODE_NAME, sizeof(ERROR_CODE_NAME) - 1);
+  Pack(code);
+  PackString(ERROR_MESSAGE_NAME, sizeof(ERROR_MESSAGE_NAME) - 1);
+  PackString(string.data(), string.size());
+}
+
+void MsgPackWriter::StartArray()
+{
+  StartContainer(false);
+}
+
+void MsgPackWriter::EndArray()
+{
+  EndContainer();
+}
+
+void MsgPackWriter::StartStruct()
+{
+  StartContainer(true);
+}
+
+void MsgPackWriter::EndStruct()
+{
+  EndContainer();
+}
+
+void MsgPackWriter::StartStructElement(const std::string& name)
+{
+  AddMember();
+  PackString(name.data(), name.size());
+}
+
+void MsgPackWriter::StartStructElement(const char* name)
+{
+  AddMember();
+  PackString(name, strlen(name));
+}
+
+void MsgPackWriter::EndStructElement()
+{
+  // Empty
+}
+
+void MsgPackWriter::WriteArray(const int32_t* data, size_t size)
+{
+  AddElement();
+  char header[MAX_HEADER_SIZE];
+  myBuffer.append(header, FormatHeader(header, size, false));
+  for (size_t i = 0; i < size; ++i) {
+    Pack(data[i]);
+  }
+}
+
+void MsgPackWriter::WriteArray(const int64_t* data, size_t size)
+{
+  AddElement();
+  char header[MAX_HEADER_SIZE];
+  myBuffer.append(header, FormatHeader(header, size, false));
+  for (size_t i = 0; i < size; ++i) {
+    Pack(data[i]);
+  }
+}
+
+void MsgPackWriter::WriteArray(const double* data, size_t size)
+{
+  AddElement();
+  char header[MAX_HEADER_SIZE];
+  myBuffer.append(header, FormatHeader(header, size, false));
+  for (size_t i = 0; i < size; ++i) {
+    Pack(data[i]);
+  }
+}
+
+void MsgPackWriter::WriteBinary(const char* data, size_t size)
+{
+  AddElement();
+  if (size <= std::numeric_limits<uint8_t>::max()) {
+    Append(BIN_8);
+    AppendBigEndian(static_cast<uint8_t>(size));
+  }
+  else if (size <= std::numeric_limits<uint16_t>::max()) {
+    Append(BIN_16);
+    AppendBigEndian(static_cast<uint16_t>(size));
+  }
+  else if (size <= std::numeric_limits<uint32_t>::max()) {
+    Append(BIN_32);
+    AppendBigEndian(static_cast<uint32_t>(size));
+  }
+  else {
+    throw std::length_error("msgpack: binary too long");
+  }
+  myBuffer.append(data, size);
+}
+
+void MsgPackWriter::WriteNull()
+{
+  AddElement();
+  Append(NIL);
+}
+
+void MsgPackWriter::Write(bool value)
+{
+  AddElement();
+  Append(value ? BOOLEAN_TRUE : BOOLEAN_FALSE);
+}
+
+void MsgPackWriter::Write(double value)
+{
+  AddElement();
+  Pack(value);
+}
+
+void MsgPackWriter::Write(int32_t value)
+{
+  AddElement();
+  Pack(value);
+}
+
+void MsgPackWriter::Write(int64_t value)
+{
+  AddElement();
+  Pack(value);
+}
+
+void MsgPackWriter::Write(const std::string& value)
+{
+  Write(value.data(), value.size());
+}
+
+void MsgPackWriter::Write(const char* data, size_t size)
+{
+  AddElement();
+  PackString(data, size);
+}
+
+void MsgPackWriter::Write(const Value::DateTime& value)
+{
+  // A timestamp, taking the date/time to be in UTC. The 32-bit form is
+  // used when the seconds fit.
+  AddElement();
+  const auto seconds = value.GetSecondsSinceEpoch();
+  if (seconds >= 0 && seconds <= std::numeric_limits<uint32_t>::max()) {
+    Append(FIXEXT_4);
+    Append(static_cast<uint8_t>(TIMESTAMP_TYPE));
+    AppendBigEndian(static_cast<uint32_t>(seconds));
+  }
+  else {
+    Append(EXT_8);
+    Append(12);
+    Append(static_cast<uint8_t>(TIMESTAMP_TYPE));
+    AppendBigEndian(static_cast<uint32_t>(0));
+    AppendBigEndian(seconds);
+  }
+}
+
+void MsgPackWriter::WriteValue(const Value& value)
+{
+  SerializeValue(value, *this);
+}
+
+} // namespace xsonrpc
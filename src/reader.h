@@ -18,20 +18,62 @@
 #ifndef XSONRPC_READER_H
 #define XSONRPC_READER_H
 
-namespace xsonrpc {
+#include "attachments.h"
+#include "dispatcher.h"
+#include "request.h"
+#include "response.h"
+
+#include <vector>
 
-class Request;
-class Response;
-class Value;
+namespace xsonrpc {
 
 class Reader
 {
 public:
   virtual ~Reader() {}
 
+  // Let string values reference the reader's buffer instead of copying
+  // them. The reader must then outlive all values it has returned.
+  virtual void SetStringsByReference(bool byReference) = 0;
+  // Lets the parameters of a request reference the attachments of a
+  // multipart/related message, which must outlive the reader
+  void SetAttachments(const Attachments& attachments)
+  {
+    myAttachments = &attachments;
+  }
+
   virtual Request GetRequest() = 0;
   virtual Response GetResponse() = 0;
   virtual Value GetValue() = 0;
+
+  // Reads the responses to a batch of requests, in the order they were
+  // sent. A server replies with a single fault if it cannot read the
+  // batch, which is then the only response. Readers of formats without
+  // batches only read a single response.
+  virtual std::vector<Response> GetBatchResponse()
+  {
+    std::vector<Response> responses;
+    responses.push_back(GetResponse());
+    return responses;
+  }
+
+  // Reads a request and invokes it. Readers that can decode parameters
+  // while parsing (see Dispatcher::CreateParameterDecoder) override this.
+  virtual Response InvokeRequest(const Dispatcher& dispatcher)
+  {
+    Request request = GetRequest();
+    if (myAttachments) {
+      for (auto& parameter : request.GetParameters()) {
+        parameter = ResolveAttachments(
+          std::move(parameter), *myAttachments, true);
+      }
+    }
+    return dispatcher.Invoke(
+      request.GetMethodName(), request.GetParameters(), request.GetId());
+  }
+
+protected:
+  const Attachments* myAttachments = nullptr;
 };
 
 } // namespace xsonrpc
@@ -37,6 +37,26 @@ void Request::Write(const std::string& methodName, const Parameters& params,
                     const Value& id, Writer& writer)
 {
   writer.StartDocument();
+  WriteRequest(methodName, params, id, writer);
+  writer.EndDocument();
+}
+
+void Request::WriteBatch(const std::vector<Request>& requests, Writer& writer)
+{
+  writer.StartDocument();
+  writer.StartBatch();
+  for (auto& request : requests) {
+    WriteRequest(request.myMethodName, request.myParameters, request.myId,
+                 writer);
+  }
+  writer.EndBatch();
+  writer.EndDocument();
+}
+
+void Request::WriteRequest(const std::string& methodName,
+                           const Parameters& params, const Value& id,
+                           Writer& writer)
+{
   writer.StartRequest(methodName, id);
   for (auto& param : params) {
     writer.StartParameter();
@@ -44,7 +64,6 @@ void Request::Write(const std::string& methodName, const Parameters& params,
     writer.EndParameter();
   }
   writer.EndRequest();
-  writer.EndDocument();
 }
 
 } // namespace xsonrpc
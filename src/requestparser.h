@@ -0,0 +1,65 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_REQUESTPARSER_H
+#define XSONRPC_REQUESTPARSER_H
+
+#include "attachments.h"
+#include "response.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace xsonrpc {
+
+// Parses a request while its data arrives, see
+// FormatHandler::CreateRequestParser
+class RequestParser
+{
+public:
+  virtual ~RequestParser() {}
+
+  // Parses the next part of the data. Throws a Fault if the data is
+  // invalid, after which the parser must not be used.
+  virtual void Parse(const char* data, size_t size) = 0;
+
+  // Invokes the request, or each request in a batch, once all data has
+  // been parsed. Throws a Fault if a single request is invalid, while
+  // invalid requests in a batch get a fault response. Notifications get no
+  // response, so there may be none. String values may reference the
+  // parser, so it must outlive the responses.
+  virtual std::vector<Response> InvokeRequests() = 0;
+
+  // Tells if the data was a batch, whose responses are written as one,
+  // see Response::WriteBatch
+  virtual bool IsBatch() const = 0;
+
+  // Lets the parameters reference the attachments of a multipart/related
+  // message, which must outlive the responses. Set before parsing.
+  void SetAttachments(const Attachments& attachments)
+  {
+    myAttachments = &attachments;
+  }
+
+protected:
+  const Attachments* myAttachments = nullptr;
+};
+
+} // namespace xsonrpc
+
+#endif
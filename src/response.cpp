@@ -41,6 +41,24 @@ Response::Response(int32_t faultCode, std::string faultString, Value id)
 void Response::Write(Writer& writer) const
 {
   writer.StartDocument();
+  WriteResponse(writer);
+  writer.EndDocument();
+}
+
+void Response::WriteBatch(const std::vector<Response>& responses,
+                          Writer& writer)
+{
+  writer.StartDocument();
+  writer.StartBatch();
+  for (auto& response : responses) {
+    response.WriteResponse(writer);
+  }
+  writer.EndBatch();
+  writer.EndDocument();
+}
+
+void Response::WriteResponse(Writer& writer) const
+{
   if (myIsFault) {
     writer.StartFaultResponse(myId);
     writer.WriteFault(myFaultCode, myFaultString);
@@ -51,7 +69,6 @@ void Response::Write(Writer& writer) const
     myResult.Write(writer);
     writer.EndResponse();
   }
-  writer.EndDocument();
 }
 
 void Response::ThrowIfFault() const
@@ -0,0 +1,195 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "responsestream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace xsonrpc {
+
+ResponseStream::ResponseStream(std::unique_ptr<Writer> writer,
+                               std::vector<Response> responses,
+                               bool isBatch, size_t blockSize)
+  : myWriter(std::move(writer)),
+    myResponses(std::move(responses)),
+    myIsBatch(isBatch),
+    myBlockSize(blockSize)
+{
+}
+
+void ResponseStream::Fill()
+{
+  while (!myIsDone && GetSize() < myBlockSize) {
+    Step();
+  }
+}
+
+void ResponseStream::Finish()
+{
+  while (!myIsDone) {
+    Step();
+  }
+}
+
+const char* ResponseStream::GetData()
+{
+  return myWriter->GetData() + myOffset;
+}
+
+size_t ResponseStream::GetSize()
+{
+  return myWriter->GetSize() - myOffset;
+}
+
+size_t ResponseStream::Read(char* buffer, size_t size)
+{
+  Fill();
+
+  size = std::min(size, GetSize());
+  memcpy(buffer, GetData(), size);
+  myOffset += size;
+
+  if (GetSize() == 0) {
+    myWriter->ClearData();
+    myOffset = 0;
+  }
+  return size;
+}
+
+void ResponseStream::Step()
+{
+  if (!myFrames.empty()) {
+    StepValue();
+    return;
+  }
+
+  switch (myState) {
+    case State::START:
+      myWriter->StartDocument();
+      if (myIsBatch) {
+        myWriter->StartBatch();
+      }
+      myState = State::RESPONSE;
+      break;
+
+    case State::RESPONSE: {
+      if (myIndex == myResponses.size()) {
+        if (myIsBatch) {
+          myWriter->EndBatch();
+        }
+        myWriter->EndDocument();
+        myIsDone = true;
+        break;
+      }
+
+      auto& response = myResponses[myIndex];
+      if (response.IsFault()) {
+        myWriter->StartFaultResponse(response.GetId());
+        myWriter->WriteFault(response.GetFaultCode(),
+                             response.GetFaultString());
+        myWriter->EndFaultResponse();
+        ++myIndex;
+      }
+      else {
+        myWriter->StartResponse(response.GetId());
+        StartValue(response.GetResult());
+        myState = State::END_RESPONSE;
+      }
+      break;
+    }
+
+    case State::END_RESPONSE:
+      myWriter->EndResponse();
+      ++myIndex;
+      myState = State::RESPONSE;
+      break;
+  }
+}
+
+void ResponseStream::StartValue(const Value& value)
+{
+  if (auto generator = value.GetGenerator()) {
+    myWriter->StartArray();
+    myFrames.push_back({&value, 0, {}, {}, false, generator,
+                        std::unique_ptr<Value>(new Value())});
+  }
+  else if (value.IsWritable()) {
+    value.Write(*myWriter);
+  }
+  else if (value.IsStruct()) {
+    auto& members = value.AsStruct();
+    myWriter->StartStruct();
+    myFrames.push_back(
+      {&value, 0, members.begin(), members.end(), false, nullptr, nullptr});
+  }
+  else if (value.IsArray() && !value.IsInteger32Array()
+           && !value.IsInteger64Array() && !value.IsDoubleArray()) {
+    myWriter->StartArray();
+    myFrames.push_back({&value, 0, {}, {}, false, nullptr, nullptr});
+  }
+  else {
+    value.Write(*myWriter);
+  }
+}
+
+void ResponseStream::StepValue()
+{
+  // StartValue may add a frame, so nothing in the frame is used after it
+  auto& frame = myFrames.back();
+
+  if (frame.Generator) {
+    // The element is kept on the heap, so that frames can be moved while
+    // it is written
+    auto& element = *frame.Element;
+    if (frame.Generator->Next(element)) {
+      StartValue(element);
+      return;
+    }
+    myFrames.pop_back();
+    myWriter->EndArray();
+    return;
+  }
+
+  if (frame.Container->IsArray()) {
+    auto& elements = frame.Container->AsArray();
+    if (frame.Index < elements.size()) {
+      StartValue(elements[frame.Index++]);
+      return;
+    }
+    myFrames.pop_back();
+    myWriter->EndArray();
+    return;
+  }
+
+  if (frame.IsInMember) {
+    frame.IsInMember = false;
+    myWriter->EndStructElement();
+  }
+  if (frame.Member != frame.End) {
+    auto& member = *frame.Member++;
+    frame.IsInMember = true;
+    myWriter->StartStructElement(member.first);
+    StartValue(member.second);
+    return;
+  }
+  myFrames.pop_back();
+  myWriter->EndStruct();
+}
+
+} // namespace xsonrpc
@@ -0,0 +1,96 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_RESPONSESTREAM_H
+#define XSONRPC_RESPONSESTREAM_H
+
+#include "response.h"
+#include "value.h"
+#include "writer.h"
+
+#include <memory>
+#include <vector>
+
+namespace xsonrpc {
+
+// Writes responses a block at a time, so that the data can be sent while the
+// rest is written. Values are traversed with a stack instead of recursion,
+// so that writing can stop as soon as a block is ready. Generated arrays are
+// written an element at a time, while other writables and packed arrays are
+// written in one go.
+class ResponseStream
+{
+public:
+  ResponseStream(std::unique_ptr<Writer> writer,
+                 std::vector<Response> responses, bool isBatch,
+                 size_t blockSize);
+
+  // Writes until a block of data is ready, or everything has been written
+  void Fill();
+  // Writes everything, so that all data is ready
+  void Finish();
+  // True when everything has been written, though maybe not read
+  bool IsDone() const { return myIsDone; }
+
+  // The data that has been written but not read
+  const char* GetData();
+  size_t GetSize();
+
+  // Reads up to size bytes of data, writing more as needed. Returns 0 at
+  // the end.
+  size_t Read(char* buffer, size_t size);
+
+private:
+  enum class State
+  {
+    START,
+    RESPONSE,
+    END_RESPONSE
+  };
+
+  struct Frame
+  {
+    const Value* Container;
+    size_t Index;
+    Value::Struct::const_iterator Member;
+    Value::Struct::const_iterator End;
+    bool IsInMember;
+    // For generated arrays, the element being written
+    Value::Generator* Generator;
+    std::unique_ptr<Value> Element;
+  };
+
+  void Step();
+  void StartValue(const Value& value);
+  void StepValue();
+
+  std::unique_ptr<Writer> myWriter;
+  std::vector<Response> myResponses;
+  const bool myIsBatch;
+  const size_t myBlockSize;
+
+  State myState = State::START;
+  size_t myIndex = 0;
+  std::vector<Frame> myFrames;
+  bool myIsDone = false;
+  size_t myOffset = 0;
+};
+
+} // namespace xsonrpc
+
+#endif
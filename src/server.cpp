@@ -17,20 +17,31 @@
 
 #include "server.h"
 
+#include "attachments.h"
 #include "formathandler.h"
 #include "reader.h"
+#include "requestparser.h"
+#include "response.h"
+#include "responsestream.h"
 #include "writer.h"
 
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cctype>
 #include <cstring>
 #include <microhttpd.h>
+#include <stdexcept>
 #include <vector>
 
 namespace {
 
 const size_t MAX_REQUEST_SIZE = 16 * 1024;
+// Multipart requests are buffered in full, and have the binary values of
+// the request as attachments
+const size_t MAX_MULTIPART_REQUEST_SIZE = 64 * 1024 * 1024;
+// Responses larger than this are sent while they are written
+const size_t STREAM_BLOCK_SIZE = 16 * 1024;
 
 struct HttpError
 {
@@ -39,16 +50,63 @@ struct HttpError
 
 struct ConnectionInfo
 {
-  std::string Buffer;
+  explicit ConnectionInfo(xsonrpc::FormatHandler* formatHandler)
+    : FormatHandler(formatHandler) {}
+
   xsonrpc::FormatHandler* FormatHandler;
-  std::unique_ptr<xsonrpc::Writer> Writer;
+  // Either the request is parsed as it arrives, or it is buffered and read
+  // when complete
+  std::unique_ptr<xsonrpc::RequestParser> Parser;
+  std::string Buffer;
+  size_t Size = 0;
+  // A fault while parsing is kept until the whole request has arrived
+  std::unique_ptr<xsonrpc::Response> Error;
+  std::unique_ptr<xsonrpc::Reader> Reader;
+  std::unique_ptr<xsonrpc::ResponseStream> Stream;
+  // Set for a multipart/related request, whose attachments reference Buffer
+  std::string Boundary;
+  xsonrpc::Attachments Attachments;
+  // The response is multipart/related if the client accepts it and it has
+  // attachments
+  bool AcceptsAttachments = false;
+  std::string Message;
 };
 
+bool AcceptsAttachments(MHD_Connection* connection)
+{
+  auto header = MHD_lookup_connection_value(
+    connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT);
+  if (!header) {
+    return false;
+  }
+  std::string accept(header);
+  for (auto& c : accept) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+  return accept.find(xsonrpc::MULTIPART_RELATED) != std::string::npos;
+}
+
+ssize_t ReadStream(void* cls, uint64_t /*pos*/, char* buffer, size_t size)
+{
+  try {
+    auto read = static_cast<xsonrpc::ResponseStream*>(cls)->Read(
+      buffer, size);
+    return read > 0 ? read : MHD_CONTENT_READER_END_OF_STREAM;
+  }
+  catch (...) {
+    // Part of the response has been sent, so all that can be done is to
+    // cut it short
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+  }
+}
+
 } // namespace
 
 namespace xsonrpc {
 
 Server::Server(unsigned short port)
+  : myMaxRequestSize(MAX_REQUEST_SIZE),
+    myMaxMultipartRequestSize(MAX_MULTIPART_REQUEST_SIZE)
 {
   myDaemon = MHD_start_daemon(
 #if MHD_VERSION >= 0x00093100
@@ -72,6 +130,17 @@ Server::~Server()
 void Server::RegisterFormatHandler(FormatHandler& formatHandler)
 {
   myFormatHandlers.push_back(&formatHandler);
+  myDispatcher.AddFormat(formatHandler.GetContentType());
+}
+
+void Server::SetMaxRequestSize(size_t size)
+{
+  myMaxRequestSize = size;
+}
+
+void Server::SetMaxMultipartRequestSize(size_t size)
+{
+  myMaxMultipartRequestSize = size;
 }
 
 void Server::Run()
@@ -105,35 +174,148 @@ void Server::OnReadableFileDescriptor()
 void Server::HandleRequest(MHD_Connection* connection, void* connectionCls)
 {
   auto info = static_cast<ConnectionInfo*>(connectionCls);
-  info->Writer = info->FormatHandler->CreateWriter();
 
+  std::vector<Response> responses;
+  bool isBatch = false;
   try {
-    auto reader = info->FormatHandler->CreateReader(std::move(info->Buffer));
-    Request request = reader->GetRequest();
-    reader.reset();
+    if (info->Error) {
+      responses.push_back(std::move(*info->Error));
+    }
+    else if (info->Parser) {
+      // String parameters reference the parser, which is kept in the
+      // connection info until the response has been sent
+      responses = info->Parser->InvokeRequests();
+      isBatch = info->Parser->IsBatch();
+    }
+    else if (!info->Boundary.empty()) {
+      // The root part is read as any other request, with references to the
+      // attachments resolved as the parameters are decoded
+      auto root = ReadMultipart(
+        info->Buffer, info->Boundary, info->Attachments);
+      info->Parser = info->FormatHandler->CreateRequestParser(myDispatcher);
+      if (info->Parser) {
+        info->Parser->SetAttachments(info->Attachments);
+        info->Parser->Parse(root.Data, root.Size);
+        responses = info->Parser->InvokeRequests();
+        isBatch = info->Parser->IsBatch();
+      }
+      else {
+        info->Reader = info->FormatHandler->CreateReader(
+          std::string(root.Data, root.Size));
+        info->Reader->SetStringsByReference(true);
+        info->Reader->SetAttachments(info->Attachments);
+        responses.push_back(info->Reader->InvokeRequest(myDispatcher));
+      }
+    }
+    else {
+      // String parameters reference the reader's buffer, so the reader is
+      // kept in the same way
+      info->Reader = info->FormatHandler->CreateReader(
+        std::move(info->Buffer));
+      info->Reader->SetStringsByReference(true);
+      responses.push_back(info->Reader->InvokeRequest(myDispatcher));
+    }
+  }
+  catch (const Fault& ex) {
+    responses.clear();
+    responses.emplace_back(ex.GetCode(), ex.GetString(), Value());
+    isBatch = false;
+  }
 
-    auto response = myDispatcher.Invoke(
-      request.GetMethodName(), request.GetParameters(), request.GetId());
-    response.Write(*info->Writer);
+  if (responses.empty()) {
+    // Only notifications, which get no response
+    auto response = MHD_create_response_from_data(0, nullptr, false, false);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_SERVER,
+                            "xsonrpc/" XSONRPC_VERSION);
+    MHD_queue_response(connection, MHD_HTTP_NO_CONTENT, response);
+    MHD_destroy_response(response);
+    return;
+  }
+
+  // Attachments are collected as the response is written, and must follow
+  // all of it. The response is thus written in full if the first block has
+  // attachments, while they are written inline in the rest of a response
+  // that is streamed.
+  std::unique_ptr<Writer> writer = info->FormatHandler->CreateWriter();
+  AttachmentWriter* attachmentWriter = nullptr;
+  if (info->AcceptsAttachments) {
+    attachmentWriter = new AttachmentWriter(std::move(writer));
+    writer.reset(attachmentWriter);
+  }
+  info->Stream.reset(new ResponseStream(
+    std::move(writer), std::move(responses), isBatch, STREAM_BLOCK_SIZE));
+  // Nothing has been sent yet, so a fault can replace the response
+  auto replaceWithFault = [&] (const Fault& ex)
+  {
+    std::vector<Response> fault;
+    fault.emplace_back(ex.GetCode(), ex.GetString(), Value());
+    info->Stream.reset(new ResponseStream(
+      info->FormatHandler->CreateWriter(), std::move(fault), false,
+      STREAM_BLOCK_SIZE));
+    info->Stream->Fill();
+    attachmentWriter = nullptr;
+  };
+  try {
+    info->Stream->Fill();
+    if (attachmentWriter) {
+      if (attachmentWriter->GetAttachments().empty()) {
+        attachmentWriter->SetCollect(false);
+      }
+      else {
+        info->Stream->Finish();
+      }
+    }
   }
   catch (const Fault& ex) {
-    Response(ex.GetCode(), ex.GetString(), Value()).Write(*info->Writer);
+    replaceWithFault(ex);
+  }
+  catch (const std::exception& ex) {
+    // Writers throw for values that the format can't represent
+    replaceWithFault(InternalErrorFault(ex.what()));
   }
 
+  std::string contentType = info->FormatHandler->GetContentType();
+  MHD_Response* response;
+  if (attachmentWriter && !attachmentWriter->GetAttachments().empty()) {
+    auto& attachments = attachmentWriter->GetAttachments();
+    auto boundary = CreateBoundary(
+      info->Stream->GetData(), info->Stream->GetSize(), attachments);
+    WriteMultipart(info->Message, boundary, contentType,
+                   info->Stream->GetData(), info->Stream->GetSize(),
+                   attachments);
+    contentType = GetMultipartContentType(contentType, boundary);
+#if MHD_VERSION >= 0x00090500
+    response = MHD_create_response_from_buffer(
+      info->Message.size(), &info->Message[0], MHD_RESPMEM_PERSISTENT);
+#else
+    response = MHD_create_response_from_data(
+      info->Message.size(), &info->Message[0], false, false);
+#endif
+  }
+  else if (info->Stream->IsDone()) {
+    // Written in full, so it is sent with a known length
 #if MHD_VERSION >= 0x00090500
-  auto response = MHD_create_response_from_buffer(
-    info->Writer->GetSize(),
-    const_cast<char*>(info->Writer->GetData()),
-    MHD_RESPMEM_PERSISTENT);
+    response = MHD_create_response_from_buffer(
+      info->Stream->GetSize(),
+      const_cast<char*>(info->Stream->GetData()),
+      MHD_RESPMEM_PERSISTENT);
 #else
-  auto response = MHD_create_response_from_data(
-    info->Writer->GetSize(),
-    const_cast<char*>(info->Writer->GetData()),
-    false, false);
+    response = MHD_create_response_from_data(
+      info->Stream->GetSize(),
+      const_cast<char*>(info->Stream->GetData()),
+      false, false);
 #endif
+  }
+  else {
+    // Sent with chunked transfer encoding, a block at a time as it is
+    // written
+    response = MHD_create_response_from_callback(
+      MHD_SIZE_UNKNOWN, STREAM_BLOCK_SIZE, &ReadStream, info->Stream.get(),
+      nullptr);
+  }
 
   MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE,
-                          info->FormatHandler->GetContentType().c_str());
+                          contentType.c_str());
   MHD_add_response_header(response, MHD_HTTP_HEADER_SERVER,
                           "xsonrpc/" XSONRPC_VERSION);
   MHD_queue_response(connection, MHD_HTTP_OK, response);
@@ -165,12 +347,28 @@ int Server::AccessHandler(
       }
 
       ConnectionInfo* info = static_cast<ConnectionInfo*>(*connectionCls);
-      if (info->Buffer.size() + *uploadDataSize > MAX_REQUEST_SIZE) {
+      info->Size += *uploadDataSize;
+      if (info->Size > (info->Boundary.empty()
+                        ? myMaxRequestSize : myMaxMultipartRequestSize)) {
         *uploadDataSize = 0;
-        throw HttpError{MHD_HTTP_BAD_REQUEST};
+        throw HttpError{MHD_HTTP_REQUEST_ENTITY_TOO_LARGE};
+      }
+
+      if (info->Parser) {
+        if (!info->Error) {
+          try {
+            info->Parser->Parse(uploadData, *uploadDataSize);
+          }
+          catch (const Fault& ex) {
+            info->Error.reset(
+              new Response(ex.GetCode(), ex.GetString(), Value()));
+          }
+        }
+      }
+      else {
+        info->Buffer.insert(info->Buffer.end(), uploadData,
+                            uploadData + *uploadDataSize);
       }
-      info->Buffer.insert(info->Buffer.end(), uploadData,
-                          uploadData + *uploadDataSize);
       *uploadDataSize = 0;
       return MHD_YES;
     }
@@ -181,10 +379,23 @@ int Server::AccessHandler(
 
     auto header = MHD_lookup_connection_value(
       connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_CONTENT_TYPE);
-    const std::string contentType(header ? header : "");
+    std::string contentType(header ? header : "");
+    // A multipart/related request is handled by the format of its root part,
+    // but is buffered as the parser can't tell the parts apart
+    std::string boundary;
+    std::string rootType;
+    if (ParseMultipartContentType(contentType, rootType, boundary)) {
+      contentType = std::move(rootType);
+    }
     for (auto handler : myFormatHandlers) {
       if (handler->CanHandleRequest(url, contentType)) {
-        *connectionCls = new ConnectionInfo{{}, handler, {}};
+        std::unique_ptr<ConnectionInfo> info(new ConnectionInfo(handler));
+        if (boundary.empty()) {
+          info->Parser = handler->CreateRequestParser(myDispatcher);
+        }
+        info->Boundary = std::move(boundary);
+        info->AcceptsAttachments = AcceptsAttachments(connection);
+        *connectionCls = info.release();
         return MHD_YES;
       }
     }
@@ -0,0 +1,250 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "textscan.h"
+
+#include "cpu.h"
+
+#include <stdint.h>
+
+#ifdef XSONRPC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct JsonEscape
+{
+  static bool Scalar(unsigned char c)
+  {
+    return c == '"' || c == '\\' || c < 0x20;
+  }
+
+#ifdef XSONRPC_X86_SIMD
+  static __m128i Sse2(__m128i v)
+  {
+    // Unsigned v <= 0x1f, as there is no unsigned less than
+    const __m128i control =
+      _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v);
+    return _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+      control);
+  }
+
+  __attribute__((target("avx2")))
+  static __m256i Avx2(__m256i v)
+  {
+    const __m256i control =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v);
+    return _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+      control);
+  }
+#endif
+};
+
+struct XmlEscape
+{
+  static bool Scalar(unsigned char c)
+  {
+    return c == '&' || c == '<' || c == '>' || c == '\0';
+  }
+
+#ifdef XSONRPC_X86_SIMD
+  static __m128i Sse2(__m128i v)
+  {
+    return _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('<'))),
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('>')),
+                   _mm_cmpeq_epi8(v, _mm_setzero_si128())));
+  }
+
+  __attribute__((target("avx2")))
+  static __m256i Avx2(__m256i v)
+  {
+    return _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')),
+                      _mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+  }
+#endif
+};
+
+// Any character with the high bit set, i.e. not ASCII
+struct NonAscii
+{
+  static bool Scalar(unsigned char c) { return c >= 0x80; }
+
+#ifdef XSONRPC_X86_SIMD
+  static __m128i Sse2(__m128i v) { return v; }
+
+  __attribute__((target("avx2")))
+  static __m256i Avx2(__m256i v) { return v; }
+#endif
+};
+
+template<typename Chars>
+size_t FindScalar(const unsigned char* data, size_t i, size_t size)
+{
+  while (i < size && !Chars::Scalar(data[i])) {
+    ++i;
+  }
+  return i;
+}
+
+#ifdef XSONRPC_X86_SIMD
+
+template<typename Chars>
+size_t FindSse2(const unsigned char* data, size_t size)
+{
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // The high bit of each byte that matched
+    if (int mask = _mm_movemask_epi8(Chars::Sse2(v))) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return FindScalar<Chars>(data, i, size);
+}
+
+template<typename Chars>
+__attribute__((target("avx2")))
+size_t FindAvx2(const unsigned char* data, size_t size)
+{
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i v =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    if (uint32_t mask = _mm256_movemask_epi8(Chars::Avx2(v))) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return FindScalar<Chars>(data, i, size);
+}
+
+#endif
+
+template<typename Chars>
+size_t Find(const char* data, size_t size)
+{
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+#ifdef XSONRPC_X86_SIMD
+  // Short strings end before a vector is filled
+  if (size >= 32 && xsonrpc::util::HasAvx2()) {
+    return FindAvx2<Chars>(bytes, size);
+  }
+  return FindSse2<Chars>(bytes, size);
+#else
+  return FindScalar<Chars>(bytes, 0, size);
+#endif
+}
+
+inline bool IsContinuation(unsigned char c)
+{
+  return (c & 0xc0) == 0x80;
+}
+
+// Validates the sequence starting at data[i], which is not ASCII, and
+// returns its length, or 0 if it is ill-formed (see table 3-7 in the
+// Unicode standard)
+size_t Utf8SequenceLength(const unsigned char* data, size_t i, size_t size)
+{
+  const unsigned char c = data[i];
+  size_t length;
+  unsigned char min = 0x80;
+  unsigned char max = 0xbf;
+  if (c >= 0xc2 && c <= 0xdf) {
+    length = 2;
+  }
+  else if (c >= 0xe0 && c <= 0xef) {
+    length = 3;
+    if (c == 0xe0) {
+      min = 0xa0;
+    }
+    else if (c == 0xed) {
+      max = 0x9f;
+    }
+  }
+  else if (c >= 0xf0 && c <= 0xf4) {
+    length = 4;
+    if (c == 0xf0) {
+      min = 0x90;
+    }
+    else if (c == 0xf4) {
+      max = 0x8f;
+    }
+  }
+  else {
+    return 0;
+  }
+
+  if (size - i < length || data[i + 1] < min || data[i + 1] > max) {
+    return 0;
+  }
+  for (size_t j = 2; j < length; ++j) {
+    if (!IsContinuation(data[i + j])) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+} // namespace
+
+namespace xsonrpc {
+namespace util {
+
+size_t FindJsonEscape(const char* data, size_t size)
+{
+  return Find<JsonEscape>(data, size);
+}
+
+size_t FindXmlEscape(const char* data, size_t size)
+{
+  return Find<XmlEscape>(data, size);
+}
+
+bool IsValidUtf8(const char* data, size_t size)
+{
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  size_t i = 0;
+  while (true) {
+    // Skip ASCII in bulk, then check sequences one at a time until the next
+    // ASCII character
+    i += Find<NonAscii>(data + i, size - i);
+    while (i < size && bytes[i] >= 0x80) {
+      const size_t length = Utf8SequenceLength(bytes, i, size);
+      if (length == 0) {
+        return false;
+      }
+      i += length;
+    }
+    if (i == size) {
+      return true;
+    }
+  }
+}
+
+} // namespace util
+} // namespace xsonrpc
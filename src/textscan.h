@@ -0,0 +1,44 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_TEXTSCAN_H
+#define XSONRPC_TEXTSCAN_H
+
+#include <cstddef>
+
+namespace xsonrpc {
+namespace util {
+
+// Scanning of text that is written or read, 16 or 32 bytes at a time where
+// SSE2 or AVX2 is available. AVX2 is used only if the CPU supports it.
+
+// Return the offset of the first character in data that must be escaped, or
+// size if there is none. For JSON strings those are '"', '\\' and control
+// characters, and for XML text '&', '<', '>' and null (which XML can't
+// represent at all).
+size_t FindJsonEscape(const char* data, size_t size);
+size_t FindXmlEscape(const char* data, size_t size);
+
+// True if data is well-formed UTF-8, i.e. without overlong forms,
+// surrogates or code points above U+10FFFF
+bool IsValidUtf8(const char* data, size_t size);
+
+} // namespace util
+} // namespace xsonrpc
+
+#endif
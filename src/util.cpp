@@ -17,19 +17,28 @@
 
 #include "util.h"
 
+#include "cpu.h"
+
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
-#include <ctime>
-#include <tinyxml2.h>
+#include <limits>
 
-#ifndef HAVE_STRPTIME
-#include <iomanip>
-#include <sstream>
+#ifdef XSONRPC_X86_SIMD
+#include <immintrin.h>
 #endif
 
 namespace {
 
-const char DATE_TIME_FORMAT[] = "%Y%m%dT%T";
+const int64_t SECONDS_PER_DAY = 24 * 60 * 60;
+
+// Positions of the digits in 19980717T14:08:55
+constexpr uint8_t DATE_TIME_DIGITS[] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 9, 10, 12, 13, 15, 16
+};
 
 constexpr char BASE_64_ALPHABET[64 + 1] =
   "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -70,76 +79,634 @@ inline constexpr char Base64Char3(uint8_t byte2) noexcept
   return BASE_64_ALPHABET[byte2 & 0x3f];
 }
 
+#ifdef XSONRPC_X86_SIMD
+
+// Base64 with SSSE3 and AVX2, after Wojciech Muła and Alfred Klomp. The
+// encoders take 12 bytes per 128-bit lane, which are spread out to 16
+// six-bit indices and translated to characters. The decoders translate 16
+// characters per lane back to indices, or stop at a block with any other
+// character, and pack them into 12 bytes.
+
+__attribute__((target("ssse3")))
+inline __m128i Base64EncodeLane(__m128i in)
+{
+  // Each group of four bytes gets the three input bytes as b1 b0 b2 b1,
+  // from which multiplications move the indices into place
+  in = _mm_shuffle_epi8(
+    in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  const __m128i indices = _mm_or_si128(t1, t3);
+
+  // 0-25 -> 13, 26-51 -> 0, 52-61 -> 1-10, 62 -> 11 and 63 -> 12, which
+  // picks the offset from the index to its character
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  const __m128i isUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  range = _mm_or_si128(range, _mm_and_si128(isUpper, _mm_set1_epi8(13)));
+  const __m128i offsets = _mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+__attribute__((target("avx2")))
+inline __m256i Base64EncodeLanes(__m256i in)
+{
+  in = _mm256_shuffle_epi8(
+    in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+  const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+  const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+  const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+  const __m256i indices = _mm256_or_si256(t1, t3);
+
+  __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+  const __m256i isUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+  range = _mm256_or_si256(
+    range, _mm256_and_si256(isUpper, _mm256_set1_epi8(13)));
+  const __m256i offsets = _mm256_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  return _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+}
+
+// Encodes blocks of the first size bytes, reading at most available bytes,
+// and returns the number of bytes encoded
+__attribute__((target("ssse3")))
+size_t Base64EncodeSsse3(const char* data, size_t size, size_t available,
+                         char* str)
+{
+  size_t in = 0;
+  for (; in + 12 <= size && in + 16 <= available; in += 12, str += 16) {
+    const __m128i block =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + in));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(str),
+                     Base64EncodeLane(block));
+  }
+  return in;
+}
+
+__attribute__((target("avx2")))
+size_t Base64EncodeAvx2(const char* data, size_t size, size_t available,
+                        char* str)
+{
+  size_t in = 0;
+  for (; in + 24 <= size && in + 28 <= available; in += 24, str += 32) {
+    const __m256i block = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + in))),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + in + 12)), 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(str),
+                        Base64EncodeLanes(block));
+  }
+  return in;
+}
+
+__attribute__((target("ssse3")))
+inline bool Base64DecodeLane(__m128i& str)
+{
+  // Classes of the high and low nibble of each character, where a
+  // character is valid if the classes have no bit in common
+  const __m128i loClasses = _mm_setr_epi8(
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i hiClasses = _mm_setr_epi8(
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  // Offset from character to index by high nibble, with '/' at 1
+  const __m128i offsets = _mm_setr_epi8(
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask = _mm_set1_epi8(0x2f);
+
+  const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask);
+  const __m128i loNibbles = _mm_and_si128(str, mask);
+  const __m128i hi = _mm_shuffle_epi8(hiClasses, hiNibbles);
+  const __m128i lo = _mm_shuffle_epi8(loClasses, loNibbles);
+  if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                                       _mm_setzero_si128())) != 0) {
+    return false;
+  }
+
+  const __m128i isSlash = _mm_cmpeq_epi8(str, mask);
+  const __m128i indices = _mm_add_epi8(
+    str, _mm_shuffle_epi8(offsets, _mm_add_epi8(isSlash, hiNibbles)));
+
+  // Pack the four indices of each group into three bytes, in order
+  const __m128i pairs =
+    _mm_maddubs_epi16(indices, _mm_set1_epi32(0x01400140));
+  const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  str = _mm_shuffle_epi8(groups, _mm_setr_epi8(
+                           2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                           -1, -1, -1, -1));
+  return true;
+}
+
+__attribute__((target("avx2")))
+inline bool Base64DecodeLanes(__m256i& str)
+{
+  const __m256i loClasses = _mm256_setr_epi8(
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i hiClasses = _mm256_setr_epi8(
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i offsets = _mm256_setr_epi8(
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mask = _mm256_set1_epi8(0x2f);
+
+  const __m256i hiNibbles =
+    _mm256_and_si256(_mm256_srli_epi32(str, 4), mask);
+  const __m256i loNibbles = _mm256_and_si256(str, mask);
+  const __m256i hi = _mm256_shuffle_epi8(hiClasses, hiNibbles);
+  const __m256i lo = _mm256_shuffle_epi8(loClasses, loNibbles);
+  if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(
+                             _mm256_and_si256(lo, hi),
+                             _mm256_setzero_si256())) != 0) {
+    return false;
+  }
+
+  const __m256i isSlash = _mm256_cmpeq_epi8(str, mask);
+  const __m256i indices = _mm256_add_epi8(
+    str,
+    _mm256_shuffle_epi8(offsets, _mm256_add_epi8(isSlash, hiNibbles)));
+
+  const __m256i pairs =
+    _mm256_maddubs_epi16(indices, _mm256_set1_epi32(0x01400140));
+  const __m256i groups =
+    _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+  str = _mm256_shuffle_epi8(groups, _mm256_setr_epi8(
+                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                              -1, -1, -1, -1,
+                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                              -1, -1, -1, -1));
+  return true;
+}
+
+// Stores the 12 bytes of a decoded lane, without writing past them
+inline void StoreDecodedLane(__m128i lane, char* data)
+{
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(data), lane);
+  const int32_t last = _mm_cvtsi128_si32(_mm_srli_si128(lane, 8));
+  memcpy(data + 8, &last, 4);
+}
+
+// Decodes blocks of characters until one that isn't in the alphabet, and
+// returns the number of characters decoded
+__attribute__((target("ssse3")))
+size_t Base64DecodeSsse3(const char* str, size_t size, char* data)
+{
+  size_t in = 0;
+  for (; in + 16 <= size; in += 16, data += 12) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + in));
+    if (!Base64DecodeLane(block)) {
+      break;
+    }
+    StoreDecodedLane(block, data);
+  }
+  return in;
+}
+
+__attribute__((target("avx2")))
+size_t Base64DecodeAvx2(const char* str, size_t size, char* data)
+{
+  size_t in = 0;
+  for (; in + 32 <= size; in += 32, data += 24) {
+    __m256i block =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + in));
+    if (!Base64DecodeLanes(block)) {
+      break;
+    }
+    StoreDecodedLane(_mm256_castsi256_si128(block), data);
+    StoreDecodedLane(_mm256_extracti128_si256(block, 1), data + 12);
+  }
+  return in;
+}
+
+#endif
+
+// Encodes whole groups of three of the first size bytes with the fastest
+// kernel the CPU supports, reading at most available bytes. Returns the
+// number of bytes encoded.
+inline size_t Base64EncodeBlocks(const char* data, size_t size,
+                                 size_t available, char* str)
+{
+  size_t in = 0;
+#ifdef XSONRPC_X86_SIMD
+  using namespace xsonrpc::util;
+  if (HasAvx2()) {
+    in = Base64EncodeAvx2(data, size, available, str);
+  }
+  if (HasSsse3()) {
+    in += Base64EncodeSsse3(data + in, size - in, available - in,
+                            str + in / 3 * 4);
+  }
+#else
+  (void)data; (void)size; (void)available; (void)str;
+#endif
+  return in;
+}
+
+// Decodes blocks of characters in the alphabet, and returns the number of
+// characters decoded, which give three bytes for every four
+inline size_t Base64DecodeBlocks(const char* str, size_t size, char* data)
+{
+  size_t in = 0;
+#ifdef XSONRPC_X86_SIMD
+  using namespace xsonrpc::util;
+  if (HasAvx2()) {
+    in = Base64DecodeAvx2(str, size, data);
+  }
+  if (HasSsse3()) {
+    in += Base64DecodeSsse3(str + in, size - in, data + in / 4 * 3);
+  }
+#else
+  (void)str; (void)size; (void)data;
+#endif
+  return in;
+}
+
+inline unsigned Digit(const char* text, size_t i)
+{
+  return static_cast<uint8_t>(text[i]) - static_cast<unsigned>('0');
+}
+
+inline unsigned TwoDigits(const char* text, size_t i)
+{
+  return Digit(text, i) * 10 + Digit(text, i + 1);
+}
+
+inline char* WriteTwoDigits(unsigned value, char* out)
+{
+  out[0] = static_cast<char>('0' + value / 10);
+  out[1] = static_cast<char>('0' + value % 10);
+  return out + 2;
+}
+
+inline bool IsLeapYear(unsigned year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+inline bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Removes surrounding whitespace, returns false if nothing is left
+bool Trim(const char*& text, size_t& size)
+{
+  while (size > 0 && IsSpace(*text)) {
+    ++text;
+    --size;
+  }
+  while (size > 0 && IsSpace(text[size - 1])) {
+    --size;
+  }
+  return size > 0;
+}
+
+// Consumes a leading sign, returns true if it is a minus
+bool ParseSign(const char*& text, size_t& size)
+{
+  if (size > 0 && (*text == '-' || *text == '+')) {
+    --size;
+    return *text++ == '-';
+  }
+  return false;
+}
+
+template<typename T>
+bool ParseSignedInteger(const char* text, size_t size, T& value)
+{
+  if (!Trim(text, size)) {
+    return false;
+  }
+  const bool negative = ParseSign(text, size);
+  if (size == 0) {
+    return false;
+  }
+
+  const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max())
+    + (negative ? 1 : 0);
+  uint64_t magnitude = 0;
+  for (size_t i = 0; i < size; ++i) {
+    const unsigned digit = static_cast<unsigned>(text[i] - '0');
+    if (digit > 9 || magnitude > (limit - digit) / 10) {
+      return false;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+
+  if (negative && magnitude != 0) {
+    // Written to not overflow for the minimum value
+    value = -static_cast<T>(magnitude - 1) - 1;
+  }
+  else {
+    value = static_cast<T>(magnitude);
+  }
+  return true;
+}
+
+// Powers of ten that are exact as doubles
+const double EXACT_POWERS_OF_TEN[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Longest double handed to strtod
+const size_t MAX_DOUBLE_LENGTH = 128;
+
 } // namespace
 
 namespace xsonrpc {
 namespace util {
 
-bool IsTag(const tinyxml2::XMLElement& element, const char* tag)
+// Algorithms from http://howardhinnant.github.io/date_algorithms.html
+int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
 {
-  return strcmp(element.Name(), tag) == 0;
+  year -= month <= 2;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+  const unsigned dayOfYear =
+    (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned dayOfEra =
+    yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
 }
 
-bool HasEmptyText(const tinyxml2::XMLElement& element)
+void CivilFromDays(int64_t days, int64_t& year, unsigned& month,
+                   unsigned& day)
 {
-  auto text = element.GetText();
-  return !text || text[0] == '\0';
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+  const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524
+                              - dayOfEra / 146096) / 365;
+  const unsigned dayOfYear =
+    dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+  day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+  month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
 }
 
-std::string FormatIso8601DateTime(const tm& dt)
+char* FormatIso8601DateTime(const Value::DateTime& dt, char* out)
 {
-  char str[128];
-  return std::string(str, strftime(str, sizeof(str), DATE_TIME_FORMAT, &dt));
+  int64_t days = dt.GetSecondsSinceEpoch() / SECONDS_PER_DAY;
+  int64_t seconds = dt.GetSecondsSinceEpoch() % SECONDS_PER_DAY;
+  if (seconds < 0) {
+    seconds += SECONDS_PER_DAY;
+    --days;
+  }
+
+  int64_t year;
+  unsigned month;
+  unsigned day;
+  CivilFromDays(days, year, month, day);
+
+  // At least four digits, like %Y
+  if (year < 0) {
+    *out++ = '-';
+  }
+  uint64_t absYear = year < 0 ? -static_cast<uint64_t>(year) : year;
+  char digits[20];
+  size_t count = 0;
+  do {
+    digits[count++] = static_cast<char>('0' + absYear % 10);
+    absYear /= 10;
+  } while (absYear != 0 || count < 4);
+  while (count > 0) {
+    *out++ = digits[--count];
+  }
+
+  out = WriteTwoDigits(month, out);
+  out = WriteTwoDigits(day, out);
+  *out++ = 'T';
+  out = WriteTwoDigits(static_cast<unsigned>(seconds / 3600), out);
+  *out++ = ':';
+  out = WriteTwoDigits(static_cast<unsigned>(seconds / 60 % 60), out);
+  *out++ = ':';
+  return WriteTwoDigits(static_cast<unsigned>(seconds % 60), out);
 }
 
-bool ParseIso8601DateTime(const char* text, tm& dt)
+bool ParseIso8601DateTime(const char* text, size_t size, Value::DateTime& dt)
 {
-  if (!text) {
+  if (size != ISO_8601_DATE_TIME_LENGTH) {
     return false;
   }
-  memset(&dt, 0, sizeof(dt));
-#ifdef HAVE_STRPTIME
-  auto* res = strptime(text, DATE_TIME_FORMAT, &dt);
-  if (!res || *res != '\0') {
+
+  // Accumulate all checks and test once at the end
+  unsigned invalid = (text[8] ^ 'T') | (text[11] ^ ':') | (text[14] ^ ':');
+  for (auto i : DATE_TIME_DIGITS) {
+    invalid |= Digit(text, i) > 9;
+  }
+  if (invalid) {
     return false;
   }
-#else
-  std::istringstream ss(text);
-  if (!(ss >> std::get_time(&dt, DATE_TIME_FORMAT))) {
+
+  const unsigned year = TwoDigits(text, 0) * 100 + TwoDigits(text, 2);
+  const unsigned month = TwoDigits(text, 4);
+  const unsigned day = TwoDigits(text, 6);
+  const unsigned hour = TwoDigits(text, 9);
+  const unsigned minute = TwoDigits(text, 12);
+  const unsigned second = TwoDigits(text, 15);
+
+  static const uint8_t daysInMonth[] = {
+    0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+  };
+  if (month - 1 > 11 || hour > 23 || minute > 59 || second > 59
+      || day - 1 >= daysInMonth[month]
+                    + (month == 2 && IsLeapYear(year) ? 1u : 0u)) {
     return false;
   }
-#endif
-  dt.tm_isdst = -1;
+
+  dt = Value::DateTime(DaysFromCivil(year, month, day) * SECONDS_PER_DAY
+                       + hour * 3600 + minute * 60 + second);
   return true;
 }
 
-std::string Base64Encode(const char* data, size_t size)
+bool ParseInteger(const char* text, size_t size, int32_t& value)
 {
-  const size_t lineLength = 76;
-  static_assert(lineLength % 4 == 0, "invalid line length");
+  return ParseSignedInteger(text, size, value);
+}
 
-  if (size == 0) {
-    return {};
+bool ParseInteger(const char* text, size_t size, int64_t& value)
+{
+  return ParseSignedInteger(text, size, value);
+}
+
+bool ParseDouble(const char* text, size_t size, double& value)
+{
+  if (!Trim(text, size)) {
+    return false;
+  }
+  const char* const start = text;
+  const size_t length = size;
+
+  // Validate and try the exact fast path: up to 19 significant digits
+  // and a power of ten small enough to be exact
+  const bool negative = ParseSign(text, size);
+  uint64_t mantissa = 0;
+  unsigned mantissaDigits = 0;
+  int exponent = 0;
+  bool hasDigits = false;
+  bool exact = true;
+
+  for (; size > 0 && static_cast<unsigned>(*text - '0') <= 9; ++text, --size) {
+    hasDigits = true;
+    if (mantissa == 0 && *text == '0') {
+      continue;
+    }
+    if (mantissaDigits < 19) {
+      mantissa = mantissa * 10 + (*text - '0');
+      ++mantissaDigits;
+    }
+    else {
+      exact = false;
+    }
+  }
+  if (size > 0 && *text == '.') {
+    ++text;
+    --size;
+    for (; size > 0 && static_cast<unsigned>(*text - '0') <= 9;
+         ++text, --size) {
+      hasDigits = true;
+      if (mantissa == 0 && *text == '0') {
+        --exponent;
+        continue;
+      }
+      if (mantissaDigits < 19) {
+        mantissa = mantissa * 10 + (*text - '0');
+        ++mantissaDigits;
+        --exponent;
+      }
+      else {
+        exact = false;
+      }
+    }
+  }
+  if (!hasDigits) {
+    return false;
+  }
+  if (size > 0 && (*text == 'e' || *text == 'E')) {
+    ++text;
+    --size;
+    int32_t explicitExponent;
+    if (size == 0 || IsSpace(*text)
+        || !ParseSignedInteger(text, size, explicitExponent)) {
+      return false;
+    }
+    if (explicitExponent > 10000 || explicitExponent < -10000) {
+      exact = false;
+    }
+    else {
+      exponent += explicitExponent;
+    }
+    size = 0;
+  }
+  if (size != 0) {
+    return false;
+  }
+
+  if (exact && mantissa <= (uint64_t(1) << 53)
+      && exponent >= -22 && exponent <= 22) {
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+      result /= EXACT_POWERS_OF_TEN[-exponent];
+    }
+    else {
+      result *= EXACT_POWERS_OF_TEN[exponent];
+    }
+    value = negative ? -result : result;
+    return true;
+  }
+
+  // The syntax has been checked, so strtod only sees a plain number
+  if (length >= MAX_DOUBLE_LENGTH) {
+    return false;
+  }
+  char buffer[MAX_DOUBLE_LENGTH];
+  memcpy(buffer, start, length);
+  buffer[length] = '\0';
+  char* end;
+  errno = 0;
+  const double result = strtod(buffer, &end);
+  if (end != buffer + length || (errno == ERANGE && std::isinf(result))) {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+bool ParseBoolean(const char* text, size_t size, bool& value)
+{
+  if (!Trim(text, size)) {
+    return false;
+  }
+  if (size == 1 && (*text == '0' || *text == '1')) {
+    value = *text == '1';
+    return true;
   }
+  // Not in the XML-RPC spec, but accepted by many
+  if (size == 4 && memcmp(text, "true", 4) == 0) {
+    value = true;
+    return true;
+  }
+  if (size == 5 && memcmp(text, "false", 5) == 0) {
+    value = false;
+    return true;
+  }
+  return false;
+}
 
-  const size_t encodedSize = 4 * ((size + 2) / 3);
-  std::string str(encodedSize + 2 * ((encodedSize - 1) / lineLength), '\0');
+std::string Base64Encode(const char* data, size_t size)
+{
+  std::string str(Base64EncodedSize(size), '\0');
+  Base64Encode(data, size, &str[0]);
+  return str;
+}
+
+char* Base64Encode(const char* data, size_t size, char* str)
+{
+  static_assert(BASE_64_LINE_LENGTH % 4 == 0, "invalid line length");
+  const size_t lineSize = BASE_64_LINE_LENGTH / 4 * 3;
 
   size_t in = 0;
   size_t out = 0;
-  for (size_t wrap = lineLength; in + 3 <= size; in += 3, wrap -= 4) {
-    if (wrap == 0) {
+  while (in < size) {
+    const size_t lineEnd = std::min(in + lineSize, size);
+    const size_t encoded =
+      Base64EncodeBlocks(data + in, lineEnd - in, size - in, str + out);
+    out += encoded / 3 * 4;
+    in += encoded;
+
+    for (; in + 3 <= lineEnd; in += 3) {
+      str[out++] = Base64Char0(data[in]);
+      str[out++] = Base64Char1(data[in], data[in + 1]);
+      str[out++] = Base64Char2(data[in + 1], data[in + 2]);
+      str[out++] = Base64Char3(data[in + 2]);
+    }
+
+    if (in == size) {
+      break;
+    }
+    else if (in == lineEnd) {
       str[out++] = '\r';
       str[out++] = '\n';
-      wrap = lineLength;
+      continue;
     }
-    str[out++] = Base64Char0(data[in]);
-    str[out++] = Base64Char1(data[in], data[in + 1]);
-    str[out++] = Base64Char2(data[in + 1], data[in + 2]);
-    str[out++] = Base64Char3(data[in + 2]);
-  }
 
-  if (in < size) {
+    // The last one or two bytes
     str[out++] = Base64Char0(data[in]);
     if (in + 1 < size) {
       str[out++] = Base64Char1(data[in], data[in + 1]);
@@ -150,28 +717,44 @@ std::string Base64Encode(const char* data, size_t size)
       str[out++] = '=';
     }
     str[out++] = '=';
+    break;
   }
 
-  assert(str.size() == out);
-  return str;
+  assert(Base64EncodedSize(size) == out);
+  return str + out;
 }
 
 std::string Base64Decode(const char* str, size_t size)
 {
-  const size_t maxDecodedSize = 3 * ((size + 3) / 4);
-
-  std::string data(maxDecodedSize, '\0');
+  std::string data(Base64DecodedMaxSize(size), '\0');
+  data.resize(Base64Decode(str, size, &data[0]));
+  return data;
+}
 
+size_t Base64Decode(const char* str, size_t size, char* data)
+{
   size_t out = 0;
   uint32_t bits = 0;
   size_t bitCount = 0;
 
   for (size_t in = 0; in < size; ++in) {
+    if (bitCount == 0) {
+      // Between groups, decode as much as possible in blocks, e.g. a line
+      const size_t decoded = Base64DecodeBlocks(str + in, size - in,
+                                                data + out);
+      in += decoded;
+      out += decoded / 4 * 3;
+      if (in == size) {
+        break;
+      }
+    }
+
     const int value = BASE_64_LUT[static_cast<uint8_t>(str[in])];
     if (value != -1) {
       bits = (bits << 6) | value;
       bitCount += 6;
       if (bitCount == 24) {
+        // Three bytes out for every four in, so this never overtakes str
         data[out++] = bits >> 16;
         data[out++] = bits >> 8;
         data[out++] = bits;
@@ -190,9 +773,8 @@ std::string Base64Decode(const char* str, size_t size)
     data[out++] = bits;
   }
 
-  assert(data.size() >= out);
-  data.resize(out);
-  return data;
+  assert(Base64DecodedMaxSize(size) >= out);
+  return out;
 }
 
 } // namespace util
@@ -18,41 +18,86 @@
 #ifndef XSONRPC_UTIL_H
 #define XSONRPC_UTIL_H
 
+#include "value.h"
+
 #include <stdint.h>
 #include <string>
 
-namespace tinyxml2 {
-class XMLElement;
-}
-
-struct tm;
-
 namespace xsonrpc {
 namespace util {
 
-bool IsTag(const tinyxml2::XMLElement& element, const char* tag);
-bool HasEmptyText(const tinyxml2::XMLElement& element);
+// Days since 1970-01-01 in the proleptic Gregorian calendar, and back
+int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day);
+void CivilFromDays(int64_t days, int64_t& year, unsigned& month,
+                   unsigned& day);
 
-std::string FormatIso8601DateTime(const tm& dt);
-bool ParseIso8601DateTime(const char* text, tm& dt);
+// Length of a date/time in the XML-RPC format, e.g. 19980717T14:08:55
+const size_t ISO_8601_DATE_TIME_LENGTH = 17;
+// Years outside 0000-9999 are formatted with a sign and/or more digits
+const size_t ISO_8601_DATE_TIME_MAX_LENGTH = 32;
+
+// Writes dt to out, which must hold ISO_8601_DATE_TIME_MAX_LENGTH chars, and
+// returns a pointer past the last char written (no null termination)
+char* FormatIso8601DateTime(const Value::DateTime& dt, char* out);
+bool ParseIso8601DateTime(const char* text, size_t size, Value::DateTime& dt);
+// Cheap check to rule out most strings before trying to parse them
+inline bool MaybeIso8601DateTime(const char* text, size_t size);
+
+// Number and boolean parsing in the style of std::from_chars, i.e. without
+// exceptions or allocation, but allowing surrounding whitespace and a
+// leading '+'. Return false if text is invalid or out of range.
+bool ParseInteger(const char* text, size_t size, int32_t& value);
+bool ParseInteger(const char* text, size_t size, int64_t& value);
+bool ParseDouble(const char* text, size_t size, double& value);
+bool ParseBoolean(const char* text, size_t size, bool& value);
+
+// Encoded lines are broken with CRLF after this many chars
+const size_t BASE_64_LINE_LENGTH = 76;
 
 inline std::string Base64Encode(const std::string& data);
 std::string Base64Encode(const char* data, size_t size);
+// Encodes into str, which must hold Base64EncodedSize(size) chars, and
+// returns a pointer past the last char written (no null termination)
+char* Base64Encode(const char* data, size_t size, char* str);
+// Including the line breaks
+inline size_t Base64EncodedSize(size_t size);
 
 inline std::string Base64Decode(const std::string& str);
 std::string Base64Decode(const char* str, size_t size);
+// Decodes into data, which may be str to decode in place. Returns the
+// decoded size, at most Base64DecodedMaxSize(size).
+size_t Base64Decode(const char* str, size_t size, char* data);
+inline size_t Base64DecodedMaxSize(size_t size);
 
 } // namespace util
 } // namespace xsonrpc
 
+inline bool xsonrpc::util::MaybeIso8601DateTime(const char* text, size_t size)
+{
+  return size == ISO_8601_DATE_TIME_LENGTH && text[8] == 'T'
+    && static_cast<unsigned>(text[0] - '0') <= 9;
+}
+
 inline std::string xsonrpc::util::Base64Encode(const std::string& data)
 {
   return Base64Encode(data.data(), data.size());
 }
 
+inline size_t xsonrpc::util::Base64EncodedSize(size_t size)
+{
+  const size_t encodedSize = 4 * ((size + 2) / 3);
+  return size == 0
+    ? 0 : encodedSize + 2 * ((encodedSize - 1) / BASE_64_LINE_LENGTH);
+}
+
 inline std::string xsonrpc::util::Base64Decode(const std::string& str)
 {
   return Base64Decode(str.data(), str.size());
 }
 
+inline size_t xsonrpc::util::Base64DecodedMaxSize(size_t size)
+{
+  return 3 * ((size + 3) / 4);
+}
+
 #endif
@@ -19,14 +19,277 @@
 
 #include "util.h"
 #include "fault.h"
+#include "jsonreader.h"
+#include "valueserializer.h"
 #include "writer.h"
+#include "xml.h"
+#include "xmlreader.h"
 
+#include <cstring>
+#include <ctime>
 #include <limits>
+#include <memory>
 #include <ostream>
+#include <stdexcept>
 #include <string>
 
+namespace {
+
+// Creates a value per element of a packed array on first use and keeps
+// them, so that AsArray can return a reference
+template<typename PackedArrayType>
+const xsonrpc::Value::Array& Box(const PackedArrayType& packed)
+{
+  if (!packed.Values) {
+    packed.Values.reset(new xsonrpc::Value::Array(
+        packed.Elements.begin(), packed.Elements.end()));
+  }
+  return *packed.Values;
+}
+
+// Writes the elements of a generated array as they are produced
+class GeneratedArray final : public xsonrpc::Value::Writable
+{
+public:
+  explicit GeneratedArray(
+    std::shared_ptr<xsonrpc::Value::Generator> generator)
+    : myGenerator(std::move(generator))
+  {
+  }
+
+  xsonrpc::Value::Type GetType() const override
+  {
+    return xsonrpc::Value::Type::ARRAY;
+  }
+
+  Writable* Clone() const override { return new GeneratedArray(myGenerator); }
+
+  void Write(xsonrpc::Writer& writer) const override
+  {
+    writer.StartArray();
+    xsonrpc::Value element;
+    while (myGenerator->Next(element)) {
+      element.Write(writer);
+    }
+    writer.EndArray();
+  }
+
+  xsonrpc::Value CreateValue() const override
+  {
+    xsonrpc::Value::Array array;
+    xsonrpc::Value element;
+    while (myGenerator->Next(element)) {
+      array.push_back(std::move(element));
+    }
+    return xsonrpc::Value(std::move(array));
+  }
+
+  xsonrpc::Value::Generator* GetGenerator() const override
+  {
+    return myGenerator.get();
+  }
+
+private:
+  std::shared_ptr<xsonrpc::Value::Generator> myGenerator;
+};
+
+const char WHITESPACE[] = " \t\r\n";
+
+// The type of a JSON value from its first character, or for numbers from
+// whether they are integers that fit
+xsonrpc::Value::Type GetJsonType(const std::string& data)
+{
+  using Type = xsonrpc::Value::Type;
+  using namespace xsonrpc::util;
+
+  const auto start = data.find_first_not_of(WHITESPACE);
+  if (start == std::string::npos) {
+    throw std::invalid_argument("json: empty value");
+  }
+
+  int32_t integer32;
+  int64_t integer64;
+  switch (data[start]) {
+    case '[': return Type::ARRAY;
+    case '{': return Type::STRUCT;
+    case '"': return Type::STRING;
+    case 't': case 'f': return Type::BOOLEAN;
+    case 'n': return Type::NIL;
+    default:
+      if (ParseInteger(data.data(), data.size(), integer32)) {
+        return Type::INTEGER_32;
+      }
+      else if (ParseInteger(data.data(), data.size(), integer64)) {
+        return Type::INTEGER_64;
+      }
+      return Type::DOUBLE;
+  }
+}
+
+template<size_t N>
+bool HasTag(const std::string& data, size_t pos, const char (&name)[N])
+{
+  return data.compare(pos, N - 1, name) == 0
+    && pos + N - 1 < data.size()
+    && (data[pos + N - 1] == '>' || data[pos + N - 1] == '/'
+        || strchr(WHITESPACE, data[pos + N - 1]) != nullptr);
+}
+
+// The type of an XML <value> from the tag of its first element, or string
+// if it has only text
+xsonrpc::Value::Type GetXmlType(const std::string& data)
+{
+  using Type = xsonrpc::Value::Type;
+  using namespace xsonrpc::xml;
+
+  auto pos = data.find_first_not_of(WHITESPACE);
+  if (pos == std::string::npos || data[pos] != '<'
+      || !HasTag(data, pos + 1, VALUE_TAG)) {
+    throw std::invalid_argument("xml: missing value element");
+  }
+  pos = data.find('>', pos);
+  if (pos == std::string::npos || data[pos - 1] == '/') {
+    return Type::STRING;
+  }
+  pos = data.find_first_not_of(WHITESPACE, pos + 1);
+  if (pos == std::string::npos || data[pos] != '<') {
+    return Type::STRING;
+  }
+
+  ++pos;
+  if (HasTag(data, pos, ARRAY_TAG)) {
+    return Type::ARRAY;
+  }
+  else if (HasTag(data, pos, BASE_64_TAG)) {
+    return Type::BINARY;
+  }
+  else if (HasTag(data, pos, BOOLEAN_TAG)) {
+    return Type::BOOLEAN;
+  }
+  else if (HasTag(data, pos, DATE_TIME_TAG)) {
+    return Type::DATE_TIME;
+  }
+  else if (HasTag(data, pos, DOUBLE_TAG)) {
+    return Type::DOUBLE;
+  }
+  else if (HasTag(data, pos, INTEGER_32_TAG)
+           || HasTag(data, pos, INTEGER_INT_TAG)) {
+    return Type::INTEGER_32;
+  }
+  else if (HasTag(data, pos, INTEGER_64_TAG)) {
+    return Type::INTEGER_64;
+  }
+  else if (HasTag(data, pos, NIL_TAG)) {
+    return Type::NIL;
+  }
+  else if (HasTag(data, pos, STRUCT_TAG)) {
+    return Type::STRUCT;
+  }
+  // An end tag or some other markup
+  return Type::STRING;
+}
+
+// Writes a value that is already encoded, if the writer uses its format
+class RawValue final : public xsonrpc::Value::Writable
+{
+public:
+  RawValue(xsonrpc::Value::Format format,
+           std::shared_ptr<const std::string> data)
+    : myFormat(format),
+      myData(std::move(data)),
+      myType(format == xsonrpc::Value::Format::JSON
+             ? GetJsonType(*myData) : GetXmlType(*myData))
+  {
+  }
+
+  xsonrpc::Value::Type GetType() const override { return myType; }
+
+  Writable* Clone() const override { return new RawValue(*this); }
+
+  void Write(xsonrpc::Writer& writer) const override
+  {
+    if (!writer.WriteRaw(myFormat, myData->data(), myData->size())) {
+      CreateValue().Write(writer);
+    }
+  }
+
+  xsonrpc::Value CreateValue() const override
+  {
+    // Without type inference, so that the contents have the type given by
+    // GetJsonType
+    if (myFormat == xsonrpc::Value::Format::JSON) {
+      return xsonrpc::JsonReader(*myData, false).GetValue();
+    }
+    return xsonrpc::XmlReader(*myData).GetValue();
+  }
+
+private:
+  xsonrpc::Value::Format myFormat;
+  std::shared_ptr<const std::string> myData;
+  xsonrpc::Value::Type myType;
+};
+
+} // namespace
+
 namespace xsonrpc {
 
+template<typename T>
+struct Value::PackedArray
+{
+  explicit PackedArray(std::vector<T> elements)
+    : Elements(std::move(elements))
+  {
+  }
+
+  std::vector<T> Elements;
+  // Created by the first call to AsArray(), see Box
+  mutable std::unique_ptr<Array> Values;
+};
+
+Value::DateTime::DateTime(const tm& value)
+{
+  // Normalizes out of range fields the same way timegm does
+  int64_t year = value.tm_year + int64_t(1900) + value.tm_mon / 12;
+  int month = value.tm_mon % 12;
+  if (month < 0) {
+    month += 12;
+    --year;
+  }
+  const int64_t days = util::DaysFromCivil(year, month + 1, 1)
+    + value.tm_mday - 1;
+  mySecondsSinceEpoch = days * 86400 + value.tm_hour * int64_t(3600)
+    + value.tm_min * int64_t(60) + value.tm_sec;
+}
+
+tm Value::DateTime::ToTm() const
+{
+  int64_t days = mySecondsSinceEpoch / 86400;
+  int64_t seconds = mySecondsSinceEpoch % 86400;
+  if (seconds < 0) {
+    seconds += 86400;
+    --days;
+  }
+
+  int64_t year;
+  unsigned month;
+  unsigned day;
+  util::CivilFromDays(days, year, month, day);
+
+  tm dt;
+  memset(&dt, 0, sizeof(dt));
+  dt.tm_year = static_cast<int>(year - 1900);
+  dt.tm_mon = month - 1;
+  dt.tm_mday = day;
+  dt.tm_hour = static_cast<int>(seconds / 3600);
+  dt.tm_min = static_cast<int>(seconds / 60 % 60);
+  dt.tm_sec = static_cast<int>(seconds % 60);
+  // 1970-01-01 was a Thursday
+  dt.tm_wday = static_cast<int>((days % 7 + 11) % 7);
+  dt.tm_yday = static_cast<int>(days - util::DaysFromCivil(year, 1, 1));
+  dt.tm_isdst = -1;
+  return dt;
+}
+
 Value::Value(Array value)
   : myType(Type::ARRAY)
 {
@@ -36,8 +299,7 @@ Value::Value(Array value)
 Value::Value(const DateTime& value)
   : myType(Type::DATE_TIME)
 {
-  as.myDateTime = new DateTime(value);
-  as.myDateTime->tm_isdst = -1;
+  as.myDateTime = value;
 }
 
 Value::Value(int32_t value)
@@ -67,12 +329,61 @@ Value::Value(String value, bool binary)
   as.myString = new String(std::move(value));
 }
 
+Value::Value(StringRef value, bool binary)
+  : myType(binary ? Type::BINARY : Type::STRING),
+    myIsStringRef(true)
+{
+  as.myStringRef.Ref = value;
+  as.myStringRef.Copy = nullptr;
+}
+
 Value::Value(Struct value)
   : myType(Type::STRUCT)
 {
   as.myStruct = new Struct(std::move(value));
 }
 
+Value::Value(std::unique_ptr<Writable> value)
+  : myType(value->GetType()),
+    myIsWritable(true)
+{
+  as.myWritable.Object = value.release();
+  as.myWritable.Converted = nullptr;
+}
+
+Value::Value(std::unique_ptr<Generator> generator)
+  : Value(std::unique_ptr<Writable>(
+            new GeneratedArray(std::move(generator))))
+{
+}
+
+Value::Value(Format format, String data)
+  : Value(std::unique_ptr<Writable>(new RawValue(
+            format, std::make_shared<const std::string>(std::move(data)))))
+{
+}
+
+Value::Value(std::vector<int32_t> value)
+  : myType(Type::ARRAY),
+    myPacking(Packing::INTEGER_32)
+{
+  as.myInteger32Array = new PackedArray<int32_t>(std::move(value));
+}
+
+Value::Value(std::vector<int64_t> value)
+  : myType(Type::ARRAY),
+    myPacking(Packing::INTEGER_64)
+{
+  as.myInteger64Array = new PackedArray<int64_t>(std::move(value));
+}
+
+Value::Value(std::vector<double> value)
+  : myType(Type::ARRAY),
+    myPacking(Packing::DOUBLE)
+{
+  as.myDoubleArray = new PackedArray<double>(std::move(value));
+}
+
 Value::~Value()
 {
   Reset();
@@ -80,10 +391,22 @@ Value::~Value()
 
 Value::Value(const Value& other)
   : myType(other.myType),
+    myIsWritable(other.myIsWritable),
+    myPacking(other.myPacking),
     as(other.as)
 {
+  if (myIsWritable) {
+    as.myWritable.Object = other.as.myWritable.Object->Clone();
+    as.myWritable.Converted = nullptr;
+    if (other.as.myWritable.Converted) {
+      as.myWritable.Converted = new Value(*other.as.myWritable.Converted);
+    }
+    return;
+  }
+
   switch (myType) {
     case Type::BOOLEAN:
+    case Type::DATE_TIME:
     case Type::DOUBLE:
     case Type::INTEGER_32:
     case Type::INTEGER_64:
@@ -91,14 +414,29 @@ Value::Value(const Value& other)
       break;
 
     case Type::ARRAY:
-      as.myArray = new Array(other.AsArray());
-      break;
-    case Type::DATE_TIME:
-      as.myDateTime = new DateTime(other.AsDateTime());
+      switch (myPacking) {
+        case Packing::NONE:
+          as.myArray = new Array(other.AsArray());
+          break;
+        case Packing::INTEGER_32:
+          as.myInteger32Array = new PackedArray<int32_t>(
+            other.as.myInteger32Array->Elements);
+          break;
+        case Packing::INTEGER_64:
+          as.myInteger64Array = new PackedArray<int64_t>(
+            other.as.myInteger64Array->Elements);
+          break;
+        case Packing::DOUBLE:
+          as.myDoubleArray = new PackedArray<double>(
+            other.as.myDoubleArray->Elements);
+          break;
+      }
       break;
     case Type::BINARY:
     case Type::STRING:
-      as.myString = new String(other.AsString());
+      // A copy always owns its data as it may outlive the referenced buffer
+      as.myString = new String(other.AsStringRef().Data,
+                               other.AsStringRef().Size);
       break;
     case Type::STRUCT:
       as.myStruct = new Struct(other.AsStruct());
@@ -108,9 +446,15 @@ Value::Value(const Value& other)
 
 Value::Value(Value&& other) noexcept
   : myType(other.myType),
+    myIsStringRef(other.myIsStringRef),
+    myIsWritable(other.myIsWritable),
+    myPacking(other.myPacking),
     as(other.as)
 {
   other.myType = Type::NIL;
+  other.myIsStringRef = false;
+  other.myIsWritable = false;
+  other.myPacking = Packing::NONE;
 }
 
 Value& Value::operator=(Value&& other) noexcept
@@ -119,23 +463,44 @@ Value& Value::operator=(Value&& other) noexcept
     Reset();
 
     myType = other.myType;
+    myIsStringRef = other.myIsStringRef;
+    myIsWritable = other.myIsWritable;
+    myPacking = other.myPacking;
     as = other.as;
 
     other.myType = Type::NIL;
+    other.myIsStringRef = false;
+    other.myIsWritable = false;
+    other.myPacking = Packing::NONE;
   }
   return *this;
 }
 
 const Value::Array& Value::AsArray() const
 {
+  if (myIsWritable) {
+    return Convert().AsArray();
+  }
   if (IsArray()) {
-    return *as.myArray;
+    switch (myPacking) {
+      case Packing::NONE:
+        return *as.myArray;
+      case Packing::INTEGER_32:
+        return Box(*as.myInteger32Array);
+      case Packing::INTEGER_64:
+        return Box(*as.myInteger64Array);
+      case Packing::DOUBLE:
+        return Box(*as.myDoubleArray);
+    }
   }
   throw InvalidParametersFault();
 }
 
 const bool& Value::AsBoolean() const
 {
+  if (myIsWritable) {
+    return Convert().AsBoolean();
+  }
   if (IsBoolean()) {
     return as.myBoolean;
   }
@@ -144,14 +509,20 @@ const bool& Value::AsBoolean() const
 
 const Value::DateTime& Value::AsDateTime() const
 {
+  if (myIsWritable) {
+    return Convert().AsDateTime();
+  }
   if (IsDateTime()) {
-    return *as.myDateTime;
+    return as.myDateTime;
   }
   throw InvalidParametersFault();
 }
 
 const double& Value::AsDouble() const
 {
+  if (myIsWritable) {
+    return Convert().AsDouble();
+  }
   if (IsDouble() || IsInteger32() || IsInteger64()) {
     return as.myDouble;
   }
@@ -160,6 +531,9 @@ const double& Value::AsDouble() const
 
 const int32_t& Value::AsInteger32() const
 {
+  if (myIsWritable) {
+    return Convert().AsInteger32();
+  }
   if (IsInteger32()) {
     return as.myInteger32;
   }
@@ -172,6 +546,9 @@ const int32_t& Value::AsInteger32() const
 
 const int64_t& Value::AsInteger64() const
 {
+  if (myIsWritable) {
+    return Convert().AsInteger64();
+  }
   if (IsInteger32() || IsInteger64()) {
     return as.myInteger64;
   }
@@ -180,84 +557,142 @@ const int64_t& Value::AsInteger64() const
 
 const Value::String& Value::AsString() const
 {
+  if (myIsWritable) {
+    return Convert().AsString();
+  }
   if (IsString() || IsBinary()) {
+    if (myIsStringRef) {
+      // The caller wants a std::string, so take a copy of the referenced
+      // data once and keep it (use AsStringRef to avoid the copy)
+      auto& stringRef = as.myStringRef;
+      if (!stringRef.Copy) {
+        stringRef.Copy = new String(stringRef.Ref.Data, stringRef.Ref.Size);
+      }
+      return *stringRef.Copy;
+    }
     return *as.myString;
   }
   throw InvalidParametersFault();
 }
 
+Value::StringRef Value::AsStringRef() const
+{
+  if (myIsWritable) {
+    return Convert().AsStringRef();
+  }
+  if (IsString() || IsBinary()) {
+    auto string = myIsStringRef ? as.myStringRef.Copy : as.myString;
+    if (!string) {
+      return as.myStringRef.Ref;
+    }
+    return {string->data(), string->size()};
+  }
+  throw InvalidParametersFault();
+}
+
 const Value::Struct& Value::AsStruct() const
 {
+  if (myIsWritable) {
+    return Convert().AsStruct();
+  }
   if (IsStruct()) {
     return *as.myStruct;
   }
   throw InvalidParametersFault();
 }
 
+const std::vector<int32_t>& Value::AsInteger32Array() const
+{
+  if (myIsWritable) {
+    return Convert().AsInteger32Array();
+  }
+  if (IsInteger32Array()) {
+    return as.myInteger32Array->Elements;
+  }
+  throw InvalidParametersFault();
+}
+
+const std::vector<int64_t>& Value::AsInteger64Array() const
+{
+  if (myIsWritable) {
+    return Convert().AsInteger64Array();
+  }
+  if (IsInteger64Array()) {
+    return as.myInteger64Array->Elements;
+  }
+  throw InvalidParametersFault();
+}
+
+const std::vector<double>& Value::AsDoubleArray() const
+{
+  if (myIsWritable) {
+    return Convert().AsDoubleArray();
+  }
+  if (IsDoubleArray()) {
+    return as.myDoubleArray->Elements;
+  }
+  throw InvalidParametersFault();
+}
+
 void Value::Write(Writer& writer) const
 {
-  switch (myType) {
-    case Type::ARRAY:
-      writer.StartArray();
-      for (auto& element : *as.myArray) {
-        element.Write(writer);
-      }
-      writer.EndArray();
-      break;
-    case Type::BINARY:
-      writer.WriteBinary(as.myString->data(), as.myString->size());
-      break;
-    case Type::BOOLEAN:
-      writer.Write(as.myBoolean);
-      break;
-    case Type::DATE_TIME:
-      writer.Write(*as.myDateTime);
-      break;
-    case Type::DOUBLE:
-      writer.Write(as.myDouble);
-      break;
-    case Type::INTEGER_32:
-      writer.Write(as.myInteger32);
-      break;
-    case Type::INTEGER_64:
-      writer.Write(as.myInteger64);
-      break;
-    case Type::NIL:
-      writer.WriteNull();
-      break;
-    case Type::STRING:
-      writer.Write(*as.myString);
-      break;
-    case Type::STRUCT:
-      writer.StartStruct();
-      for (auto& element : *as.myStruct) {
-        writer.StartStructElement(element.first);
-        element.second.Write(writer);
-        writer.EndStructElement();
-      }
-      writer.EndStruct();
-      break;
+  writer.WriteValue(*this);
+}
+
+void Writer::WriteValue(const Value& value)
+{
+  SerializeValue(value, *this);
+}
+
+const Value& Value::Convert() const
+{
+  auto& writable = as.myWritable;
+  if (!writable.Converted) {
+    writable.Converted = new Value(writable.Object->CreateValue());
   }
+  return *writable.Converted;
 }
 
 void Value::Reset()
 {
+  if (myIsWritable) {
+    delete as.myWritable.Object;
+    delete as.myWritable.Converted;
+    myType = Type::NIL;
+  }
+
   switch (myType) {
     case Type::ARRAY:
-      delete as.myArray;
-      break;
-    case Type::DATE_TIME:
-      delete as.myDateTime;
+      switch (myPacking) {
+        case Packing::NONE:
+          delete as.myArray;
+          break;
+        case Packing::INTEGER_32:
+          delete as.myInteger32Array;
+          break;
+        case Packing::INTEGER_64:
+          delete as.myInteger64Array;
+          break;
+        case Packing::DOUBLE:
+          delete as.myDoubleArray;
+          break;
+      }
       break;
     case Type::BINARY:
     case Type::STRING:
-      delete as.myString;
+      if (myIsStringRef) {
+        delete as.myStringRef.Copy;
+      }
+      else {
+        delete as.myString;
+      }
       break;
     case Type::STRUCT:
       delete as.myStruct;
       break;
 
     case Type::BOOLEAN:
+    case Type::DATE_TIME:
     case Type::DOUBLE:
     case Type::INTEGER_32:
     case Type::INTEGER_64:
@@ -266,6 +701,9 @@ void Value::Reset()
   }
 
   myType = Type::NIL;
+  myIsStringRef = false;
+  myIsWritable = false;
+  myPacking = Packing::NONE;
 }
 
 std::ostream& operator<<(std::ostream& os, const Value& value)
@@ -283,15 +721,20 @@ std::ostream& operator<<(std::ostream& os, const Value& value)
       os << ']';
       break;
     }
-    case Value::Type::BINARY:
-      os << util::Base64Encode(value.AsBinary());
+    case Value::Type::BINARY: {
+      auto binary = value.AsStringRef();
+      os << util::Base64Encode(binary.Data, binary.Size);
       break;
+    }
     case Value::Type::BOOLEAN:
       os << value.AsBoolean();
       break;
-    case Value::Type::DATE_TIME:
-      os << util::FormatIso8601DateTime(value.AsDateTime());
+    case Value::Type::DATE_TIME: {
+      char str[util::ISO_8601_DATE_TIME_MAX_LENGTH];
+      auto end = util::FormatIso8601DateTime(value.AsDateTime(), str);
+      os.write(str, end - str);
       break;
+    }
     case Value::Type::DOUBLE:
       os << value.AsDouble();
       break;
@@ -304,9 +747,13 @@ std::ostream& operator<<(std::ostream& os, const Value& value)
     case Value::Type::NIL:
       os << "<nil>";
       break;
-    case Value::Type::STRING:
-      os << '"' << value.AsString() << '"';
+    case Value::Type::STRING: {
+      auto string = value.AsStringRef();
+      os << '"';
+      os.write(string.Data, string.Size);
+      os << '"';
       break;
+    }
     case Value::Type::STRUCT: {
       os << '{';
       auto& s = value.AsStruct();
@@ -0,0 +1,214 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "valuehandler.h"
+
+#include "fault.h"
+#include "util.h"
+
+namespace {
+
+template<typename T>
+void Box(std::vector<T>& elements, xsonrpc::Value::Array& array)
+{
+  array.reserve(elements.size() + 1);
+  for (auto element : elements) {
+    array.emplace_back(element);
+  }
+  std::vector<T>().swap(elements);
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+void ValueHandler::Base64(char* text, size_t size)
+{
+  Binary(text, util::Base64Decode(text, size, text));
+}
+
+Value& ValueBuilder::GetValue()
+{
+  if (!myIsDone) {
+    throw InvalidParametersFault();
+  }
+  return myValue;
+}
+
+void ValueBuilder::Reset()
+{
+  myContainers.clear();
+  myValue = Value();
+  myIsDone = false;
+}
+
+void ValueBuilder::StartArray()
+{
+  myContainers.emplace_back(false);
+}
+
+void ValueBuilder::EndArray()
+{
+  Value array;
+  auto& container = myContainers.back();
+  switch (container.ElementType) {
+    case Value::Type::INTEGER_32:
+      array = Value(std::move(container.Integer32Array));
+      break;
+    case Value::Type::INTEGER_64:
+      array = Value(std::move(container.Integer64Array));
+      break;
+    case Value::Type::DOUBLE:
+      array = Value(std::move(container.DoubleArray));
+      break;
+    default:
+      array = Value(std::move(container.Array));
+      break;
+  }
+  myContainers.pop_back();
+  Add(std::move(array));
+}
+
+void ValueBuilder::StartStruct()
+{
+  myContainers.emplace_back(true);
+}
+
+void ValueBuilder::EndStruct()
+{
+  Value data(std::move(myContainers.back().Struct));
+  myContainers.pop_back();
+  Add(std::move(data));
+}
+
+void ValueBuilder::StartStructElement(const char* name, size_t size)
+{
+  myContainers.back().Name.assign(name, size);
+}
+
+void ValueBuilder::Binary(const char* data, size_t size)
+{
+  Add(CreateString(data, size, true));
+}
+
+void ValueBuilder::Base64(char* text, size_t size)
+{
+  if (myStringsByReference) {
+    // Decoded in place so that the value can reference it
+    ValueHandler::Base64(text, size);
+    return;
+  }
+
+  // Decoded straight into the value's string instead of via the text
+  std::string data(util::Base64DecodedMaxSize(size), '\0');
+  data.resize(util::Base64Decode(text, size, &data[0]));
+  Add(Value(std::move(data), true));
+}
+
+void ValueBuilder::Boolean(bool value)
+{
+  Add(value);
+}
+
+void ValueBuilder::DateTime(const Value::DateTime& value)
+{
+  Add(value);
+}
+
+void ValueBuilder::Double(double value)
+{
+  AddNumber(value, Value::Type::DOUBLE, &Container::DoubleArray);
+}
+
+void ValueBuilder::Integer32(int32_t value)
+{
+  AddNumber(value, Value::Type::INTEGER_32, &Container::Integer32Array);
+}
+
+void ValueBuilder::Integer64(int64_t value)
+{
+  AddNumber(value, Value::Type::INTEGER_64, &Container::Integer64Array);
+}
+
+void ValueBuilder::Nil()
+{
+  Add(Value());
+}
+
+void ValueBuilder::String(const char* data, size_t size)
+{
+  Add(CreateString(data, size, false));
+}
+
+template<typename T>
+void ValueBuilder::AddNumber(T value, Value::Type type,
+                             std::vector<T> Container::*elements)
+{
+  if (!myContainers.empty() && !myContainers.back().IsStruct) {
+    auto& container = myContainers.back();
+    if (container.ElementType == Value::Type::NIL) {
+      container.ElementType = type;
+    }
+    if (container.ElementType == type) {
+      (container.*elements).push_back(value);
+      return;
+    }
+  }
+  Add(value);
+}
+
+void ValueBuilder::Add(Value value)
+{
+  if (myContainers.empty()) {
+    myValue = std::move(value);
+    myIsDone = true;
+  }
+  else if (myContainers.back().IsStruct) {
+    auto& container = myContainers.back();
+    container.Struct.emplace(std::move(container.Name), std::move(value));
+  }
+  else {
+    // Any packed numbers are boxed as the array turns out to be mixed
+    auto& container = myContainers.back();
+    switch (container.ElementType) {
+      case Value::Type::INTEGER_32:
+        Box(container.Integer32Array, container.Array);
+        break;
+      case Value::Type::INTEGER_64:
+        Box(container.Integer64Array, container.Array);
+        break;
+      case Value::Type::DOUBLE:
+        Box(container.DoubleArray, container.Array);
+        break;
+      default:
+        break;
+    }
+    container.ElementType = Value::Type::ARRAY;
+    container.Array.push_back(std::move(value));
+  }
+}
+
+Value ValueBuilder::CreateString(
+  const char* data, size_t size, bool binary) const
+{
+  if (myStringsByReference) {
+    return Value(Value::StringRef{data, size}, binary);
+  }
+  return Value(std::string(data, size), binary);
+}
+
+} // namespace xsonrpc
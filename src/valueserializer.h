@@ -0,0 +1,108 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_VALUESERIALIZER_H
+#define XSONRPC_VALUESERIALIZER_H
+
+#include "value.h"
+#include "writer.h"
+
+namespace xsonrpc {
+
+// Writes a value with the calls to the writer resolved at compile time. For
+// a final writer, instantiated where its members are defined, the whole
+// traversal can then be inlined (see Writer::WriteValue). Writables still
+// write themselves through the Writer interface.
+template<typename WriterType>
+void SerializeValue(const Value& value, WriterType& writer)
+{
+  if (value.myIsWritable) {
+    if (auto converted = value.as.myWritable.Converted) {
+      SerializeValue(*converted, writer);
+    }
+    else {
+      value.as.myWritable.Object->Write(writer);
+    }
+    return;
+  }
+
+  switch (value.myType) {
+    case Value::Type::ARRAY:
+      if (value.IsInteger32Array()) {
+        auto& elements = value.AsInteger32Array();
+        writer.WriteArray(elements.data(), elements.size());
+      }
+      else if (value.IsInteger64Array()) {
+        auto& elements = value.AsInteger64Array();
+        writer.WriteArray(elements.data(), elements.size());
+      }
+      else if (value.IsDoubleArray()) {
+        auto& elements = value.AsDoubleArray();
+        writer.WriteArray(elements.data(), elements.size());
+      }
+      else {
+        writer.StartArray();
+        for (auto& element : *value.as.myArray) {
+          SerializeValue(element, writer);
+        }
+        writer.EndArray();
+      }
+      break;
+    case Value::Type::BINARY: {
+      auto binary = value.AsStringRef();
+      writer.WriteBinary(binary.Data, binary.Size);
+      break;
+    }
+    case Value::Type::BOOLEAN:
+      writer.Write(value.as.myBoolean);
+      break;
+    case Value::Type::DATE_TIME:
+      writer.Write(value.as.myDateTime);
+      break;
+    case Value::Type::DOUBLE:
+      writer.Write(value.as.myDouble);
+      break;
+    case Value::Type::INTEGER_32:
+      writer.Write(value.as.myInteger32);
+      break;
+    case Value::Type::INTEGER_64:
+      writer.Write(value.as.myInteger64);
+      break;
+    case Value::Type::NIL:
+      writer.WriteNull();
+      break;
+    case Value::Type::STRING: {
+      auto string = value.AsStringRef();
+      writer.Write(string.Data, string.Size);
+      break;
+    }
+    case Value::Type::STRUCT:
+      writer.StartStruct();
+      for (auto& element : *value.as.myStruct) {
+        writer.StartStructElement(element.first);
+        SerializeValue(element.second, writer);
+        writer.EndStructElement();
+      }
+      writer.EndStruct();
+      break;
+  }
+}
+
+} // namespace xsonrpc
+
+#endif
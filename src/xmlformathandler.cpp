@@ -17,6 +17,7 @@
 
 #include "xmlformathandler.h"
 
+#include "requestparser.h"
 #include "xmlreader.h"
 #include "xmlwriter.h"
 
@@ -51,7 +52,14 @@ bool XmlFormatHandler::UsesId()
 
 std::unique_ptr<Reader> XmlFormatHandler::CreateReader(std::string data)
 {
-  return std::unique_ptr<Reader>(new XmlReader(data.data(), data.size()));
+  return std::unique_ptr<Reader>(new XmlReader(std::move(data)));
+}
+
+std::unique_ptr<RequestParser> XmlFormatHandler::CreateRequestParser(
+  const Dispatcher& /*dispatcher*/)
+{
+  // XmlReader pulls the data, so it needs all of it
+  return nullptr;
 }
 
 std::unique_ptr<Writer> XmlFormatHandler::CreateWriter()
@@ -0,0 +1,432 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "xmlparser.h"
+
+#include "fault.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <string>
+
+namespace {
+
+const char UTF8_BOM[] = "\xEF\xBB\xBF";
+const char CDATA_START[] = "<![CDATA[";
+const char CDATA_END[] = "]]>";
+const char COMMENT_START[] = "<!--";
+const char COMMENT_END[] = "-->";
+const char DOCTYPE_START[] = "!DOCTYPE";
+const char PI_START[] = "<?";
+const char PI_END[] = "?>";
+
+// Longest reference, e.g. &#x10FFFF;
+const size_t MAX_REFERENCE_LENGTH = 10;
+
+const uint64_t ONES = 0x0101010101010101ull;
+const uint64_t HIGHS = 0x8080808080808080ull;
+
+inline uint64_t HasByte(uint64_t word, uint8_t byte)
+{
+  const uint64_t x = word ^ (ONES * byte);
+  return (x - ONES) & ~x & HIGHS;
+}
+
+// Finds the first '<', '&' or '\r', checking eight bytes at a time
+char* FindSpecial(char* pos, const char* end)
+{
+  while (end - pos >= 8) {
+    uint64_t word;
+    memcpy(&word, pos, sizeof(word));
+    if (HasByte(word, '<') | HasByte(word, '&') | HasByte(word, '\r')) {
+      break;
+    }
+    pos += 8;
+  }
+  while (pos != end && *pos != '<' && *pos != '&' && *pos != '\r') {
+    ++pos;
+  }
+  return pos;
+}
+
+inline bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool IsNameEnd(char c)
+{
+  return IsSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+[[noreturn]] void Fail(const char* error)
+{
+  throw xsonrpc::ParseErrorFault(std::string("Parse error: ") + error);
+}
+
+// The encoding is never longer than the reference it came from
+char* EncodeUtf8(uint32_t c, char* out)
+{
+  if (c < 0x80) {
+    *out++ = static_cast<char>(c);
+  }
+  else if (c < 0x800) {
+    *out++ = static_cast<char>(0xC0 | (c >> 6));
+    *out++ = static_cast<char>(0x80 | (c & 0x3F));
+  }
+  else if (c < 0x10000) {
+    *out++ = static_cast<char>(0xE0 | (c >> 12));
+    *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (c & 0x3F));
+  }
+  else {
+    *out++ = static_cast<char>(0xF0 | (c >> 18));
+    *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (c & 0x3F));
+  }
+  return out;
+}
+
+bool ParseCharacterReference(const char* str, size_t size, uint32_t& c)
+{
+  const bool hex = size > 0 && str[0] == 'x';
+  if (hex) {
+    ++str;
+    --size;
+  }
+  if (size == 0) {
+    return false;
+  }
+
+  c = 0;
+  for (size_t i = 0; i < size; ++i) {
+    int digit;
+    if (str[i] >= '0' && str[i] <= '9') {
+      digit = str[i] - '0';
+    }
+    else if (hex && str[i] >= 'a' && str[i] <= 'f') {
+      digit = str[i] - 'a' + 10;
+    }
+    else if (hex && str[i] >= 'A' && str[i] <= 'F') {
+      digit = str[i] - 'A' + 10;
+    }
+    else {
+      return false;
+    }
+    c = c * (hex ? 16 : 10) + digit;
+    if (c > 0x10FFFF) {
+      return false;
+    }
+  }
+  return c != 0 && (c < 0xD800 || c > 0xDFFF);
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+XmlParser::XmlParser(char* data, size_t size)
+  : myPos(data),
+    myEnd(data + size)
+{
+  if (StartsWith(UTF8_BOM, sizeof(UTF8_BOM) - 1)) {
+    myPos += sizeof(UTF8_BOM) - 1;
+  }
+}
+
+XmlParser::Token XmlParser::Next()
+{
+  if (myIsEmptyElement) {
+    myIsEmptyElement = false;
+    myName = myElements.back().first;
+    myNameSize = myElements.back().second;
+    myElements.pop_back();
+    return Token::END_TAG;
+  }
+
+  for (;;) {
+    if (!myIsAtTag) {
+      if (myPos == myEnd) {
+        if (!myHasRoot || !myElements.empty()) {
+          Fail("unexpected end of document");
+        }
+        return Token::END;
+      }
+
+      if (*myPos != '<' || StartsWith(CDATA_START, sizeof(CDATA_START) - 1)) {
+        ReadText();
+        if (!myElements.empty()) {
+          return Token::TEXT;
+        }
+        if (!std::all_of(myText, myText + myTextSize, IsSpace)) {
+          Fail("text outside of root element");
+        }
+        continue;
+      }
+    }
+
+    myIsAtTag = false;
+    if (++myPos == myEnd) {
+      Fail("unexpected end of document");
+    }
+    if (*myPos == '/') {
+      return ReadEndTag();
+    }
+    else if (*myPos == '?' || *myPos == '!') {
+      SkipMarkup();
+      continue;
+    }
+    return ReadStartTag();
+  }
+}
+
+XmlParser::Token XmlParser::ReadStartTag()
+{
+  if (myHasRoot && myElements.empty()) {
+    Fail("more than one root element");
+  }
+
+  myName = myPos;
+  myNameSize = ReadName();
+
+  // Attributes are not used by XML-RPC, so they are just skipped
+  for (;;) {
+    while (myPos != myEnd && IsSpace(*myPos)) {
+      ++myPos;
+    }
+    if (myPos == myEnd) {
+      Fail("unexpected end of document");
+    }
+    else if (*myPos == '>') {
+      ++myPos;
+      break;
+    }
+    else if (*myPos == '/') {
+      if (++myPos == myEnd || *myPos != '>') {
+        Fail("invalid empty element tag");
+      }
+      ++myPos;
+      myIsEmptyElement = true;
+      break;
+    }
+
+    ReadName();
+    while (myPos != myEnd && IsSpace(*myPos)) {
+      ++myPos;
+    }
+    if (myPos == myEnd || *myPos != '=') {
+      Fail("invalid attribute");
+    }
+    ++myPos;
+    while (myPos != myEnd && IsSpace(*myPos)) {
+      ++myPos;
+    }
+    if (myPos == myEnd || (*myPos != '"' && *myPos != '\'')) {
+      Fail("invalid attribute");
+    }
+    auto quote = static_cast<char*>(memchr(myPos + 1, *myPos,
+                                           myEnd - myPos - 1));
+    if (!quote) {
+      Fail("invalid attribute");
+    }
+    myPos = quote + 1;
+  }
+
+  myHasRoot = true;
+  myElements.emplace_back(myName, myNameSize);
+  return Token::START_TAG;
+}
+
+XmlParser::Token XmlParser::ReadEndTag()
+{
+  ++myPos;
+  myName = myPos;
+  myNameSize = ReadName();
+  while (myPos != myEnd && IsSpace(*myPos)) {
+    ++myPos;
+  }
+  if (myPos == myEnd || *myPos != '>') {
+    Fail("invalid end tag");
+  }
+  ++myPos;
+
+  if (myElements.empty()
+      || myElements.back().second != myNameSize
+      || memcmp(myElements.back().first, myName, myNameSize) != 0) {
+    Fail("mismatched end tag");
+  }
+  myElements.pop_back();
+  return Token::END_TAG;
+}
+
+void XmlParser::ReadText()
+{
+  myText = myPos;
+  char* out = myPos;
+
+  for (;;) {
+    char* special = FindSpecial(myPos, myEnd);
+    if (out != myPos) {
+      memmove(out, myPos, special - myPos);
+    }
+    out += special - myPos;
+    myPos = special;
+
+    if (myPos == myEnd) {
+      break;
+    }
+    else if (*myPos == '&') {
+      ReadReference(out);
+    }
+    else if (*myPos == '\r') {
+      // Line breaks are normalized to '\n'
+      *out++ = '\n';
+      if (++myPos != myEnd && *myPos == '\n') {
+        ++myPos;
+      }
+    }
+    else if (StartsWith(CDATA_START, sizeof(CDATA_START) - 1)) {
+      myPos += sizeof(CDATA_START) - 1;
+      char* start = myPos;
+      Skip(CDATA_END, sizeof(CDATA_END) - 1);
+      const size_t size = myPos - start - (sizeof(CDATA_END) - 1);
+      memmove(out, start, size);
+      out += size;
+    }
+    else if (StartsWith(COMMENT_START, sizeof(COMMENT_START) - 1)) {
+      myPos += sizeof(COMMENT_START) - 1;
+      Skip(COMMENT_END, sizeof(COMMENT_END) - 1);
+    }
+    else if (StartsWith(PI_START, sizeof(PI_START) - 1)) {
+      myPos += sizeof(PI_START) - 1;
+      Skip(PI_END, sizeof(PI_END) - 1);
+    }
+    else {
+      break;
+    }
+  }
+
+  myTextSize = out - myText;
+  if (myPos != myEnd) {
+    // If there was nothing to decode, this overwrites the '<' of the tag
+    myIsAtTag = out == myPos;
+    *out = '\0';
+  }
+  else if (!myElements.empty()) {
+    Fail("unexpected end of document");
+  }
+}
+
+void XmlParser::ReadReference(char*& out)
+{
+  const size_t maxSize = std::min<size_t>(myEnd - myPos, MAX_REFERENCE_LENGTH);
+  auto semicolon = static_cast<char*>(memchr(myPos, ';', maxSize));
+  if (!semicolon) {
+    Fail("invalid reference");
+  }
+
+  const char* name = myPos + 1;
+  const size_t size = semicolon - name;
+  uint32_t c;
+  if (size > 0 && name[0] == '#') {
+    if (!ParseCharacterReference(name + 1, size - 1, c)) {
+      Fail("invalid character reference");
+    }
+  }
+  else if (size == 2 && memcmp(name, "lt", 2) == 0) {
+    c = '<';
+  }
+  else if (size == 2 && memcmp(name, "gt", 2) == 0) {
+    c = '>';
+  }
+  else if (size == 3 && memcmp(name, "amp", 3) == 0) {
+    c = '&';
+  }
+  else if (size == 4 && memcmp(name, "quot", 4) == 0) {
+    c = '"';
+  }
+  else if (size == 4 && memcmp(name, "apos", 4) == 0) {
+    c = '\'';
+  }
+  else {
+    Fail("unknown entity");
+  }
+
+  out = EncodeUtf8(c, out);
+  myPos = semicolon + 1;
+}
+
+void XmlParser::SkipMarkup()
+{
+  if (*myPos == '?') {
+    Skip(PI_END, sizeof(PI_END) - 1);
+  }
+  else if (StartsWith(COMMENT_START + 1, sizeof(COMMENT_START) - 2)) {
+    Skip(COMMENT_END, sizeof(COMMENT_END) - 1);
+  }
+  else if (myElements.empty()
+           && StartsWith(DOCTYPE_START, sizeof(DOCTYPE_START) - 1)) {
+    // Internal subsets could declare entities, which are not supported
+    auto end = static_cast<char*>(memchr(myPos, '>', myEnd - myPos));
+    if (!end || memchr(myPos, '[', end - myPos)) {
+      Fail("unsupported document type declaration");
+    }
+    myPos = end + 1;
+  }
+  else {
+    Fail("unsupported markup");
+  }
+}
+
+size_t XmlParser::ReadName()
+{
+  const char* start = myPos;
+  while (myPos != myEnd && !IsNameEnd(*myPos)) {
+    ++myPos;
+  }
+  if (myPos == start) {
+    Fail("missing name");
+  }
+  return myPos - start;
+}
+
+bool XmlParser::StartsWith(const char* prefix, size_t size) const
+{
+  return static_cast<size_t>(myEnd - myPos) >= size
+    && memcmp(myPos, prefix, size) == 0;
+}
+
+void XmlParser::Skip(const char* terminator, size_t size)
+{
+  for (;;) {
+    auto pos = static_cast<char*>(memchr(myPos, terminator[0],
+                                         myEnd - myPos));
+    if (!pos) {
+      Fail("unexpected end of document");
+    }
+    myPos = pos;
+    if (StartsWith(terminator, size)) {
+      myPos += size;
+      return;
+    }
+    ++myPos;
+  }
+}
+
+} // namespace xsonrpc
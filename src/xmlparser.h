@@ -0,0 +1,88 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef XSONRPC_XMLPARSER_H
+#define XSONRPC_XMLPARSER_H
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace xsonrpc {
+
+// Pull parser for the subset of XML used by XML-RPC: elements, text,
+// character and entity references and CDATA sections. The prolog,
+// comments, processing instructions and attributes are skipped. The data
+// is parsed in place, i.e. texts are decoded and null terminated in the
+// buffer, which must outlive the parser.
+class XmlParser
+{
+public:
+  enum class Token
+  {
+    START_TAG,
+    END_TAG,
+    TEXT,
+    END
+  };
+
+  XmlParser(char* data, size_t size);
+
+  // Throws ParseErrorFault if the data is not well-formed
+  Token Next();
+
+  // The name of the current start or end tag
+  template<size_t N>
+  bool IsName(const char (&name)[N]) const
+  {
+    return myNameSize == N - 1 && memcmp(myName, name, N - 1) == 0;
+  }
+
+  // The current text, null terminated
+  char* GetText() const { return myText; }
+  size_t GetTextSize() const { return myTextSize; }
+
+private:
+  Token ReadStartTag();
+  Token ReadEndTag();
+  void ReadText();
+  void ReadReference(char*& out);
+  void SkipMarkup();
+  size_t ReadName();
+  bool StartsWith(const char* prefix, size_t size) const;
+  void Skip(const char* terminator, size_t size);
+
+  char* myPos;
+  char* myEnd;
+  // The text before a tag was null terminated on its '<'
+  bool myIsAtTag = false;
+  // An empty element tag gives an end tag on the next call
+  bool myIsEmptyElement = false;
+  bool myHasRoot = false;
+
+  const char* myName = nullptr;
+  size_t myNameSize = 0;
+  char* myText = nullptr;
+  size_t myTextSize = 0;
+
+  std::vector<std::pair<const char*, size_t>> myElements;
+};
+
+} // namespace xsonrpc
+
+#endif
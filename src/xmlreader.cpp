@@ -1,5 +1,5 @@
 // This file is part of xsonrpc, an XML/JSON RPC library.
-// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
 //
 // This library is free software; you can redistribute it and/or modify it
 // under the terms of the GNU Lesser General Public License as published by the
@@ -15,6 +15,7 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+
 #include "xmlreader.h"
 
 #include "fault.h"
@@ -22,70 +23,75 @@
 #include "response.h"
 #include "util.h"
 #include "value.h"
+#include "valuehandler.h"
 #include "xml.h"
 
-namespace xsonrpc {
+#include <algorithm>
 
-using namespace xml;
+namespace {
 
-XmlReader::XmlReader(const char* data, size_t size)
+bool IsWhitespace(const char* text, size_t size)
 {
-  auto error = myDocument.Parse(data, size);
-  if (error != tinyxml2::XML_NO_ERROR) {
-    throw ParseErrorFault("Parse error: " + std::to_string(error));
-  }
+  return std::all_of(text, text + size, [] (char c) {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    });
 }
 
-Request XmlReader::GetRequest()
-{
-  auto root = myDocument.RootElement();
+} // namespace
 
-  if (!root || !util::IsTag(*root, METHOD_CALL_TAG)) {
-    throw InvalidRequestFault("Missing method call element");
-  }
+namespace xsonrpc {
 
-  auto name = root->FirstChildElement(METHOD_NAME_TAG);
-  if (!name || util::HasEmptyText(*name)) {
-    throw InvalidRequestFault("Missing method name");
-  }
+using namespace xml;
 
-  auto params = root->FirstChildElement(PARAMS_TAG);
-  if (!params) {
-    return Request(name->GetText(), {}, false);
-  }
+XmlReader::XmlReader(std::string data)
+  : myData(std::move(data)),
+    myParser(&myData[0], myData.size())
+{
+}
+
+void XmlReader::SetStringsByReference(bool byReference)
+{
+  myStringsByReference = byReference;
+}
 
+Request XmlReader::GetRequest()
+{
+  auto name = ReadMethodName();
   Request::Parameters parameters;
-  for (auto param = params->FirstChildElement(PARAM_TAG);
-       param; param = param->NextSiblingElement(PARAM_TAG)) {
-    parameters.emplace_back(GetValue(param->FirstChildElement()));
-  }
-  return Request(name->GetText(), std::move(parameters), false);
+  ReadParameters([&] { parameters.emplace_back(ReadValue()); });
+  return Request(std::move(name), std::move(parameters), false);
 }
 
 Response XmlReader::GetResponse()
 {
-  auto root = myDocument.RootElement();
-
-  if (!root || !util::IsTag(*root, METHOD_RESPONSE_TAG)) {
+  if (NextElement() != XmlParser::Token::START_TAG
+      || !myParser.IsName(METHOD_RESPONSE_TAG)) {
     throw InvalidRequestFault("Missing method response element");
   }
 
   bool isFault;
-  auto value = root->FirstChildElement(PARAMS_TAG);
-  if (value) {
+  auto token = NextElement();
+  if (token == XmlParser::Token::START_TAG && myParser.IsName(PARAMS_TAG)) {
     isFault = false;
-    value = value->FirstChildElement(PARAM_TAG);
+    ExpectStartTag(PARAM_TAG, "Missing response param or fault element");
   }
-  else {
+  else if (token == XmlParser::Token::START_TAG
+           && myParser.IsName(FAULT_TAG)) {
     isFault = true;
-    value = root->FirstChildElement(FAULT_TAG);
   }
-
-  if (!value) {
+  else {
     throw InvalidRequestFault("Missing response param or fault element");
   }
 
-  auto result = GetValue(value->FirstChildElement());
+  ExpectStartTag(VALUE_TAG, "Missing value element");
+  auto result = ReadValue();
+  ExpectEndTag();
+  if (!isFault) {
+    ExpectEndTag();
+  }
+  ExpectEndTag();
+  ReadEnd();
+
   if (!isFault) {
     return Response(std::move(result), false);
   }
@@ -108,98 +114,239 @@ Response XmlReader::GetResponse()
 
 Value XmlReader::GetValue()
 {
-  return GetValue(myDocument.RootElement());
+  ExpectStartTag(VALUE_TAG, "Missing value element");
+  auto value = ReadValue();
+  ReadEnd();
+  return value;
 }
 
-Value XmlReader::GetValue(tinyxml2::XMLElement* element)
+Response XmlReader::InvokeRequest(const Dispatcher& dispatcher)
 {
-  if (!element || !util::IsTag(*element, VALUE_TAG)) {
-    throw InvalidRequestFault("Missing value element");
+  auto name = ReadMethodName();
+
+  auto decoder = CreateParameterDecoder(dispatcher, name, myAttachments);
+  if (!decoder) {
+    Request::Parameters parameters;
+    ReadParameters([&] { parameters.emplace_back(ReadValue()); });
+    return dispatcher.Invoke(name, parameters, false);
   }
 
-  auto value = element->FirstChildElement();
-  if (!value) {
-    throw InvalidRequestFault("Empty value element");
+  ReadParameters(
+    [&] ()
+    {
+      decoder->StartParameter();
+      ReadValue(*decoder);
+      decoder->EndParameter();
+    });
+  return dispatcher.Invoke(*decoder, false);
+}
+
+std::string XmlReader::ReadMethodName()
+{
+  ExpectStartTag(METHOD_CALL_TAG, "Missing method call element");
+  ExpectStartTag(METHOD_NAME_TAG, "Missing method name");
+
+  char* text;
+  size_t size;
+  if (NextText(text, size) != XmlParser::Token::END_TAG || size == 0) {
+    throw InvalidRequestFault("Missing method name");
   }
+  return std::string(text, size);
+}
 
-  if (util::IsTag(*value, ARRAY_TAG)) {
-    auto data = value->FirstChildElement(DATA_TAG);
-    if (!data) {
-      throw InvalidRequestFault("Missing data element in array");
+template<typename Function>
+void XmlReader::ReadParameters(Function readParameter)
+{
+  auto token = NextElement();
+  if (token == XmlParser::Token::START_TAG) {
+    if (!myParser.IsName(PARAMS_TAG)) {
+      throw InvalidRequestFault("Invalid element in method call");
     }
-    Value::Array array;
-    for (auto child = data->FirstChildElement();
-         child; child = child->NextSiblingElement()) {
-      array.emplace_back(GetValue(child));
+    while (NextElement() == XmlParser::Token::START_TAG) {
+      if (!myParser.IsName(PARAM_TAG)) {
+        throw InvalidRequestFault("Invalid element in params");
+      }
+      ExpectStartTag(VALUE_TAG, "Missing value element");
+      readParameter();
+      ExpectEndTag();
     }
-    return Value(std::move(array));
+    token = NextElement();
+  }
+  // The parser makes sure that the end tag is that of the method call
+  if (token != XmlParser::Token::END_TAG) {
+    throw InvalidRequestFault("Invalid element in method call");
+  }
+  ReadEnd();
+}
+
+void XmlReader::ReadValue(ValueHandler& handler)
+{
+  char* text;
+  size_t size;
+  auto token = NextText(text, size);
+  if (token == XmlParser::Token::END_TAG) {
+    // No type means string
+    handler.String(text, size);
+    return;
+  }
+  else if (!IsWhitespace(text, size)) {
+    throw InvalidRequestFault("Invalid value");
   }
-  else if (util::IsTag(*value, BASE_64_TAG)) {
-    auto text = value->GetText();
-    if (!text) {
-      throw InvalidRequestFault("Value is not base64");
+
+  if (myParser.IsName(ARRAY_TAG)) {
+    ExpectStartTag(DATA_TAG, "Missing data element in array");
+    handler.StartArray();
+    while (NextElement() == XmlParser::Token::START_TAG) {
+      if (!myParser.IsName(VALUE_TAG)) {
+        throw InvalidRequestFault("Missing value element");
+      }
+      ReadValue(handler);
     }
-    return Value(util::Base64Decode(text, strlen(text)), true);
+    handler.EndArray();
+    ExpectEndTag();
   }
-  else if (util::IsTag(*value, BOOLEAN_TAG)) {
+  else if (myParser.IsName(BASE_64_TAG)) {
+    ReadScalar(text, size, "Value is not base64");
+    handler.Base64(text, size);
+  }
+  else if (myParser.IsName(BOOLEAN_TAG)) {
+    ReadScalar(text, size, "Value is not a boolean");
     bool data;
-    if (value->QueryBoolText(&data) != tinyxml2::XML_SUCCESS) {
+    if (!util::ParseBoolean(text, size, data)) {
       throw InvalidRequestFault("Value is not a boolean");
     }
-    return Value(data);
+    handler.Boolean(data);
   }
-  else if (util::IsTag(*value, DATE_TIME_TAG)) {
+  else if (myParser.IsName(DATE_TIME_TAG)) {
+    ReadScalar(text, size, "Value is not a date/time");
     Value::DateTime dateTime;
-    if (!util::ParseIso8601DateTime(value->GetText(), dateTime)) {
+    if (!util::ParseIso8601DateTime(text, size, dateTime)) {
       throw InvalidRequestFault("Value is not a date/time");
     }
-    return Value(dateTime);
+    handler.DateTime(dateTime);
   }
-  else if (util::IsTag(*value, DOUBLE_TAG)) {
+  else if (myParser.IsName(DOUBLE_TAG)) {
+    ReadScalar(text, size, "Value is not a double");
     double data;
-    if (value->QueryDoubleText(&data) != tinyxml2::XML_SUCCESS) {
+    if (!util::ParseDouble(text, size, data)) {
       throw InvalidRequestFault("Value is not a double");
     }
-    return Value(data);
+    handler.Double(data);
   }
-  else if (util::IsTag(*value, INTEGER_32_TAG)
-           || util::IsTag(*value, INTEGER_INT_TAG)) {
+  else if (myParser.IsName(INTEGER_32_TAG)
+           || myParser.IsName(INTEGER_INT_TAG)) {
+    ReadScalar(text, size, "Value is not a 32-bit integer");
     int32_t data;
-    if (value->QueryIntText(&data) != tinyxml2::XML_SUCCESS) {
+    if (!util::ParseInteger(text, size, data)) {
       throw InvalidRequestFault("Value is not a 32-bit integer");
     }
-    return Value(data);
+    handler.Integer32(data);
   }
-  else if (util::IsTag(*value, INTEGER_64_TAG)) {
-    if (!value->GetText()) {
+  else if (myParser.IsName(INTEGER_64_TAG)) {
+    ReadScalar(text, size, "Value is not a 64-bit integer");
+    int64_t data;
+    if (!util::ParseInteger(text, size, data)) {
       throw InvalidRequestFault("Value is not a 64-bit integer");
     }
-    int64_t data = std::stoll(value->GetText());
-    return Value(data);
-  }
-  else if (util::IsTag(*value, NIL_TAG)) {
-    return Value();
-  }
-  else if (util::IsTag(*value, STRING_TAG)) {
-    auto text = value->GetText();
-    return Value(std::string(text ? text : ""));
-  }
-  else if (util::IsTag(*value, STRUCT_TAG)) {
-    Value::Struct data;
-    for (auto member = value->FirstChildElement(MEMBER_TAG);
-         member; member = member->NextSiblingElement(MEMBER_TAG)) {
-      auto name = member->FirstChildElement(NAME_TAG);
-      if (!name || util::HasEmptyText(*name)) {
+    handler.Integer64(data);
+  }
+  else if (myParser.IsName(NIL_TAG)) {
+    ExpectEndTag();
+    handler.Nil();
+  }
+  else if (myParser.IsName(STRING_TAG)) {
+    ReadScalar(text, size, "Value is not a string");
+    // Entities have been decoded in place in the buffer
+    handler.String(text, size);
+  }
+  else if (myParser.IsName(STRUCT_TAG)) {
+    handler.StartStruct();
+    while (NextElement() == XmlParser::Token::START_TAG) {
+      if (!myParser.IsName(MEMBER_TAG)) {
+        throw InvalidRequestFault("Invalid element in struct");
+      }
+      ExpectStartTag(NAME_TAG, "Missing name element in struct");
+      if (NextText(text, size) != XmlParser::Token::END_TAG || size == 0) {
         throw InvalidRequestFault("Missing name element in struct");
       }
-      data.emplace(name->GetText(),
-                   GetValue(member->LastChildElement(VALUE_TAG)));
+      handler.StartStructElement(text, size);
+      ExpectStartTag(VALUE_TAG, "Missing value element");
+      ReadValue(handler);
+      ExpectEndTag();
     }
-    return Value(std::move(data));
+    handler.EndStruct();
   }
   else {
     throw InvalidRequestFault("Invalid type");
   }
+
+  ExpectEndTag();
+}
+
+Value XmlReader::ReadValue()
+{
+  ValueBuilder builder(myStringsByReference);
+  ReadValue(builder);
+  return std::move(builder.GetValue());
+}
+
+void XmlReader::ReadScalar(char*& text, size_t& size, const char* error)
+{
+  if (NextText(text, size) != XmlParser::Token::END_TAG) {
+    throw InvalidRequestFault(error);
+  }
+}
+
+void XmlReader::ReadEnd()
+{
+  // Only whitespace, comments and processing instructions may follow
+  if (NextElement() != XmlParser::Token::END) {
+    throw InvalidRequestFault("Unexpected data after document");
+  }
+}
+
+XmlParser::Token XmlReader::NextElement()
+{
+  auto token = myParser.Next();
+  if (token == XmlParser::Token::TEXT) {
+    if (!IsWhitespace(myParser.GetText(), myParser.GetTextSize())) {
+      throw InvalidRequestFault("Unexpected text");
+    }
+    token = myParser.Next();
+  }
+  return token;
+}
+
+template<size_t N>
+void XmlReader::ExpectStartTag(const char (&name)[N], const char* error)
+{
+  if (NextElement() != XmlParser::Token::START_TAG
+      || !myParser.IsName(name)) {
+    throw InvalidRequestFault(error);
+  }
+}
+
+void XmlReader::ExpectEndTag()
+{
+  // The parser makes sure that the end tag matches the start tag
+  if (NextElement() != XmlParser::Token::END_TAG) {
+    throw InvalidRequestFault("Unexpected element");
+  }
+}
+
+XmlParser::Token XmlReader::NextText(char*& text, size_t& size)
+{
+  auto token = myParser.Next();
+  if (token == XmlParser::Token::TEXT) {
+    text = myParser.GetText();
+    size = myParser.GetTextSize();
+    return myParser.Next();
+  }
+  // Empty text is still writable, as handlers may decode it in place
+  myEmptyText[0] = '\0';
+  text = myEmptyText;
+  size = 0;
+  return token;
 }
 
 } // namespace xsonrpc
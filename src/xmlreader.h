@@ -1,5 +1,5 @@
 // This file is part of xsonrpc, an XML/JSON RPC library.
-// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
 //
 // This library is free software; you can redistribute it and/or modify it
 // under the terms of the GNU Lesser General Public License as published by the
@@ -15,29 +15,55 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+
 #ifndef XSONRPC_XMLREADER_H
 #define XSONRPC_XMLREADER_H
 
 #include "reader.h"
+#include "xmlparser.h"
 
-#include <tinyxml2.h>
+#include <string>
 
 namespace xsonrpc {
 
+class ValueHandler;
+
+// Reads in a single pass, so only one of GetRequest, GetResponse, GetValue
+// and InvokeRequest can be called
 class XmlReader final : public Reader
 {
 public:
-  XmlReader(const char* data, size_t size);
+  explicit XmlReader(std::string data);
 
   // Reader
+  void SetStringsByReference(bool byReference) override;
   Request GetRequest() override;
   Response GetResponse() override;
   Value GetValue() override;
+  Response InvokeRequest(const Dispatcher& dispatcher) override;
 
 private:
-  Value GetValue(tinyxml2::XMLElement* element);
+  std::string ReadMethodName();
+  template<typename Function>
+  void ReadParameters(Function readParameter);
+  void ReadValue(ValueHandler& handler);
+  Value ReadValue();
+  void ReadScalar(char*& text, size_t& size, const char* error);
+  void ReadEnd();
+
+  // Skips whitespace, throws InvalidRequestFault on other text
+  XmlParser::Token NextElement();
+  template<size_t N>
+  void ExpectStartTag(const char (&name)[N], const char* error);
+  void ExpectEndTag();
+  // Reads the text, if any, and returns the token after it
+  XmlParser::Token NextText(char*& text, size_t& size);
 
-  tinyxml2::XMLDocument myDocument;
+  std::string myData;
+  XmlParser myParser;
+  bool myStringsByReference = false;
+  // Returned by NextText for missing text, per reader as it is writable
+  char myEmptyText[1];
 };
 
 } // namespace xsonrpc
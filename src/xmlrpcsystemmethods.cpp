@@ -19,8 +19,11 @@
 
 #include "dispatcher.h"
 #include "fault.h"
+#include "formathandler.h"
 #include "xml.h"
 
+#include <stdexcept>
+
 namespace {
 
 const char SYSTEM_MULTICALL[] = "system.multicall";
@@ -48,6 +51,10 @@ const char CAPABILITY_FAULTS_INTEROP_URL[] =
     "http://xmlrpc-epi.sourceforge.net/specs/rfc.fault_codes.php";
 const int32_t CAPABILITY_FAULTS_INTEROP_VERSION = 20010516;
 
+const char CAPABILITY_FORMAT_URL[] =
+    "https://www.iana.org/assignments/media-types/";
+const int32_t CAPABILITY_FORMAT_VERSION = 1;
+
 } // namespace
 
 namespace xsonrpc {
@@ -125,6 +132,13 @@ void XmlRpcSystemMethods::RemoveCapability(const std::string& name)
   myCapabilities.erase(name);
 }
 
+void XmlRpcSystemMethods::AddFormat(FormatHandler& formatHandler)
+{
+  auto contentType = formatHandler.GetContentType();
+  AddCapability(contentType, CAPABILITY_FORMAT_URL + contentType,
+                CAPABILITY_FORMAT_VERSION);
+}
+
 Value XmlRpcSystemMethods::SystemMulticall(
   const Request::Parameters& parameters) const
 {
@@ -265,6 +279,13 @@ Value XmlRpcSystemMethods::SystemGetCapabilities() const
     value.emplace(SPEC_VERSION, capability.second.Version);
     capabilities.emplace(capability.first, std::move(value));
   }
+  // The formats the server reads, unless added already
+  for (auto& contentType : myDispatcher.GetFormats()) {
+    Value::Struct value;
+    value.emplace(SPEC_URL, CAPABILITY_FORMAT_URL + contentType);
+    value.emplace(SPEC_VERSION, CAPABILITY_FORMAT_VERSION);
+    capabilities.emplace(contentType, std::move(value));
+  }
   return std::move(capabilities);
 }
 
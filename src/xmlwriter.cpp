@@ -15,29 +15,103 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+
 #include "xmlwriter.h"
 
+#include "textscan.h"
 #include "util.h"
 #include "value.h"
-#include "xml.h"
+#include "valueserializer.h"
+
+#include <rapidjson/internal/dtoa.h>
+#include <rapidjson/internal/itoa.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
 
 namespace xsonrpc {
 
-using namespace xml;
+// The tags written below are those in xml.h, combined into longer sequences
+// that are appended in one go
+
+template<size_t N>
+inline void XmlWriter::Append(const char (&str)[N])
+{
+  Append(str, str + N - 1);
+}
+
+inline void XmlWriter::Append(const char* begin, const char* end)
+{
+  if (myIsElementOpen) {
+    myBuffer += '>';
+    myIsElementOpen = false;
+  }
+  myBuffer.append(begin, end);
+}
+
+// Ends an element opened without its '>', using emptyEnd if nothing has
+// been written since
+template<size_t N, size_t M>
+inline void XmlWriter::AppendEnd(const char (&emptyEnd)[N],
+                                 const char (&end)[M])
+{
+  if (myIsElementOpen) {
+    myIsElementOpen = false;
+    Append(emptyEnd);
+  }
+  else {
+    Append(end);
+  }
+}
+
+void XmlWriter::AppendEscaped(const char* data, size_t size)
+{
+  const char* end = data + size;
+  while (true) {
+    const char* p = data + util::FindXmlEscape(data, end - data);
+    Append(data, p);
+    if (p == end) {
+      return;
+    }
+
+    switch (*p) {
+      case '&':
+        Append("&amp;");
+        break;
+      case '<':
+        Append("&lt;");
+        break;
+      case '>':
+        Append("&gt;");
+        break;
+      default:
+        // XML can't represent null, so the text ends here
+        return;
+    }
+    data = p + 1;
+  }
+}
 
 const char* XmlWriter::GetData()
 {
-  return myPrinter.CStr();
+  return myBuffer.data();
 }
 
 size_t XmlWriter::GetSize()
 {
-  return myPrinter.CStrSize() - 1;
+  return myBuffer.size();
+}
+
+void XmlWriter::ClearData()
+{
+  myBuffer.clear();
 }
 
 void XmlWriter::StartDocument()
 {
-  myPrinter.PushHeader(false, true);
+  Append("<?xml version=\"1.0\"?>");
 }
 
 void XmlWriter::EndDocument()
@@ -45,187 +119,234 @@ void XmlWriter::EndDocument()
   // Empty
 }
 
-void XmlWriter::StartRequest(const std::string& methodName,
-                             const Value& /*id*/)
+void XmlWriter::StartBatch()
 {
-  myPrinter.OpenElement(METHOD_CALL_TAG, true);
+  throw std::logic_error("xml-rpc: batches are not supported");
+}
 
-  myPrinter.OpenElement(METHOD_NAME_TAG, true);
-  myPrinter.PushText(methodName.c_str());
-  myPrinter.CloseElement(true);
+void XmlWriter::EndBatch()
+{
+  throw std::logic_error("xml-rpc: batches are not supported");
+}
 
-  myPrinter.OpenElement(PARAMS_TAG, true);
+void XmlWriter::StartRequest(const std::string& methodName,
+                             const Value& /*id*/)
+{
+  Append("<methodCall><methodName>");
+  AppendEscaped(methodName.data(), methodName.size());
+  Append("</methodName><params");
+  myIsElementOpen = true;
 }
 
 void XmlWriter::EndRequest()
 {
-  myPrinter.CloseElement(true);
-  myPrinter.CloseElement(true);
+  AppendEnd("/></methodCall>", "</params></methodCall>");
 }
 
 void XmlWriter::StartParameter()
 {
-  myPrinter.OpenElement(PARAM_TAG, true);
+  Append("<param>");
 }
 
 void XmlWriter::EndParameter()
 {
-  myPrinter.CloseElement(true);
+  Append("</param>");
 }
 
 void XmlWriter::StartResponse(const Value& /*id*/)
 {
-  myPrinter.OpenElement(METHOD_RESPONSE_TAG, true);
-  myPrinter.OpenElement(PARAMS_TAG, true);
-  myPrinter.OpenElement(PARAM_TAG, true);
+  Append("<methodResponse><params><param>");
 }
 
 void XmlWriter::EndResponse()
 {
-  myPrinter.CloseElement(true);
-  myPrinter.CloseElement(true);
-  myPrinter.CloseElement(true);
+  Append("</param></params></methodResponse>");
 }
 
 void XmlWriter::StartFaultResponse(const Value& /*id*/)
 {
-  myPrinter.OpenElement(METHOD_RESPONSE_TAG, true);
-  myPrinter.OpenElement(FAULT_TAG, true);
+  Append("<methodResponse><fault>");
 }
 
 void XmlWriter::EndFaultResponse()
 {
-  myPrinter.CloseElement(true);
-  myPrinter.CloseElement(true);
+  Append("</fault></methodResponse>");
 }
 
 void XmlWriter::WriteFault(int32_t code, const std::string& string)
 {
-  Value::Struct fault;
-  fault.insert({FAULT_CODE_NAME, code});
-  fault.insert({FAULT_STRING_NAME, string});
-  Value(std::move(fault)).Write(*this);
+  char str[16];
+  Append("<value><struct><member><name>faultCode</name><value><i4>");
+  Append(str, rapidjson::internal::i32toa(code, str));
+  Append("</i4></value></member><member><name>faultString</name>"
+         "<value><string>");
+  AppendEscaped(string.data(), string.size());
+  Append("</string></value></member></struct></value>");
 }
 
 void XmlWriter::StartArray()
 {
-  StartValue();
-  myPrinter.OpenElement(ARRAY_TAG, true);
-  myPrinter.OpenElement(DATA_TAG, true);
+  Append("<value><array><data");
+  myIsElementOpen = true;
 }
 
 void XmlWriter::EndArray()
 {
-  myPrinter.CloseElement(true);
-  myPrinter.CloseElement(true);
-  EndValue();
+  AppendEnd("/></array></value>", "</data></array></value>");
 }
 
 void XmlWriter::StartStruct()
 {
-  StartValue();
-  myPrinter.OpenElement(STRUCT_TAG, true);
+  Append("<value><struct");
+  myIsElementOpen = true;
 }
 
 void XmlWriter::EndStruct()
 {
-  myPrinter.CloseElement(true);
-  EndValue();
+  AppendEnd("/></value>", "</struct></value>");
 }
 
 void XmlWriter::StartStructElement(const std::string& name)
 {
-  myPrinter.OpenElement(MEMBER_TAG, true);
+  Append("<member><name>");
+  AppendEscaped(name.data(), name.size());
+  Append("</name>");
+}
 
-  myPrinter.OpenElement(NAME_TAG, true);
-  myPrinter.PushText(name.c_str());
-  myPrinter.CloseElement(true);
+void XmlWriter::StartStructElement(const char* name)
+{
+  Append("<member><name>");
+  AppendEscaped(name, strlen(name));
+  Append("</name>");
 }
 
 void XmlWriter::EndStructElement()
 {
-  myPrinter.CloseElement(true);
+  Append("</member>");
+}
+
+void XmlWriter::WriteArray(const int32_t* data, size_t size)
+{
+  StartArray();
+  for (size_t i = 0; i < size; ++i) {
+    Write(data[i]);
+  }
+  EndArray();
+}
+
+void XmlWriter::WriteArray(const int64_t* data, size_t size)
+{
+  StartArray();
+  for (size_t i = 0; i < size; ++i) {
+    Write(data[i]);
+  }
+  EndArray();
+}
+
+void XmlWriter::WriteArray(const double* data, size_t size)
+{
+  StartArray();
+  for (size_t i = 0; i < size; ++i) {
+    Write(data[i]);
+  }
+  EndArray();
 }
 
 void XmlWriter::WriteBinary(const char* data, size_t size)
 {
-  StartValue();
-  myPrinter.OpenElement(BASE_64_TAG, true);
-  myPrinter.PushText(util::Base64Encode(data, size).c_str());
-  myPrinter.CloseElement(true);
-  EndValue();
+  Append("<value><base64>");
+  // Encoded straight into the buffer
+  const size_t start = myBuffer.size();
+  myBuffer.resize(start + util::Base64EncodedSize(size));
+  util::Base64Encode(data, size, &myBuffer[start]);
+  Append("</base64></value>");
 }
 
 void XmlWriter::WriteNull()
 {
-  StartValue();
-  myPrinter.OpenElement(NIL_TAG, true);
-  myPrinter.CloseElement(true);
-  EndValue();
+  Append("<value><nil/></value>");
 }
 
 void XmlWriter::Write(bool value)
 {
-  StartValue();
-  myPrinter.OpenElement(BOOLEAN_TAG, true);
-  myPrinter.PushText(value);
-  myPrinter.CloseElement(true);
-  EndValue();
+  if (value) {
+    Append("<value><boolean>1</boolean></value>");
+  }
+  else {
+    Append("<value><boolean>0</boolean></value>");
+  }
 }
 
 void XmlWriter::Write(double value)
 {
-  StartValue();
-  myPrinter.OpenElement(DOUBLE_TAG, true);
-  myPrinter.PushText(value);
-  myPrinter.CloseElement(true);
-  EndValue();
+  // XML-RPC has no representation of infinity or NaN, and the reader
+  // rejects them
+  if (!std::isfinite(value)) {
+    throw std::invalid_argument("xml: double is not finite");
+  }
+
+  // Shortest representation that reads back as the same value (at most the
+  // 17 significant digits of "%.17g"), without the ".0" that dtoa adds to
+  // integers
+  char str[32];
+  char* end = rapidjson::internal::dtoa(value, str);
+  if (end[-2] == '.' && end[-1] == '0') {
+    end -= 2;
+  }
+
+  Append("<value><double>");
+  Append(str, end);
+  Append("</double></value>");
 }
 
 void XmlWriter::Write(int32_t value)
 {
-  StartValue();
-  myPrinter.OpenElement(INTEGER_32_TAG, true);
-  myPrinter.PushText(value);
-  myPrinter.CloseElement(true);
-  EndValue();
+  char str[16];
+  Append("<value><i4>");
+  Append(str, rapidjson::internal::i32toa(value, str));
+  Append("</i4></value>");
 }
 
 void XmlWriter::Write(int64_t value)
 {
-  StartValue();
-  myPrinter.OpenElement(INTEGER_64_TAG, true);
-  myPrinter.PushText(std::to_string(value).c_str());
-  myPrinter.CloseElement(true);
-  EndValue();
+  char str[32];
+  Append("<value><i8>");
+  Append(str, rapidjson::internal::i64toa(value, str));
+  Append("</i8></value>");
 }
 
 void XmlWriter::Write(const std::string& value)
 {
-  StartValue();
-  myPrinter.OpenElement(STRING_TAG, true);
-  myPrinter.PushText(value.c_str());
-  myPrinter.CloseElement(true);
-  EndValue();
+  Write(value.data(), value.size());
+}
+
+void XmlWriter::Write(const char* data, size_t size)
+{
+  Append("<value><string>");
+  AppendEscaped(data, size);
+  Append("</string></value>");
 }
 
-void XmlWriter::Write(const tm& value)
+void XmlWriter::Write(const Value::DateTime& value)
 {
-  StartValue();
-  myPrinter.OpenElement(DATE_TIME_TAG, true);
-  myPrinter.PushText(util::FormatIso8601DateTime(value).c_str());
-  myPrinter.CloseElement(true);
-  EndValue();
+  char str[util::ISO_8601_DATE_TIME_MAX_LENGTH];
+  Append("<value><dateTime.iso8601>");
+  Append(str, util::FormatIso8601DateTime(value, str));
+  Append("</dateTime.iso8601></value>");
 }
 
-void XmlWriter::StartValue()
+bool XmlWriter::WriteRaw(Value::Format format, const char* data, size_t size)
 {
-  myPrinter.OpenElement(VALUE_TAG, true);
+  if (format != Value::Format::XML) {
+    return false;
+  }
+  Append(data, data + size);
+  return true;
 }
 
-void XmlWriter::EndValue()
+void XmlWriter::WriteValue(const Value& value)
 {
-  myPrinter.CloseElement(true);
+  SerializeValue(value, *this);
 }
 
 } // namespace xsonrpc
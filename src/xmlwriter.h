@@ -20,18 +20,24 @@
 
 #include "writer.h"
 
-#include <tinyxml2.h>
+#include <string>
 
 namespace xsonrpc {
 
+// Writes XML-RPC without indentation directly to a buffer. The markup
+// around values is appended as precomputed tag sequences, and only text is
+// escaped.
 class XmlWriter final : public Writer
 {
 public:
   // Writer
   const char* GetData() override;
   size_t GetSize() override;
+  void ClearData() override;
   void StartDocument() override;
   void EndDocument() override;
+  void StartBatch() override;
+  void EndBatch() override;
   void StartRequest(const std::string& methodName, const Value& id) override;
   void EndRequest() override;
   void StartParameter() override;
@@ -46,7 +52,11 @@ public:
   void StartStruct() override;
   void EndStruct() override;
   void StartStructElement(const std::string& name) override;
+  void StartStructElement(const char* name) override;
   void EndStructElement() override;
+  void WriteArray(const int32_t* data, size_t size) override;
+  void WriteArray(const int64_t* data, size_t size) override;
+  void WriteArray(const double* data, size_t size) override;
   void WriteBinary(const char* data, size_t size) override;
   void WriteNull() override;
   void Write(bool value) override;
@@ -54,13 +64,23 @@ public:
   void Write(int32_t value) override;
   void Write(int64_t value) override;
   void Write(const std::string& value) override;
-  void Write(const tm& value) override;
+  void Write(const char* data, size_t size) override;
+  void Write(const Value::DateTime& value) override;
+  bool WriteRaw(Value::Format format, const char* data, size_t size) override;
+  void WriteValue(const Value& value) override;
 
 private:
-  void StartValue();
-  void EndValue();
+  template<size_t N>
+  void Append(const char (&str)[N]);
+  void Append(const char* begin, const char* end);
+  void AppendEscaped(const char* data, size_t size);
+  template<size_t N, size_t M>
+  void AppendEnd(const char (&emptyEnd)[N], const char (&end)[M]);
 
-  tinyxml2::XMLPrinter myPrinter;
+  std::string myBuffer;
+  // The '>' of an element that may be empty is written only once something
+  // else is, so that an empty element can be written as <tag/>
+  bool myIsElementOpen = false;
 };
 
 } // namespace xsonrpc
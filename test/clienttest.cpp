@@ -0,0 +1,201 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "client.h"
+
+#include "dispatcher.h"
+#include "fault.h"
+#include "formathandler.h"
+#include "jsonformathandler.h"
+#include "msgpackformathandler.h"
+#include "server.h"
+#include "xmlformathandler.h"
+#include "writer.h"
+#include "xmlrpcsystemmethods.h"
+#include "../src/reader.h"
+#include "../src/requestparser.h"
+
+#include <catch.hpp>
+#include <csignal>
+#include <limits>
+#include <memory>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace xsonrpc;
+
+namespace {
+
+const unsigned short PORT = 18080;
+
+// Records the content type of the last request that was read
+class RecordingFormatHandler : public FormatHandler
+{
+public:
+  RecordingFormatHandler(FormatHandler& formatHandler, std::string& last)
+    : myFormatHandler(formatHandler),
+      myLast(last)
+  {
+  }
+
+  bool CanHandleRequest(const std::string& path,
+                        const std::string& contentType) override
+  {
+    return myFormatHandler.CanHandleRequest(path, contentType);
+  }
+  std::string GetContentType() override
+  {
+    return myFormatHandler.GetContentType();
+  }
+  bool UsesId() override { return myFormatHandler.UsesId(); }
+  std::unique_ptr<Reader> CreateReader(std::string data) override
+  {
+    myLast = GetContentType();
+    return myFormatHandler.CreateReader(std::move(data));
+  }
+  std::unique_ptr<RequestParser> CreateRequestParser(
+    const Dispatcher& dispatcher) override
+  {
+    myLast = GetContentType();
+    return myFormatHandler.CreateRequestParser(dispatcher);
+  }
+  std::unique_ptr<Writer> CreateWriter() override
+  {
+    return myFormatHandler.CreateWriter();
+  }
+
+private:
+  FormatHandler& myFormatHandler;
+  std::string& myLast;
+};
+
+// The client waits for the reply, so the server runs in a child process
+// until the test is done
+class ServerProcess
+{
+public:
+  explicit ServerProcess(Server& server)
+    : myPid(fork())
+  {
+    if (myPid == 0) {
+      for (;;) {
+        server.Run();
+        usleep(1000);
+      }
+    }
+  }
+
+  ~ServerProcess()
+  {
+    kill(myPid, SIGKILL);
+    waitpid(myPid, nullptr, 0);
+  }
+
+private:
+  pid_t myPid;
+};
+
+} // namespace
+
+TEST_CASE("format negotiation")
+{
+  Client::GlobalInit();
+
+  JsonFormatHandler json;
+  MsgPackFormatHandler msgPack;
+  XmlFormatHandler xml;
+  std::string last;
+  RecordingFormatHandler recordingJson(json, last);
+  RecordingFormatHandler recordingMsgPack(msgPack, last);
+  RecordingFormatHandler recordingXml(xml, last);
+
+  // The system methods are added by a call, and list the formats of the
+  // registered handlers
+  Server server(PORT);
+  server.RegisterFormatHandler(recordingJson);
+  server.RegisterFormatHandler(recordingMsgPack);
+  server.RegisterFormatHandler(recordingXml);
+  auto& dispatcher = server.GetDispatcher();
+  std::unique_ptr<XmlRpcSystemMethods> systemMethods;
+  dispatcher.AddMethod("format", [&] { return last; });
+  dispatcher.AddMethod(
+    "enable", [&]
+    {
+      systemMethods.reset(new XmlRpcSystemMethods(dispatcher, false));
+    });
+
+  // Only reads MessagePack
+  Server otherServer(PORT + 1);
+  otherServer.RegisterFormatHandler(recordingMsgPack);
+  otherServer.GetDispatcher().AddMethod("format", [&] { return last; });
+  XmlRpcSystemMethods otherSystemMethods(otherServer.GetDispatcher(), false);
+
+  ServerProcess process(server);
+  ServerProcess otherProcess(otherServer);
+
+  // Without system methods the client keeps its format, but the next
+  // client asks again
+  {
+    Client client("localhost", PORT, xml);
+    client.SetFormatHandlers({&json});
+    CHECK(client.Call("format").AsString() == xml.GetContentType());
+    client.Call("enable");
+  }
+  {
+    Client client("localhost", PORT, xml);
+    client.SetFormatHandlers({&json});
+    CHECK(client.Call("format").AsString() == json.GetContentType());
+  }
+
+  // The choice is cached per set of handlers
+  {
+    Client client("localhost", PORT, xml);
+    client.SetFormatHandlers({&json});
+    CHECK(client.Call("format").AsString() == json.GetContentType());
+  }
+  {
+    Client client("localhost", PORT, xml);
+    client.SetFormatHandlers({&msgPack, &json});
+    CHECK(client.Call("format").AsString() == msgPack.GetContentType());
+  }
+
+  // The query is sent in another format if the server can't read it, and
+  // formats that the server doesn't read are skipped
+  {
+    Client client("localhost", PORT + 1, xml);
+    client.SetFormatHandlers({&json, &msgPack});
+    CHECK(client.Call("format").AsString() == msgPack.GetContentType());
+  }
+}
+
+TEST_CASE("server writer errors")
+{
+  Client::GlobalInit();
+
+  XmlFormatHandler xml;
+  Server server(PORT + 2);
+  server.RegisterFormatHandler(xml);
+  server.GetDispatcher().AddMethod(
+    "nan", [] { return std::numeric_limits<double>::quiet_NaN(); });
+  ServerProcess process(server);
+
+  // XML-RPC can't represent NaN, so the writer throws, which the client
+  // gets as a fault instead of an empty HTTP error
+  Client client("localhost", PORT + 2, xml);
+  CHECK_THROWS_AS(client.Call("nan"), InternalErrorFault);
+}
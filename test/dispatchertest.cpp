@@ -225,7 +225,15 @@ TEST_CASE("dispatcher")
     CHECK(response.GetId().AsInteger32() == 1);
   }
 
+  // A decoder can outlive the method
+  auto decoder = dispatcher.CreateParameterDecoder("test");
   dispatcher.RemoveMethod("test");
+  if (decoder) {
+    decoder->StartParameter();
+    decoder->Boolean(true);
+    decoder->EndParameter();
+    CHECK(decoder->Invoke().AsBoolean());
+  }
 
   {
     auto response = dispatcher.Invoke("test", {true}, 1);
@@ -233,6 +241,60 @@ TEST_CASE("dispatcher")
   }
 }
 
+TEST_CASE("dispatcher with vector parameters")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "scale",
+    [] (const std::vector<double>& values, double factor)
+    {
+      std::vector<double> result;
+      for (auto value : values) {
+        result.push_back(value * factor);
+      }
+      return result;
+    });
+  dispatcher.AddMethod(
+    "join",
+    [] (std::vector<std::string> values)
+    {
+      std::string result;
+      for (auto& value : values) {
+        result += value;
+      }
+      return result;
+    });
+
+  Request::Parameters params;
+
+  GIVEN("packed array")
+  {
+    params.emplace_back(std::vector<double>{1, 2.5});
+  }
+  GIVEN("array")
+  {
+    Value::Array array;
+    array.emplace_back(1);
+    array.emplace_back(2.5);
+    params.emplace_back(std::move(array));
+  }
+
+  params.emplace_back(2.0);
+  auto response = dispatcher.Invoke("scale", params, 1);
+  CAPTURE(response.GetResult());
+  REQUIRE_FALSE(response.IsFault());
+  CHECK(response.GetResult().IsDoubleArray());
+  CHECK(response.GetResult().AsDoubleArray() == (std::vector<double>{2, 5}));
+
+  response = dispatcher.Invoke(
+    "join", {std::vector<std::string>{"foo", "bar"}}, 1);
+  REQUIRE_FALSE(response.IsFault());
+  CHECK(response.GetResult().AsString() == "foobar");
+
+  response = dispatcher.Invoke("join", {std::vector<int32_t>{1}}, 1);
+  CHECK(response.IsFault());
+}
+
 TEST_CASE("dispatcher returning void")
 {
   Dispatcher dispatcher;
@@ -17,12 +17,21 @@
 
 #include "request.h"
 
+#include "cborformathandler.h"
+#include "client.h"
+#include "compactformathandler.h"
+#include "dispatcher.h"
 #include "jsonformathandler.h"
+#include "msgpackformathandler.h"
+#include "writer.h"
 #include "xmlformathandler.h"
+#include "../src/attachments.h"
+#include "../src/compact.h"
 #include "../src/reader.h"
-#include "../src/writer.h"
+#include "../src/requestparser.h"
 
 #include <catch.hpp>
+#include <algorithm>
 #include <memory>
 
 using namespace xsonrpc;
@@ -184,3 +193,828 @@ TEST_CASE("three parameters")
         "</params>"
         "</methodCall>");
 }
+
+TEST_CASE("invoke json request")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "typed",
+    [] (int32_t a, const std::string& b, const std::vector<double>& c,
+        const Value& d)
+    {
+      return b + std::to_string(
+        a + c.size() + d.AsStruct().at("x").AsInteger32());
+    });
+  dispatcher.AddMethod(
+    "untyped",
+    [] (const Request::Parameters& params)
+    {
+      return Value(static_cast<int32_t>(params.size()));
+    });
+
+  auto invoke = [&] (std::string json)
+  {
+    auto reader = JsonFormatHandler().CreateReader(std::move(json));
+    reader->SetStringsByReference(true);
+    return reader->InvokeRequest(dispatcher);
+  };
+
+  std::unique_ptr<Response> response;
+
+  GIVEN("method before params")
+  {
+    response.reset(new Response(invoke(
+      R"({"jsonrpc": "2.0", "method": "typed", "id": 4, "extra": [{}],)"
+      R"( "params": [7, "a", [1.5, 2], {"x": 10}]})")));
+  }
+  GIVEN("params before method")
+  {
+    response.reset(new Response(invoke(
+      R"({"params": [7, "a", [1.5, 2], {"x": 10}], "id": 4,)"
+      R"( "jsonrpc": "2.0", "method": "typed"})")));
+  }
+
+  REQUIRE(response);
+  CAPTURE(response->GetResult());
+  REQUIRE_FALSE(response->IsFault());
+  CHECK(response->GetResult().AsString() == "a19");
+  CHECK(response->GetId().AsInteger32() == 4);
+
+  auto fault = invoke(
+    R"({"jsonrpc": "2.0", "method": "typed", "params": [7, 8, [], {}]})");
+  CHECK_THROWS_AS(fault.ThrowIfFault(), InvalidParametersFault);
+  CHECK(fault.GetId().IsBoolean());
+
+  fault = invoke(R"({"jsonrpc": "2.0", "method": "typed", "params": [7]})");
+  CHECK_THROWS_AS(fault.ThrowIfFault(), InvalidParametersFault);
+
+  fault = invoke(R"({"jsonrpc": "2.0", "method": "missing", "id": "x"})");
+  CHECK_THROWS_AS(fault.ThrowIfFault(), MethodNotFoundFault);
+  CHECK(fault.GetId().AsString() == "x");
+
+  auto result = invoke(
+    R"({"jsonrpc": "2.0", "method": "untyped", "params": [1, [2], {}]})");
+  CHECK(result.GetResult().AsInteger32() == 3);
+
+  CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "method": "untyped")"),
+                  ParseErrorFault);
+  CHECK_THROWS_AS(invoke(R"({"jsonrpc": "1.0", "method": "untyped"})"),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "method": 1})"),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "params": []})"),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(
+    invoke(R"({"jsonrpc": "2.0", "method": "untyped", "params": 1})"),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(
+    invoke(R"({"jsonrpc": "2.0", "method": "untyped", "id": 1.5})"),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(invoke("[]"), InvalidRequestFault);
+}
+
+TEST_CASE("invoke xml request")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "typed",
+    [] (int32_t a, const std::string& b, const std::vector<int32_t>& c)
+    {
+      return b + std::to_string(a + c.size());
+    });
+  dispatcher.AddMethod(
+    "untyped",
+    [] (const Request::Parameters& params)
+    {
+      return Value(params[0]);
+    });
+
+  // Strings in the results reference the reader
+  std::unique_ptr<Reader> reader;
+  auto invoke = [&] (std::string xml)
+  {
+    reader = XmlFormatHandler().CreateReader(std::move(xml));
+    reader->SetStringsByReference(true);
+    return reader->InvokeRequest(dispatcher);
+  };
+
+  auto response = invoke(
+    "<?xml version=\"1.0\"?>"
+    "<methodCall><methodName>typed</methodName><params>"
+    "<param><value><i4>7</i4></value></param>"
+    "<param><value>a&amp;b</value></param>"
+    "<param><value><array><data>"
+    "<value><int>1</int></value><value><int>2</int></value>"
+    "</data></array></value></param>"
+    "</params></methodCall>");
+  CAPTURE(response.GetResult());
+  REQUIRE_FALSE(response.IsFault());
+  CHECK(response.GetResult().AsString() == "a&b9");
+
+  response = invoke(
+    "<methodCall><methodName>typed</methodName><params>"
+    "<param><value><i4>7</i4></value></param>"
+    "</params></methodCall>");
+  CHECK_THROWS_AS(response.ThrowIfFault(), InvalidParametersFault);
+
+  response = invoke(
+    "<methodCall><methodName>untyped</methodName><params>"
+    "<param><value><struct><member><name>x</name>"
+    "<value><base64>Zm9v</base64></value></member></struct></value></param>"
+    "</params></methodCall>");
+  REQUIRE_FALSE(response.IsFault());
+  CHECK(response.GetResult()["x"].IsBinary());
+  CHECK(response.GetResult()["x"].AsBinary() == "foo");
+
+  CHECK_THROWS_AS(
+    invoke("<methodCall><methodName>untyped</methodName><params>"
+           "<param><i4>1</i4></param></params></methodCall>"),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(
+    invoke("<methodCall><methodName>untyped</methodName>"),
+    ParseErrorFault);
+
+  // Nothing but whitespace and comments may follow the method call
+  response = invoke(
+    "<methodCall><methodName>untyped</methodName><params>"
+    "<param><value><base64></base64></value></param>"
+    "</params></methodCall> <!-- end -->\n");
+  REQUIRE_FALSE(response.IsFault());
+  CHECK(response.GetResult().AsBinary().empty());
+  CHECK_THROWS_AS(
+    invoke("<methodCall><methodName>untyped</methodName></methodCall>x"),
+    ParseErrorFault);
+  CHECK_THROWS_AS(
+    invoke("<methodCall><methodName>untyped</methodName><params>"
+           "</params></methodCall><methodCall/>"),
+    ParseErrorFault);
+}
+
+TEST_CASE("parse json request incrementally")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "typed",
+    [] (int32_t a, const std::string& b, const std::vector<double>& c,
+        const Value& d)
+    {
+      return b + std::to_string(
+        a + c.size() + d.AsStruct().at("x").AsInteger32());
+    });
+  dispatcher.AddMethod(
+    "untyped",
+    [] (const Request::Parameters& params)
+    {
+      return Value(params[0]);
+    });
+
+  JsonFormatHandler formatHandler;
+  // Strings in the results reference the parser
+  std::unique_ptr<RequestParser> parser;
+  auto invoke = [&] (const std::string& json, size_t chunkSize)
+  {
+    parser = formatHandler.CreateRequestParser(dispatcher);
+    for (size_t i = 0; i < json.size(); i += chunkSize) {
+      parser->Parse(json.data() + i, std::min(chunkSize, json.size() - i));
+    }
+    auto responses = parser->InvokeRequests();
+    REQUIRE_FALSE(parser->IsBatch());
+    REQUIRE(responses.size() == 1);
+    return responses.front();
+  };
+
+  for (size_t chunkSize : {1, 3, 1000}) {
+    CAPTURE(chunkSize);
+
+    auto response = invoke(
+      R"({"jsonrpc": "2.0", "method": "typed", "id": 4, "extra": [{}],)"
+      R"( "params": [7, "a", [1.5, -2e0], {"x": 10, "y": null}]})",
+      chunkSize);
+    CAPTURE(response.GetResult());
+    REQUIRE_FALSE(response.IsFault());
+    CHECK(response.GetResult().AsString() == "a19");
+    CHECK(response.GetId().AsInteger32() == 4);
+
+    response = invoke(
+      R"({"params": [7, "a", [], {"x": 10}], "id": "x",)"
+      R"( "jsonrpc": "2.0", "method": "typed"})",
+      chunkSize);
+    REQUIRE_FALSE(response.IsFault());
+    CHECK(response.GetResult().AsString() == "a17");
+    CHECK(response.GetId().AsString() == "x");
+
+    response = invoke(
+      R"({"jsonrpc": "2.0", "method": "untyped", "id": 1,)"
+      R"( "params": ["\"\u00e5\ud83d\ude00\n"]})",
+      chunkSize);
+    REQUIRE_FALSE(response.IsFault());
+    CHECK(response.GetResult().AsString() == "\"\xc3\xa5\xf0\x9f\x98\x80\n");
+
+    response = invoke(
+      R"({"jsonrpc": "2.0", "method": "untyped", "id": 1, "params":)"
+      R"( [[true, false, -2147483648, 5000000000, 18446744073709551616]]})",
+      chunkSize);
+    REQUIRE_FALSE(response.IsFault());
+    auto& array = response.GetResult().AsArray();
+    REQUIRE(array.size() == 5);
+    CHECK(array[0].AsBoolean());
+    CHECK_FALSE(array[1].AsBoolean());
+    CHECK(array[2].AsInteger32() == -2147483648LL);
+    CHECK(array[3].AsInteger64() == 5000000000LL);
+    CHECK(array[4].IsDouble());
+
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "method": "untyped")",
+                           chunkSize),
+                    ParseErrorFault);
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "method": "typed"] )",
+                           chunkSize),
+                    ParseErrorFault);
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "params": [01]})",
+                           chunkSize),
+                    ParseErrorFault);
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "params": ["\ud83d"]})",
+                           chunkSize),
+                    ParseErrorFault);
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "method": tru})",
+                           chunkSize),
+                    ParseErrorFault);
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "1.0", "method": "untyped"})",
+                           chunkSize),
+                    InvalidRequestFault);
+    CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "params": []})", chunkSize),
+                    InvalidRequestFault);
+  }
+}
+
+TEST_CASE("parse json batch")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "add", [] (int32_t a, int32_t b) { return a + b; });
+
+  JsonFormatHandler formatHandler;
+  auto parser = formatHandler.CreateRequestParser(dispatcher);
+  auto invoke = [&] (const std::string& json)
+  {
+    parser = formatHandler.CreateRequestParser(dispatcher);
+    parser->Parse(json.data(), json.size());
+    return parser->InvokeRequests();
+  };
+
+  auto responses = invoke(
+    R"([{"jsonrpc": "2.0", "method": "add", "params": [1, 2], "id": 1},)"
+    R"( {"jsonrpc": "2.0", "method": "add", "params": [3, 4]},)"
+    R"( {"jsonrpc": "2.0", "method": "add", "params": [5], "id": "b"},)"
+    R"( {"jsonrpc": "2.0", "method": "missing", "id": 3},)"
+    R"( {"jsonrpc": "2.0", "method": 1, "params": [[{}]], "id": 4},)"
+    R"( 1, [],)"
+    R"( {"jsonrpc": "2.0", "method": "add", "params": [6, 7], "id": 5}])");
+  CHECK(parser->IsBatch());
+  REQUIRE(responses.size() == 7);
+
+  CHECK(responses[0].GetId().AsInteger32() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 3);
+  CHECK(responses[1].GetId().AsString() == "b");
+  CHECK_THROWS_AS(responses[1].ThrowIfFault(), InvalidParametersFault);
+  CHECK(responses[2].GetId().AsInteger32() == 3);
+  CHECK_THROWS_AS(responses[2].ThrowIfFault(), MethodNotFoundFault);
+  for (size_t i = 3; i < 6; ++i) {
+    CHECK(responses[i].GetId().IsNil());
+    CHECK_THROWS_AS(responses[i].ThrowIfFault(), InvalidRequestFault);
+  }
+  CHECK(responses[6].GetId().AsInteger32() == 5);
+  CHECK(responses[6].GetResult().AsInteger32() == 13);
+
+  auto writer = formatHandler.CreateWriter();
+  Response::WriteBatch({responses[0], responses[2]}, *writer);
+  CHECK(std::string(writer->GetData(), writer->GetSize()) ==
+        R"([{"jsonrpc":"2.0","id":1,"result":3},)"
+        R"({"jsonrpc":"2.0","id":3,"error":{"code":-32601,)"
+        R"("message":"Method not found: missing"}}])");
+
+  responses = invoke(
+    R"([{"jsonrpc": "2.0", "method": "add", "params": [1, 2]}])");
+  CHECK(parser->IsBatch());
+  CHECK(responses.empty());
+
+  CHECK_THROWS_AS(invoke("[]"), InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(R"([{"jsonrpc": "2.0", "method": "add"})"),
+                  ParseErrorFault);
+}
+
+TEST_CASE("parse json notification")
+{
+  Dispatcher dispatcher;
+  int32_t sum = 0;
+  dispatcher.AddMethod("add", [&] (int32_t a) { sum += a; });
+
+  JsonFormatHandler formatHandler;
+  auto invoke = [&] (const std::string& json)
+  {
+    auto parser = formatHandler.CreateRequestParser(dispatcher);
+    parser->Parse(json.data(), json.size());
+    return parser->InvokeRequests();
+  };
+
+  CHECK(invoke(R"({"jsonrpc": "2.0", "method": "add", "params": [2]})")
+        .empty());
+  CHECK(sum == 2);
+  CHECK(invoke(R"({"jsonrpc": "2.0", "method": "add", "params": ["x"]})")
+        .empty());
+  CHECK(invoke(R"({"jsonrpc": "2.0", "method": "missing"})").empty());
+  CHECK(invoke(R"({"jsonrpc": "2.0", "method": "add", "params": [3],)"
+               R"( "id": null})").size() == 1);
+  CHECK(sum == 5);
+  CHECK_THROWS_AS(invoke(R"({"jsonrpc": "2.0", "params": [3]})"),
+                  InvalidRequestFault);
+
+  Request notification("add", {1}, false);
+  CHECK(ToJson(notification) ==
+        R"({"jsonrpc":"2.0","method":"add","params":[1]})");
+}
+
+TEST_CASE("msgpack request")
+{
+  Dispatcher dispatcher;
+  int32_t sum = 0;
+  dispatcher.AddMethod(
+    "add", [&] (int32_t a, const std::string&) { return sum += a; });
+  dispatcher.AddMethod(
+    "untyped",
+    [] (const Request::Parameters& params)
+    {
+      return Value(static_cast<int32_t>(params.size()));
+    });
+
+  MsgPackFormatHandler formatHandler;
+  auto write = [&] (const Request& request)
+  {
+    auto writer = formatHandler.CreateWriter();
+    request.Write(*writer);
+    return std::string(writer->GetData(), writer->GetSize());
+  };
+  auto invoke = [&] (const std::string& data)
+  {
+    auto parser = formatHandler.CreateRequestParser(dispatcher);
+    // Arrives in parts
+    parser->Parse(data.data(), 3);
+    parser->Parse(data.data() + 3, data.size() - 3);
+    CHECK_FALSE(parser->IsBatch());
+    return parser->InvokeRequests();
+  };
+
+  Request request("add", {2, "x"}, 7);
+  const auto data = write(request);
+  CHECK(data == std::string("\x94\x00\x07\xa3" "add\x92\x02\xa1x", 11));
+
+  auto read = formatHandler.CreateReader(data)->GetRequest();
+  CHECK(read.GetMethodName() == "add");
+  REQUIRE(read.GetParameters().size() == 2);
+  CHECK(read.GetParameters()[1].AsString() == "x");
+  CHECK(read.GetId().AsInteger32() == 7);
+
+  auto responses = invoke(data);
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 2);
+  CHECK(responses[0].GetId().AsInteger32() == 7);
+
+  responses = invoke(write(Request("untyped", {1, 2, 3}, 8)));
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 3);
+
+  // Notifications get no response, even for faults
+  const auto notification = write(Request("add", {3, "y"}, false));
+  CHECK(notification[0] == '\x93');
+  CHECK(notification[1] == 2);
+  CHECK(invoke(notification).empty());
+  CHECK(sum == 5);
+  CHECK(invoke(write(Request("missing", {}, false))).empty());
+  CHECK(invoke(std::string("\x93\x02\xa3" "add\x92\x01", 8)).empty());
+
+  // Nested too deep
+  CHECK_THROWS_AS(
+    invoke(std::string("\x94\x00\x01\xa1x\x91", 6)
+           + std::string(100000, '\x91') + '\xc0'),
+    InvalidRequestFault);
+
+  CHECK_THROWS_AS(invoke("\x93\x05\xa1x\x90"), InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(std::string("\x94\x00\x01\x01\x90", 5)),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(std::string("\x94\x00\x01\xa1x\x91", 6)),
+                  ParseErrorFault);
+  CHECK_THROWS_AS(
+    Request::WriteBatch({request}, *formatHandler.CreateWriter()),
+    std::logic_error);
+}
+
+TEST_CASE("cbor request")
+{
+  Dispatcher dispatcher;
+  int32_t sum = 0;
+  dispatcher.AddMethod(
+    "add", [&] (int32_t a, const std::string&) { return sum += a; });
+  dispatcher.AddMethod(
+    "untyped",
+    [] (const Request::Parameters& params)
+    {
+      return Value(static_cast<int32_t>(params.size()));
+    });
+
+  CborFormatHandler formatHandler;
+  auto write = [&] (const Request& request)
+  {
+    auto writer = formatHandler.CreateWriter();
+    request.Write(*writer);
+    return std::string(writer->GetData(), writer->GetSize());
+  };
+  auto invoke = [&] (const std::string& data)
+  {
+    auto parser = formatHandler.CreateRequestParser(dispatcher);
+    // Arrives in parts
+    parser->Parse(data.data(), 3);
+    parser->Parse(data.data() + 3, data.size() - 3);
+    CHECK_FALSE(parser->IsBatch());
+    return parser->InvokeRequests();
+  };
+
+  Request request("add", {2, "x"}, 7);
+  const auto data = write(request);
+  CHECK(data == std::string("\x84\x00\x07\x63" "add\x9f\x02\x61x\xff", 12));
+
+  auto read = formatHandler.CreateReader(data)->GetRequest();
+  CHECK(read.GetMethodName() == "add");
+  REQUIRE(read.GetParameters().size() == 2);
+  CHECK(read.GetParameters()[1].AsString() == "x");
+  CHECK(read.GetId().AsInteger32() == 7);
+
+  auto responses = invoke(data);
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 2);
+  CHECK(responses[0].GetId().AsInteger32() == 7);
+
+  responses = invoke(write(Request("untyped", {1, 2, 3}, 8)));
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 3);
+
+  // Parameters of definite length
+  responses = invoke(
+    std::string("\x84\x00\x09\x63" "add\x82\x02\x61x", 11));
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 4);
+
+  // Notifications get no response, even for faults
+  const auto notification = write(Request("add", {3, "y"}, false));
+  CHECK(notification[0] == '\x83');
+  CHECK(notification[1] == 2);
+  CHECK(invoke(notification).empty());
+  CHECK(sum == 7);
+  CHECK(invoke(write(Request("missing", {}, false))).empty());
+  CHECK(invoke(std::string("\x83\x02\x63" "add\x82\x01", 8)).empty());
+
+  // Nested too deep, also by a chain of tags
+  CHECK_THROWS_AS(
+    invoke(std::string("\x84\x00\x01\x61x\x81", 6)
+           + std::string(100000, '\x81') + '\xf6'),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(
+    invoke(std::string("\x84\x00\x01\x61x\x81", 6)
+           + std::string(100000, '\xc6') + '\xf6'),
+    InvalidRequestFault);
+
+  CHECK_THROWS_AS(invoke("\x83\x05\x61x\x80"), InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(std::string("\x84\x00\x01\x01\x80", 5)),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(std::string("\x84\x00\x01\x61x\x81", 6)),
+                  ParseErrorFault);
+  CHECK_THROWS_AS(
+    Request::WriteBatch({request}, *formatHandler.CreateWriter()),
+    std::logic_error);
+}
+
+TEST_CASE("compact request")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "add",
+    [] (int32_t a, int64_t b, const std::string& c)
+    {
+      return a + b + static_cast<int64_t>(c.size());
+    })
+    .AddSignature(Value::Type::INTEGER_32, Value::Type::STRING)
+    .AddSignature(Value::Type::INTEGER_64, Value::Type::INTEGER_32,
+                  Value::Type::INTEGER_64, Value::Type::STRING);
+  dispatcher.AddMethod(
+    "untyped",
+    [] (const Request::Parameters& params)
+    {
+      return Value(static_cast<int32_t>(params.size()));
+    })
+    .AddSignature(Value::Type::INTEGER_32, Value::Type::ARRAY,
+                  Value::Type::STRUCT, Value::Type::BOOLEAN);
+
+  CompactFormatHandler formatHandler;
+  formatHandler.AddSignature("add", Value::Type::INTEGER_64,
+                             Value::Type::INTEGER_32,
+                             Value::Type::INTEGER_64, Value::Type::STRING);
+  auto write = [&] (const Request& request)
+  {
+    auto writer = formatHandler.CreateWriter();
+    request.Write(*writer);
+    return std::string(writer->GetData(), writer->GetSize());
+  };
+  auto invoke = [&] (const std::string& data)
+  {
+    auto parser = formatHandler.CreateRequestParser(dispatcher);
+    // Arrives in parts
+    parser->Parse(data.data(), 3);
+    parser->Parse(data.data() + 3, data.size() - 3);
+    CHECK_FALSE(parser->IsBatch());
+    return parser->InvokeRequests();
+  };
+
+  // Parameters by the signature, without types
+  Request request("add", {2, 3, "xy"}, 7);
+  const auto data = write(request);
+  const auto hash = compact::GetSchemaHash(
+    "add", dispatcher.GetMethod("add").GetSignatures()[1]);
+  std::string expected("\x00\x03\x07\0\0\0\x03\0\0\0" "add", 13);
+  for (size_t i = 0; i < sizeof(hash); ++i) {
+    expected += static_cast<char>(hash >> (8 * i));
+  }
+  expected.append("\x02\0\0\0\x03\0\0\0\0\0\0\0\x02\0\0\0" "xy", 18);
+  CHECK(data == expected);
+
+  auto read = formatHandler.CreateReader(data)->GetRequest();
+  CHECK(read.GetMethodName() == "add");
+  REQUIRE(read.GetParameters().size() == 3);
+  CHECK(read.GetParameters()[1].IsInteger64());
+  CHECK(read.GetParameters()[2].AsString() == "xy");
+  CHECK(read.GetId().AsInteger32() == 7);
+
+  auto responses = invoke(data);
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger64() == 7);
+  CHECK(responses[0].GetId().AsInteger32() == 7);
+
+  // Other methods have typed parameters
+  responses = invoke(write(Request("untyped", {1, 2, 3}, 8)));
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 3);
+
+  // Containers are typed, also by a signature
+  formatHandler.AddSignature("untyped", Value::Type::INTEGER_32,
+                             Value::Type::ARRAY, Value::Type::STRUCT,
+                             Value::Type::BOOLEAN);
+  responses = invoke(write(Request(
+    "untyped",
+    {Value::Array{1, "a"}, Value::Struct{{"a", 1}}, true}, 9)));
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetResult().AsInteger32() == 3);
+  CHECK_THROWS_AS(write(Request("untyped", {1, Value::Struct{}, true}, 1)),
+                  std::invalid_argument);
+
+  // Notifications get no response, even for faults
+  const auto notification = write(Request("add", {1, 1, ""}, false));
+  CHECK(notification[0] == '\x02');
+  CHECK(invoke(notification).empty());
+  CHECK(invoke(write(Request("missing", {}, false))).empty());
+  CHECK(invoke(notification.substr(0, notification.size() - 1)).empty());
+
+  // Signatures that the server doesn't have
+  formatHandler.AddSignature("add", Value::Type::INTEGER_64,
+                             Value::Type::INTEGER_32,
+                             Value::Type::INTEGER_32, Value::Type::STRING);
+  responses = invoke(write(request));
+  REQUIRE(responses.size() == 1);
+  CHECK(responses[0].GetId().AsInteger32() == 7);
+  CHECK_THROWS_AS(responses[0].ThrowIfFault(), InvalidParametersFault);
+  // Without a dispatcher, only the signatures of the format handler are
+  // known, so a call the server can read is rejected
+  CHECK(invoke(data)[0].GetResult().AsInteger64() == 7);
+  CHECK_THROWS_AS(CompactFormatHandler().CreateReader(data)->GetRequest(),
+                  InvalidRequestFault);
+  formatHandler.AddSignature("missing", Value::Type::NIL);
+  responses = invoke(write(Request("missing", {}, 3)));
+  REQUIRE(responses.size() == 1);
+  CHECK_THROWS_AS(responses[0].ThrowIfFault(), MethodNotFoundFault);
+  formatHandler.RemoveSignature("missing");
+
+  // Parameters that don't match the signature
+  CHECK_THROWS_AS(write(Request("add", {2, 3.5, "x"}, 1)),
+                  std::invalid_argument);
+  CHECK_THROWS_AS(write(Request("add", {2, 3}, 1)), std::invalid_argument);
+  CHECK_THROWS_AS(write(Request("add", {2, 3, "x", 4}, 1)),
+                  std::invalid_argument);
+  CHECK_NOTHROW(write(Request("add", {int64_t(2), 3, "x"}, 1)));
+  CHECK_THROWS_AS(write(Request("add", {int64_t(1) << 32, 3, "x"}, 1)),
+                  std::invalid_argument);
+
+  // Nested too deep
+  auto nested = write(Request("missing", {}, 1));
+  nested[nested.size() - 4] = 1;
+  for (int i = 0; i < 100000; ++i) {
+    nested.append("\x09\x01\0\0\0", 5);
+  }
+  nested += '\0';
+  CHECK_THROWS_AS(invoke(nested), InvalidRequestFault);
+
+  CHECK_THROWS_AS(invoke(std::string("\x05\0\0\0", 4)),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(invoke(data.substr(0, data.size() - 1)), ParseErrorFault);
+  CHECK_THROWS_AS(invoke(data + "x"), InvalidRequestFault);
+  CHECK_THROWS_AS(
+    Request::WriteBatch({request}, *formatHandler.CreateWriter()),
+    std::logic_error);
+}
+
+TEST_CASE("batch of requests")
+{
+  Batch batch;
+  CHECK(batch.Add("a") == 0);
+  CHECK(batch.Add("b", 1, "x") == 1);
+  CHECK(batch.Add("c", Request::Parameters{true}) == 2);
+
+  CHECK(ToJson(batch.GetRequests()[1]) ==
+        R"({"jsonrpc":"2.0","method":"b","id":1,"params":[1,"x"]})");
+
+  auto writer = JsonFormatHandler().CreateWriter();
+  Request::WriteBatch(batch.GetRequests(), *writer);
+  CHECK(std::string(writer->GetData(), writer->GetSize()) ==
+        R"([{"jsonrpc":"2.0","method":"a","id":0,"params":[]},)"
+        R"({"jsonrpc":"2.0","method":"b","id":1,"params":[1,"x"]},)"
+        R"({"jsonrpc":"2.0","method":"c","id":2,"params":[true]}])");
+
+  CHECK_THROWS_AS(
+    Request::WriteBatch(batch.GetRequests(),
+                        *XmlFormatHandler().CreateWriter()),
+    std::logic_error);
+}
+
+TEST_CASE("request with attachments")
+{
+  const std::string small(10, 'x');
+  std::string large(2 * ATTACHMENT_MIN_SIZE, '\0');
+  for (size_t i = 0; i < large.size(); ++i) {
+    large[i] = static_cast<char>(i * 7);
+  }
+  Request::Parameters params;
+  params.emplace_back(small, true);
+  params.emplace_back(Value::Array{1, Value(large, true)});
+  params.emplace_back("text");
+
+  for (bool isJson : {true, false}) {
+    std::unique_ptr<FormatHandler> handler(
+      isJson ? static_cast<FormatHandler*>(new JsonFormatHandler())
+      : new XmlFormatHandler());
+
+    AttachmentWriter writer(handler->CreateWriter());
+    Request::Write("foo", params, 1, writer);
+    REQUIRE(writer.GetAttachments().size() == 1);
+    CHECK(writer.GetAttachments()[0].Data.Data
+          == params[1][1].AsBinary().data());
+    const std::string body(writer.GetData(), writer.GetSize());
+    CHECK(body.find(ATTACHMENT_NAME) != std::string::npos);
+    CHECK(body.size() < large.size());
+
+    auto boundary = CreateBoundary(
+      body.data(), body.size(), writer.GetAttachments());
+    std::string message;
+    WriteMultipart(message, boundary, handler->GetContentType(),
+                   body.data(), body.size(), writer.GetAttachments());
+
+    std::string rootType;
+    std::string readBoundary;
+    REQUIRE(ParseMultipartContentType(
+              GetMultipartContentType(handler->GetContentType(), boundary),
+              rootType, readBoundary));
+    CHECK(rootType == handler->GetContentType());
+    CHECK(readBoundary == boundary);
+
+    Attachments attachments;
+    auto root = ReadMultipart(message, readBoundary, attachments);
+    CHECK(std::string(root.Data, root.Size) == body);
+    REQUIRE(attachments.size() == 1);
+    CHECK(attachments[0].Id == writer.GetAttachments()[0].Id);
+    CHECK(attachments[0].Data.Data > message.data());
+    CHECK(attachments[0].Data.Data < message.data() + message.size());
+
+    auto reader = handler->CreateReader(std::string(root.Data, root.Size));
+    Request request = reader->GetRequest();
+    REQUIRE(request.GetParameters().size() == 3);
+    // Without the attachment, the reference is like any other struct
+    CHECK(ResolveAttachments(Value(request.GetParameters()[1]), {}, false)
+          [1].IsStruct());
+    Value value = ResolveAttachments(
+      std::move(request.GetParameters()[1]), attachments, true);
+    REQUIRE(value.IsArray());
+    CHECK(value[0].AsInteger32() == 1);
+    REQUIRE(value[1].IsBinary());
+    CHECK(value[1].IsStringRef());
+    CHECK(value[1].AsStringRef().Data == attachments[0].Data.Data);
+    CHECK(value[1].AsBinary() == large);
+
+    value = ResolveAttachments(
+      std::move(request.GetParameters()[0]), attachments, false);
+    CHECK(value.AsBinary() == small);
+    CHECK(request.GetParameters()[2].AsString() == "text");
+  }
+}
+
+TEST_CASE("invoke request with attachments")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod("size", [] (const std::string& data, int32_t n) {
+      return static_cast<int32_t>(data.size()) * n;
+    });
+  dispatcher.AddMethod("type", [] (const Request::Parameters& params) {
+      return static_cast<int32_t>(params.at(0).GetType());
+    });
+
+  const std::string large(2 * ATTACHMENT_MIN_SIZE, 'x');
+  std::vector<std::unique_ptr<FormatHandler>> handlers;
+  handlers.emplace_back(new JsonFormatHandler());
+  handlers.emplace_back(new XmlFormatHandler());
+  handlers.emplace_back(new MsgPackFormatHandler());
+  handlers.emplace_back(new CborFormatHandler());
+  for (auto& handler : handlers) {
+    for (auto name : {"size", "type"}) {
+      AttachmentWriter writer(handler->CreateWriter());
+      Request::Write(name, {Value(large, true), 2}, 1, writer);
+      REQUIRE(writer.GetAttachments().size() == 1);
+      const std::string root(writer.GetData(), writer.GetSize());
+
+      std::vector<Response> responses;
+      if (auto parser = handler->CreateRequestParser(dispatcher)) {
+        parser->SetAttachments(writer.GetAttachments());
+        parser->Parse(root.data(), root.size());
+        responses = parser->InvokeRequests();
+      }
+      else {
+        auto reader = handler->CreateReader(root);
+        reader->SetAttachments(writer.GetAttachments());
+        responses.push_back(reader->InvokeRequest(dispatcher));
+      }
+      REQUIRE(responses.size() == 1);
+      REQUIRE_FALSE(responses[0].IsFault());
+      CHECK(responses[0].GetResult().AsInteger32()
+            == (name == std::string("size")
+                ? 2 * static_cast<int32_t>(large.size())
+                : static_cast<int32_t>(Value::Type::BINARY)));
+    }
+  }
+
+  // Batches and notifications are handled as without attachments, while a
+  // struct that names no attachment is left as is
+  Attachments attachments{{"a@b", {large.data(), large.size()}}};
+  const std::string batch =
+    R"([{"jsonrpc": "2.0", "method": "size", "id": 1,)"
+    R"( "params": [{"xsonrpc:attachment": "cid:a@b"}, 1]},)"
+    R"( {"jsonrpc": "2.0", "method": "size",)"
+    R"( "params": [{"xsonrpc:attachment": "cid:a@b"}, 1]},)"
+    R"( {"jsonrpc": "2.0", "method": "type", "id": 2,)"
+    R"( "params": [{"xsonrpc:attachment": "cid:a@c"}]},)"
+    R"( {"jsonrpc": "2.0", "method": "type", "id": 3,)"
+    R"( "params": [{"xsonrpc:attachment": 0}]}])";
+  auto parser = JsonFormatHandler().CreateRequestParser(dispatcher);
+  parser->SetAttachments(attachments);
+  parser->Parse(batch.data(), batch.size());
+  auto responses = parser->InvokeRequests();
+  CHECK(parser->IsBatch());
+  REQUIRE(responses.size() == 3);
+  CHECK(responses[0].GetResult().AsInteger32()
+        == static_cast<int32_t>(large.size()));
+  CHECK(responses[1].GetResult().AsInteger32()
+        == static_cast<int32_t>(Value::Type::STRUCT));
+  CHECK(responses[2].GetResult().AsInteger32()
+        == static_cast<int32_t>(Value::Type::STRUCT));
+}
+
+TEST_CASE("multipart content type")
+{
+  std::string rootType;
+  std::string boundary;
+  CHECK_FALSE(ParseMultipartContentType(
+                "application/json", rootType, boundary));
+  CHECK_FALSE(ParseMultipartContentType(
+                "multipart/related; boundary=x", rootType, boundary));
+  CHECK(ParseMultipartContentType(
+          "Multipart/Related;type=text/xml ; start=\"<0>\";"
+          " Boundary=\"a;\\\"b\"", rootType, boundary));
+  CHECK(rootType == "text/xml");
+  CHECK(boundary == "a;\"b");
+
+  Attachments attachments;
+  CHECK_THROWS_AS(ReadMultipart("--x\r\n\r\nroot", "x", attachments),
+                  Fault);
+  const std::string message =
+    "preamble\r\n--x\r\n\r\nroot\r\n--x  \r\nA: b\r\n"
+    "content-id: <a@b> \r\n\r\ndata\r\n--x\r\n\r\nmore\r\n--x--\r\n"
+    "epilogue";
+  auto root = ReadMultipart(message, "x", attachments);
+  CHECK(std::string(root.Data, root.Size) == "root");
+  REQUIRE(attachments.size() == 2);
+  CHECK(attachments[0].Id == "a@b");
+  CHECK(std::string(attachments[0].Data.Data, attachments[0].Data.Size)
+        == "data");
+  CHECK(attachments[1].Id.empty());
+}
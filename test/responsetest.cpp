@@ -17,13 +17,18 @@
 
 #include "response.h"
 
+#include "cborformathandler.h"
+#include "compactformathandler.h"
 #include "fault.h"
 #include "jsonformathandler.h"
+#include "msgpackformathandler.h"
+#include "writer.h"
 #include "xmlformathandler.h"
 #include "../src/reader.h"
-#include "../src/writer.h"
+#include "../src/responsestream.h"
 
 #include <catch.hpp>
+#include <memory>
 
 using namespace xsonrpc;
 
@@ -82,3 +87,284 @@ TEST_CASE("fault response")
         "</struct></value></fault>"
         "</methodResponse>");
 }
+
+TEST_CASE("batch response")
+{
+  auto reader = JsonFormatHandler().CreateReader(
+    R"([{"jsonrpc": "2.0", "id": 2, "result": "a"},)"
+    R"( {"jsonrpc": "2.0", "id": null,)"
+    R"(  "error": {"code": -32600, "message": "Invalid request"}}])");
+  auto responses = reader->GetBatchResponse();
+  REQUIRE(responses.size() == 2);
+  CHECK(responses[0].GetId().AsInteger32() == 2);
+  CHECK(responses[0].GetResult().AsString() == "a");
+  CHECK_THROWS_AS(responses[1].ThrowIfFault(), InvalidRequestFault);
+
+  reader = JsonFormatHandler().CreateReader(
+    R"({"jsonrpc": "2.0", "id": null,)"
+    R"( "error": {"code": -32700, "message": "Parse error"}})");
+  responses = reader->GetBatchResponse();
+  REQUIRE(responses.size() == 1);
+  CHECK_THROWS_AS(responses[0].ThrowIfFault(), ParseErrorFault);
+
+  reader = JsonFormatHandler().CreateReader(R"([1])");
+  CHECK_THROWS_AS(reader->GetBatchResponse(), InvalidRequestFault);
+}
+
+TEST_CASE("cbor response")
+{
+  CborFormatHandler formatHandler;
+  auto write = [&] (const Response& response)
+  {
+    auto writer = formatHandler.CreateWriter();
+    response.Write(*writer);
+    return std::string(writer->GetData(), writer->GetSize());
+  };
+
+  auto data = write(Response(true, 3));
+  CHECK(data == "\x84\x01\x03\xf6\xf5");
+  auto response = formatHandler.CreateReader(data)->GetResponse();
+  CHECK_FALSE(response.IsFault());
+  CHECK(response.GetResult().AsBoolean());
+  CHECK(response.GetId().AsInteger32() == 3);
+
+  data = write(Response(-32601, "Method not found", 4));
+  CHECK(data.substr(0, 4) == "\x84\x01\x04\xa2");
+  response = formatHandler.CreateReader(data)->GetResponse();
+  CHECK(response.GetId().AsInteger32() == 4);
+  CHECK_THROWS_AS(response.ThrowIfFault(), MethodNotFoundFault);
+
+  CHECK_THROWS_AS(
+    formatHandler.CreateReader("\x84\x01\x03\x61x\xf6")->GetResponse(),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(
+    formatHandler.CreateReader(std::string("\x84\x00\x03\xf6\xf6", 5))
+    ->GetResponse(),
+    InvalidRequestFault);
+}
+
+TEST_CASE("compact response")
+{
+  CompactFormatHandler formatHandler;
+  auto write = [&] (const Response& response)
+  {
+    auto writer = formatHandler.CreateWriter();
+    response.Write(*writer);
+    return std::string(writer->GetData(), writer->GetSize());
+  };
+
+  auto data = write(Response(true, 3));
+  CHECK(data == std::string("\x01\x03\x03\0\0\0\x02", 7));
+  auto response = formatHandler.CreateReader(data)->GetResponse();
+  CHECK_FALSE(response.IsFault());
+  CHECK(response.GetResult().AsBoolean());
+  CHECK(response.GetId().AsInteger32() == 3);
+
+  data = write(Response(-32601, "Method not found", 4));
+  CHECK(data.substr(0, 10)
+        == std::string("\x03\x03\x04\0\0\0\xa7\x80\xff\xff", 10));
+  response = formatHandler.CreateReader(data)->GetResponse();
+  CHECK(response.GetId().AsInteger32() == 4);
+  CHECK_THROWS_AS(response.ThrowIfFault(), MethodNotFoundFault);
+
+  CHECK_THROWS_AS(
+    formatHandler.CreateReader(std::string("\x00\0", 2))->GetResponse(),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(
+    formatHandler.CreateReader(std::string("\x01\0\0\0", 4))
+    ->GetResponse(),
+    InvalidRequestFault);
+}
+
+TEST_CASE("msgpack response")
+{
+  MsgPackFormatHandler formatHandler;
+  auto write = [&] (const Response& response)
+  {
+    auto writer = formatHandler.CreateWriter();
+    response.Write(*writer);
+    return std::string(writer->GetData(), writer->GetSize());
+  };
+
+  auto data = write(Response(true, 3));
+  CHECK(data == "\x94\x01\x03\xc0\xc3");
+  auto response = formatHandler.CreateReader(data)->GetResponse();
+  CHECK_FALSE(response.IsFault());
+  CHECK(response.GetResult().AsBoolean());
+  CHECK(response.GetId().AsInteger32() == 3);
+
+  data = write(Response(-32601, "Method not found", 4));
+  CHECK(data.substr(0, 4) == "\x94\x01\x04\x82");
+  response = formatHandler.CreateReader(data)->GetResponse();
+  CHECK(response.GetId().AsInteger32() == 4);
+  CHECK_THROWS_AS(response.ThrowIfFault(), MethodNotFoundFault);
+
+  CHECK_THROWS_AS(
+    formatHandler.CreateReader("\x94\x01\x03\xa1x\xc0")->GetResponse(),
+    InvalidRequestFault);
+  CHECK_THROWS_AS(
+    formatHandler.CreateReader(std::string("\x94\x00\x03\xc0\xc0", 5))
+    ->GetResponse(),
+    InvalidRequestFault);
+}
+
+TEST_CASE("response stream")
+{
+  std::unique_ptr<FormatHandler> formatHandler;
+  bool isBatch = false;
+  GIVEN("cbor")
+  {
+    formatHandler.reset(new CborFormatHandler());
+  }
+  GIVEN("compact")
+  {
+    formatHandler.reset(new CompactFormatHandler());
+  }
+  GIVEN("json")
+  {
+    formatHandler.reset(new JsonFormatHandler());
+  }
+  GIVEN("json batch")
+  {
+    formatHandler.reset(new JsonFormatHandler());
+    isBatch = true;
+  }
+  GIVEN("msgpack")
+  {
+    formatHandler.reset(new MsgPackFormatHandler());
+  }
+  GIVEN("xml")
+  {
+    formatHandler.reset(new XmlFormatHandler());
+  }
+
+  auto createResponses = [&]
+  {
+    Value::Struct member;
+    member["a"] = Value(std::vector<int32_t>{1, 2, 3});
+    member["b"] = Value(Value::Array{});
+    member["c"] = Value(Value::Struct{});
+    Value::Array array;
+    array.emplace_back("x");
+    array.emplace_back(std::move(member));
+    array.emplace_back(Value::Array{});
+    array.emplace_back(1.5);
+
+    std::vector<Response> responses;
+    responses.emplace_back(Value(std::move(array)), 1);
+    if (isBatch) {
+      responses.emplace_back(-32601, "Method not found", 2);
+      responses.emplace_back(Value(true), 3);
+    }
+    return responses;
+  };
+
+  auto writer = formatHandler->CreateWriter();
+  if (isBatch) {
+    Response::WriteBatch(createResponses(), *writer);
+  }
+  else {
+    createResponses().front().Write(*writer);
+  }
+  const std::string expected(writer->GetData(), writer->GetSize());
+
+  for (size_t blockSize : {1, 7, 4096}) {
+    CAPTURE(blockSize);
+    ResponseStream stream(formatHandler->CreateWriter(), createResponses(),
+                          isBatch, blockSize);
+
+    stream.Fill();
+    CHECK(stream.IsDone() == (blockSize > expected.size()));
+
+    std::string data;
+    char buffer[5];
+    while (auto size = stream.Read(buffer, sizeof(buffer))) {
+      data.append(buffer, size);
+    }
+    CHECK(stream.IsDone());
+    CHECK(data == expected);
+  }
+}
+
+TEST_CASE("generated response stream")
+{
+  class Counter : public Value::Generator
+  {
+  public:
+    Counter(int32_t count, int32_t& produced)
+      : myCount(count), myProduced(produced) {}
+
+    bool Next(Value& element) override
+    {
+      if (myProduced == myCount) {
+        return false;
+      }
+      element = Value(++myProduced);
+      return true;
+    }
+
+  private:
+    int32_t myCount;
+    int32_t& myProduced;
+  };
+
+  const int32_t count = 1000;
+  Value::Array array;
+  for (int32_t i = 1; i <= count; ++i) {
+    array.emplace_back(i);
+  }
+
+  // MessagePack and the compact format write the size of an array before
+  // its elements, so a generated array is produced in full before any of
+  // it can be read
+  std::unique_ptr<FormatHandler> formatHandler;
+  bool isStreamed = true;
+  GIVEN("cbor")
+  {
+    formatHandler.reset(new CborFormatHandler());
+  }
+  GIVEN("compact")
+  {
+    formatHandler.reset(new CompactFormatHandler());
+    isStreamed = false;
+  }
+  GIVEN("json")
+  {
+    formatHandler.reset(new JsonFormatHandler());
+  }
+  GIVEN("msgpack")
+  {
+    formatHandler.reset(new MsgPackFormatHandler());
+    isStreamed = false;
+  }
+
+  auto writer = formatHandler->CreateWriter();
+  Response(Value(std::move(array)), 1).Write(*writer);
+  const std::string expected(writer->GetData(), writer->GetSize());
+
+  int32_t produced = 0;
+  std::vector<Response> responses;
+  responses.emplace_back(
+    Value(std::unique_ptr<Value::Generator>(new Counter(count, produced))),
+    1);
+  ResponseStream stream(formatHandler->CreateWriter(), std::move(responses),
+                        false, 64);
+
+  stream.Fill();
+  CHECK_FALSE(stream.IsDone());
+  if (isStreamed) {
+    CHECK(produced > 0);
+    CHECK(produced < 100);
+  }
+  else {
+    CHECK(produced == count);
+  }
+
+  std::string data;
+  char buffer[16];
+  while (auto size = stream.Read(buffer, sizeof(buffer))) {
+    data.append(buffer, size);
+  }
+  CHECK(produced == count);
+  CHECK(data == expected);
+}
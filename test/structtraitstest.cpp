@@ -0,0 +1,159 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "structtraits.h"
+
+#include "dispatcher.h"
+#include "jsonformathandler.h"
+#include "xmlformathandler.h"
+
+#include <catch.hpp>
+
+using namespace xsonrpc;
+
+namespace {
+
+struct Point
+{
+  int32_t X;
+  int32_t Y;
+};
+
+struct Shape
+{
+  std::string Name;
+  std::vector<Point> Points;
+  std::vector<double> Weights;
+};
+
+std::string ToJson(const Value& value)
+{
+  auto writer = JsonFormatHandler().CreateWriter();
+  value.Write(*writer);
+  return std::string(writer->GetData(), writer->GetSize());
+}
+
+} // namespace
+
+namespace xsonrpc {
+
+template<>
+struct StructTraits<Point>
+{
+  template<typename Binder, typename T>
+  static void Bind(Binder& binder, T& point)
+  {
+    binder("x", point.X);
+    binder("y", point.Y);
+  }
+};
+
+template<>
+struct StructTraits<Shape>
+{
+  template<typename Binder, typename T>
+  static void Bind(Binder& binder, T& shape)
+  {
+    binder("name", shape.Name);
+    binder("points", shape.Points);
+    binder("weights", shape.Weights);
+  }
+};
+
+} // namespace xsonrpc
+
+TEST_CASE("bound struct value")
+{
+  CHECK(IsBoundStruct<Point>::value);
+  CHECK_FALSE(IsBoundStruct<Value>::value);
+
+  Shape shape{"line", {{1, 2}, {3, 4}}, {0.5}};
+  auto value = ToValue(shape);
+  CHECK(value.IsWritable());
+  CHECK(value.IsStruct());
+
+  const char json[] =
+    "{\"name\":\"line\",\"points\":[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4}],"
+    "\"weights\":[0.5]}";
+  CHECK(ToJson(value) == json);
+
+  Value copy(value);
+  CHECK(copy.IsWritable());
+  CHECK(ToJson(copy) == json);
+
+  // Accessing the contents converts it to a Value::Struct
+  CHECK(value["name"].AsString() == "line");
+  CHECK_FALSE(value.IsWritable());
+  CHECK(value["points"][1]["y"].AsInteger32() == 4);
+  CHECK(value["weights"].IsDoubleArray());
+  CHECK(ToJson(value) == json);
+
+  // The converted contents are kept, and copied along with the value
+  CHECK(&value["name"] == &value["name"]);
+  Value convertedCopy(value);
+  CHECK_FALSE(convertedCopy.IsWritable());
+  CHECK(convertedCopy["points"][0]["x"].AsInteger32() == 1);
+  CHECK(ToJson(convertedCopy) == json);
+
+  auto xml = XmlFormatHandler().CreateWriter();
+  ToValue(Point{5, 6}).Write(*xml);
+  CHECK(std::string(xml->GetData(), xml->GetSize()) ==
+        "<value><struct>"
+        "<member><name>x</name><value><i4>5</i4></value></member>"
+        "<member><name>y</name><value><i4>6</i4></value></member>"
+        "</struct></value>");
+}
+
+TEST_CASE("dispatcher with bound structs")
+{
+  Dispatcher dispatcher;
+  dispatcher.AddMethod(
+    "translate",
+    [] (const Shape& shape, int32_t dx)
+    {
+      Shape result(shape);
+      for (auto& point : result.Points) {
+        point.X += dx;
+      }
+      return result;
+    });
+
+  Value::Struct point;
+  point.emplace("x", 1);
+  point.emplace("y", 2);
+  Value::Array points;
+  points.emplace_back(std::move(point));
+  Value::Struct shape;
+  shape.emplace("name", "dot");
+  shape.emplace("points", std::move(points));
+  shape.emplace("weights", std::vector<double>{});
+
+  Request::Parameters params;
+  params.emplace_back(Value(shape));
+  params.emplace_back(10);
+
+  auto response = dispatcher.Invoke("translate", params, 1);
+  REQUIRE_FALSE(response.IsFault());
+  CHECK(response.GetResult().IsWritable());
+  CHECK(ToJson(response.GetResult()) ==
+        "{\"name\":\"dot\",\"points\":[{\"x\":11,\"y\":2}],\"weights\":[]}");
+
+  shape.erase("name");
+  params[0] = Value(std::move(shape));
+  response = dispatcher.Invoke("translate", params, 1);
+  CHECK(response.IsFault());
+}
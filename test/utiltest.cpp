@@ -15,12 +15,36 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include "../src/textscan.h"
 #include "../src/util.h"
 
+#include <algorithm>
 #include <catch.hpp>
 
+using namespace xsonrpc;
 using namespace xsonrpc::util;
 
+namespace {
+
+std::string Format(int64_t secondsSinceEpoch)
+{
+  char str[ISO_8601_DATE_TIME_MAX_LENGTH];
+  auto end = FormatIso8601DateTime(Value::DateTime(secondsSinceEpoch), str);
+  return std::string(str, end);
+}
+
+bool Parse(const std::string& text, int64_t& secondsSinceEpoch)
+{
+  Value::DateTime dt;
+  if (!ParseIso8601DateTime(text.data(), text.size(), dt)) {
+    return false;
+  }
+  secondsSinceEpoch = dt.GetSecondsSinceEpoch();
+  return true;
+}
+
+} // namespace
+
 TEST_CASE("encode base64")
 {
   CHECK(Base64Encode("") == "");
@@ -61,3 +85,265 @@ TEST_CASE("decode base64")
         "this is a longer string that will make "
         "the result longer than 76 chars");
 }
+
+TEST_CASE("base64 blocks")
+{
+  // Simple encoding to compare with, wrapped after every 76 chars
+  auto reference = [] (const std::string& data)
+  {
+    const char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string chars;
+    for (size_t i = 0; i < data.size(); i += 3) {
+      uint32_t bits = static_cast<uint8_t>(data[i]) << 16;
+      if (i + 1 < data.size()) {
+        bits |= static_cast<uint8_t>(data[i + 1]) << 8;
+      }
+      if (i + 2 < data.size()) {
+        bits |= static_cast<uint8_t>(data[i + 2]);
+      }
+      chars += alphabet[bits >> 18];
+      chars += alphabet[(bits >> 12) & 0x3f];
+      chars += i + 1 < data.size() ? alphabet[(bits >> 6) & 0x3f] : '=';
+      chars += i + 2 < data.size() ? alphabet[bits & 0x3f] : '=';
+    }
+    std::string str;
+    for (size_t i = 0; i < chars.size(); i += 76) {
+      if (i != 0) {
+        str += "\r\n";
+      }
+      str += chars.substr(i, 76);
+    }
+    return str;
+  };
+
+  // Sizes around the blocks and lines, with every byte value
+  std::string data;
+  for (size_t size = 0; size < 300; ++size) {
+    CAPTURE(size);
+    const std::string str = Base64Encode(data);
+    REQUIRE(str == reference(data));
+    CHECK(Base64EncodedSize(size) == str.size());
+    CHECK(Base64Decode(str) == data);
+
+    // Runs of all lengths without line breaks
+    std::string unwrapped = str;
+    unwrapped.erase(std::remove(unwrapped.begin(), unwrapped.end(), '\r'),
+                    unwrapped.end());
+    unwrapped.erase(std::remove(unwrapped.begin(), unwrapped.end(), '\n'),
+                    unwrapped.end());
+    CHECK(Base64Decode(unwrapped) == data);
+
+    std::string inPlace = str;
+    inPlace.resize(Base64Decode(&inPlace[0], inPlace.size(), &inPlace[0]));
+    CHECK(inPlace == data);
+
+    data += static_cast<char>(size * 101);
+  }
+
+  // Characters outside the alphabet, which are skipped, in and between
+  // blocks
+  std::string str = Base64Encode(data);
+  const std::string expected = Base64Decode(str);
+  for (size_t i = 0; i < str.size(); i += 37) {
+    str.insert(i, i % 2 ? " " : "\n\t");
+  }
+  CHECK(Base64Decode(str) == expected);
+}
+
+TEST_CASE("format date time")
+{
+  CHECK(Format(0) == "19700101T00:00:00");
+  CHECK(Format(1427890394) == "20150401T12:13:14");
+  CHECK(Format(951782400) == "20000229T00:00:00");
+  CHECK(Format(-1) == "19691231T23:59:59");
+  CHECK(Format(-62167219200) == "00000101T00:00:00");
+  CHECK(Format(253402300799) == "99991231T23:59:59");
+  CHECK(Format(253402300800) == "100000101T00:00:00");
+  CHECK(Format(-62167219201) == "-00011231T23:59:59");
+}
+
+TEST_CASE("parse date time")
+{
+  int64_t seconds = 0;
+  CHECK(Parse("19700101T00:00:00", seconds));
+  CHECK(seconds == 0);
+  CHECK(Parse("20150401T12:13:14", seconds));
+  CHECK(seconds == 1427890394);
+  CHECK(Parse("20000229T00:00:00", seconds));
+  CHECK(seconds == 951782400);
+  CHECK(Parse("19691231T23:59:59", seconds));
+  CHECK(seconds == -1);
+  CHECK(Parse("00000101T00:00:00", seconds));
+  CHECK(seconds == -62167219200);
+
+  CHECK_FALSE(Parse("", seconds));
+  CHECK_FALSE(Parse("20150401T12:13:1", seconds));
+  CHECK_FALSE(Parse("20150401T12:13:145", seconds));
+  CHECK_FALSE(Parse("20150401 12:13:14", seconds));
+  CHECK_FALSE(Parse("20150401T12-13:14", seconds));
+  CHECK_FALSE(Parse("2015040AT12:13:14", seconds));
+  CHECK_FALSE(Parse("20150001T12:13:14", seconds));
+  CHECK_FALSE(Parse("20151301T12:13:14", seconds));
+  CHECK_FALSE(Parse("20150400T12:13:14", seconds));
+  CHECK_FALSE(Parse("20150431T12:13:14", seconds));
+  CHECK_FALSE(Parse("19000229T12:13:14", seconds));
+  CHECK_FALSE(Parse("20150401T24:13:14", seconds));
+  CHECK_FALSE(Parse("20150401T12:60:14", seconds));
+  CHECK_FALSE(Parse("20150401T12:13:60", seconds));
+}
+
+TEST_CASE("parse integer")
+{
+  int32_t i32;
+  CHECK(ParseInteger("123", 3, i32));
+  CHECK(i32 == 123);
+  CHECK(ParseInteger(" -42\n", 5, i32));
+  CHECK(i32 == -42);
+  CHECK(ParseInteger("+7", 2, i32));
+  CHECK(i32 == 7);
+  CHECK(ParseInteger("2147483647", 10, i32));
+  CHECK(i32 == 2147483647);
+  CHECK(ParseInteger("-2147483648", 11, i32));
+  CHECK(i32 == -2147483647 - 1);
+  CHECK_FALSE(ParseInteger("2147483648", 10, i32));
+  CHECK_FALSE(ParseInteger("-2147483649", 11, i32));
+  CHECK_FALSE(ParseInteger("", 0, i32));
+  CHECK_FALSE(ParseInteger("-", 1, i32));
+  CHECK_FALSE(ParseInteger("1 2", 3, i32));
+  CHECK_FALSE(ParseInteger("12a", 3, i32));
+  CHECK_FALSE(ParseInteger("1.0", 3, i32));
+
+  int64_t i64;
+  CHECK(ParseInteger("-9223372036854775808", 20, i64));
+  CHECK(i64 == INT64_MIN);
+  CHECK(ParseInteger("9223372036854775807", 19, i64));
+  CHECK(i64 == INT64_MAX);
+  CHECK_FALSE(ParseInteger("9223372036854775808", 19, i64));
+  CHECK_FALSE(ParseInteger("99999999999999999999", 20, i64));
+}
+
+TEST_CASE("parse double")
+{
+  auto parse = [] (const std::string& text, double& value) {
+    return ParseDouble(text.data(), text.size(), value);
+  };
+
+  double d;
+  CHECK(parse("1.5", d));
+  CHECK(d == 1.5);
+  CHECK(parse(" -2 ", d));
+  CHECK(d == -2);
+  CHECK(parse("0.1", d));
+  CHECK(d == 0.1);
+  CHECK(parse(".25", d));
+  CHECK(d == 0.25);
+  CHECK(parse("3.", d));
+  CHECK(d == 3);
+  CHECK(parse("1e3", d));
+  CHECK(d == 1000);
+  CHECK(parse("-1.5E-2", d));
+  CHECK(d == -0.015);
+  CHECK(parse("0.000000000000000000000000001", d));
+  CHECK(d == 1e-27);
+  CHECK(parse("123456789012345678901234567890", d));
+  CHECK(d == 123456789012345678901234567890.0);
+  CHECK(parse("1.7976931348623157e308", d));
+  CHECK(d == 1.7976931348623157e308);
+
+  CHECK_FALSE(parse("", d));
+  CHECK_FALSE(parse(".", d));
+  CHECK_FALSE(parse("-", d));
+  CHECK_FALSE(parse("1e", d));
+  CHECK_FALSE(parse("1e 2", d));
+  CHECK_FALSE(parse("1.2.3", d));
+  CHECK_FALSE(parse("nan", d));
+  CHECK_FALSE(parse("inf", d));
+  CHECK_FALSE(parse("0x10", d));
+  CHECK_FALSE(parse("1e999", d));
+}
+
+TEST_CASE("parse boolean")
+{
+  bool b;
+  CHECK(ParseBoolean("1", 1, b));
+  CHECK(b);
+  CHECK(ParseBoolean(" 0 ", 3, b));
+  CHECK_FALSE(b);
+  CHECK(ParseBoolean("true", 4, b));
+  CHECK(b);
+  CHECK(ParseBoolean("false", 5, b));
+  CHECK_FALSE(b);
+  CHECK_FALSE(ParseBoolean("", 0, b));
+  CHECK_FALSE(ParseBoolean("2", 1, b));
+  CHECK_FALSE(ParseBoolean("yes", 3, b));
+}
+
+TEST_CASE("find escape")
+{
+  // Every position in strings of all lengths up to beyond two vectors
+  for (size_t size = 0; size < 80; ++size) {
+    CAPTURE(size);
+    std::string text(size, 'x');
+    CHECK(FindJsonEscape(text.data(), text.size()) == size);
+    CHECK(FindXmlEscape(text.data(), text.size()) == size);
+
+    for (size_t i = 0; i < size; ++i) {
+      CAPTURE(i);
+      for (char c : {'"', '\\', '\0', '\x1f'}) {
+        text[i] = c;
+        CHECK(FindJsonEscape(text.data(), text.size()) == i);
+      }
+      for (char c : {'&', '<', '>', '\0'}) {
+        text[i] = c;
+        CHECK(FindXmlEscape(text.data(), text.size()) == i);
+      }
+      text[i] = 'x';
+    }
+  }
+
+  // Bytes with the high bit set are not control characters
+  const std::string text(40, '\xe5');
+  CHECK(FindJsonEscape(text.data(), text.size()) == text.size());
+  CHECK(FindXmlEscape(text.data(), text.size()) == text.size());
+}
+
+TEST_CASE("validate utf-8")
+{
+  auto isValid = [] (const std::string& text)
+  {
+    // At the start, end and in the middle of vectors
+    for (size_t offset : {0, 15, 31, 40}) {
+      const std::string padded = std::string(offset, 'a') + text;
+      if (IsValidUtf8(padded.data(), padded.size()) !=
+          IsValidUtf8(text.data(), text.size())) {
+        return false;
+      }
+    }
+    return IsValidUtf8(text.data(), text.size());
+  };
+
+  CHECK(isValid(""));
+  CHECK(isValid("ascii"));
+  CHECK(isValid(std::string("\0", 1)));
+  CHECK(isValid("\xc3\xa5\xc3\xa4\xc3\xb6"));
+  CHECK(isValid("\xe2\x82\xac"));
+  CHECK(isValid("\xed\x9f\xbf"));
+  CHECK(isValid("\xf0\x9f\x98\x80"));
+  CHECK(isValid("\xf4\x8f\xbf\xbf"));
+
+  // Truncated and stray continuation bytes
+  CHECK_FALSE(isValid("\xc3"));
+  CHECK_FALSE(isValid("\xe2\x82"));
+  CHECK_FALSE(isValid("\x80"));
+  CHECK_FALSE(isValid("\xc3\xa5\xa5"));
+  // Overlong forms
+  CHECK_FALSE(isValid("\xc0\x80"));
+  CHECK_FALSE(isValid("\xe0\x80\x80"));
+  CHECK_FALSE(isValid("\xf0\x80\x80\x80"));
+  // Surrogates and beyond U+10FFFF
+  CHECK_FALSE(isValid("\xed\xa0\x80"));
+  CHECK_FALSE(isValid("\xf4\x90\x80\x80"));
+  CHECK_FALSE(isValid("\xf5\x80\x80\x80"));
+  CHECK_FALSE(isValid("\xff"));
+}
@@ -17,14 +17,26 @@
 
 #include "value.h"
 
+#include "cborformathandler.h"
+#include "compactformathandler.h"
 #include "fault.h"
 #include "jsonformathandler.h"
+#include "msgpackformathandler.h"
+#include "valuehandler.h"
+#include "writer.h"
 #include "xmlformathandler.h"
+#include "../src/jsonreader.h"
 #include "../src/reader.h"
-#include "../src/writer.h"
 
+#include <atomic>
 #include <catch.hpp>
+#include <limits>
 #include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 using namespace xsonrpc;
 
@@ -43,6 +55,51 @@ std::unique_ptr<Value> FromJson(const char* json)
   return std::unique_ptr<Value>{new Value(reader->GetValue())};
 }
 
+template<size_t N>
+std::string Bytes(const char (&data)[N])
+{
+  return std::string(data, N - 1);
+}
+
+std::string ToCbor(const Value& value)
+{
+  auto writer = CborFormatHandler().CreateWriter();
+  value.Write(*writer);
+  return std::string(writer->GetData(), writer->GetSize());
+}
+
+std::unique_ptr<Value> FromCbor(std::string data)
+{
+  auto reader = CborFormatHandler().CreateReader(std::move(data));
+  return std::unique_ptr<Value>{new Value(reader->GetValue())};
+}
+
+std::string ToCompact(const Value& value)
+{
+  auto writer = CompactFormatHandler().CreateWriter();
+  value.Write(*writer);
+  return std::string(writer->GetData(), writer->GetSize());
+}
+
+std::unique_ptr<Value> FromCompact(std::string data)
+{
+  auto reader = CompactFormatHandler().CreateReader(std::move(data));
+  return std::unique_ptr<Value>{new Value(reader->GetValue())};
+}
+
+std::string ToMsgPack(const Value& value)
+{
+  auto writer = MsgPackFormatHandler().CreateWriter();
+  value.Write(*writer);
+  return std::string(writer->GetData(), writer->GetSize());
+}
+
+std::unique_ptr<Value> FromMsgPack(std::string data)
+{
+  auto reader = MsgPackFormatHandler().CreateReader(std::move(data));
+  return std::unique_ptr<Value>{new Value(reader->GetValue())};
+}
+
 std::string ToXml(const Value& value)
 {
   auto writer = XmlFormatHandler().CreateWriter();
@@ -174,6 +231,114 @@ TEST_CASE("array")
         "</data></array></value>");
 }
 
+TEST_CASE("packed array")
+{
+  std::unique_ptr<Value> value;
+
+  GIVEN("from constructor")
+  {
+    value = std::unique_ptr<Value>{new Value(std::vector<double>{1.5, -2})};
+  }
+
+  GIVEN("from json")
+  {
+    value = FromJson("[1.5, -2.0]");
+  }
+
+  GIVEN("from copy")
+  {
+    Value other(std::vector<double>{1.5, -2});
+    value = std::unique_ptr<Value>{new Value(other)};
+  }
+
+  CHECK(value->IsArray());
+  CHECK(value->IsDoubleArray());
+  CHECK_FALSE(value->IsInteger32Array());
+  CHECK_FALSE(value->IsInteger64Array());
+
+  CHECK(value->AsDoubleArray() == (std::vector<double>{1.5, -2}));
+  CHECK_THROWS_AS(value->AsInteger32Array(), InvalidParametersFault);
+  CHECK_THROWS_AS(value->AsInteger64Array(), InvalidParametersFault);
+
+  REQUIRE(value->AsArray().size() == 2);
+  CHECK((*value)[0].AsDouble() == 1.5);
+  CHECK((*value)[1].AsDouble() == -2);
+
+  CHECK(ToJson(*value) == "[1.5,-2.0]");
+  CHECK(ToXml(*value) ==
+        "<value><array><data>"
+        "<value><double>1.5</double></value>"
+        "<value><double>-2</double></value>"
+        "</data></array></value>");
+}
+
+TEST_CASE("packed array from json")
+{
+  auto value = FromJson("[1, -2]");
+  CHECK(value->IsInteger32Array());
+  CHECK(value->AsInteger32Array() == (std::vector<int32_t>{1, -2}));
+  CHECK((*value)[1].IsInteger32());
+
+  value = FromJson("[1, 4294967296]");
+  CHECK_FALSE(value->IsInteger64Array());
+  CHECK(value->IsArray());
+  CHECK((*value)[0].IsInteger32());
+  CHECK((*value)[1].IsInteger64());
+
+  value = FromJson("[4294967296, -4294967296]");
+  CHECK(value->IsInteger64Array());
+  CHECK(ToJson(*value) == "[4294967296,-4294967296]");
+
+  value = FromJson("[1, 2.5]");
+  CHECK_FALSE(value->IsDoubleArray());
+  CHECK((*value)[0].IsInteger32());
+
+  value = FromJson("[]");
+  CHECK(value->IsArray());
+  CHECK_FALSE(value->IsInteger32Array());
+}
+
+TEST_CASE("packed array from value builder")
+{
+  ValueBuilder builder;
+  builder.StartStruct();
+  builder.StartStructElement("a", 1);
+  builder.StartArray();
+  builder.Double(0.5);
+  builder.Double(-1);
+  builder.EndArray();
+  builder.StartStructElement("b", 1);
+  builder.StartArray();
+  builder.Integer32(1);
+  builder.Integer64(2);
+  builder.Integer32(3);
+  builder.StartArray();
+  builder.Integer64(4);
+  builder.EndArray();
+  builder.EndArray();
+  builder.StartStructElement("c", 1);
+  builder.StartArray();
+  builder.String("x", 1);
+  builder.Integer32(5);
+  builder.Integer32(6);
+  builder.EndArray();
+  builder.EndStruct();
+  auto& value = builder.GetValue();
+
+  CHECK(value["a"].AsDoubleArray() == (std::vector<double>{0.5, -1}));
+
+  // Boxed at the first element of another type, in order
+  CHECK_FALSE(value["b"].IsInteger32Array());
+  REQUIRE(value["b"].AsArray().size() == 4);
+  CHECK(value["b"][0].IsInteger32());
+  CHECK(value["b"][1].IsInteger64());
+  CHECK(value["b"][2].AsInteger32() == 3);
+  CHECK(value["b"][3].AsInteger64Array() == (std::vector<int64_t>{4}));
+
+  CHECK_FALSE(value["c"].IsInteger32Array());
+  CHECK(ToJson(value["c"]) == R"(["x",5,6])");
+}
+
 TEST_CASE("binary")
 {
   std::unique_ptr<Value> value;
@@ -322,14 +487,18 @@ TEST_CASE("date time")
   CHECK_THROWS_AS((*value)[0], InvalidParametersFault);
   CHECK_THROWS_AS((*value)["notthere"], InvalidParametersFault);
 
-  auto dt = value->AsDateTime();
+  auto dt = value->AsDateTime().ToTm();
   CHECK(dt.tm_year == 2015 - 1900);
   CHECK(dt.tm_mon == 4 - 1);
   CHECK(dt.tm_mday == 1);
   CHECK(dt.tm_hour == 12);
   CHECK(dt.tm_min == 13);
   CHECK(dt.tm_sec == 14);
+  CHECK(dt.tm_wday == 3);
+  CHECK(dt.tm_yday == 90);
   CHECK(dt.tm_isdst == -1);
+  CHECK(Value::DateTime(dt) == value->AsDateTime());
+  CHECK(Value::DateTime().GetSecondsSinceEpoch() == 0);
 
   CHECK(ToJson(*value) == "\"20150401T12:13:14\"");
   CHECK(ToXml(*value) ==
@@ -628,3 +797,497 @@ TEST_CASE("struct")
         "<value><i4>-34</i4></value></member>"
         "</struct></value>");
 }
+
+TEST_CASE("string reference")
+{
+  const char data[] = "1 2 3 &amp;";
+  Value value(Value::StringRef{data, sizeof(data) - 1});
+
+  CHECK(value.IsString());
+  CHECK(value.IsStringRef());
+  CHECK(value.AsStringRef().Data == data);
+  CHECK(value.AsStringRef().Size == sizeof(data) - 1);
+
+  CHECK(ToJson(value) == "\"1 2 3 &amp;\"");
+  CHECK(ToXml(value) == "<value><string>1 2 3 &amp;amp;</string></value>");
+
+  // A copy may outlive the referenced data, so it owns its own
+  Value copy(value);
+  CHECK(copy.IsString());
+  CHECK_FALSE(copy.IsStringRef());
+  CHECK(copy.AsString() == "1 2 3 &amp;");
+
+  Value moved(std::move(value));
+  CHECK(moved.IsStringRef());
+  CHECK(moved.AsStringRef().Data == data);
+
+  // Asking for a std::string takes a copy of the data, once
+  const Value& constMoved = moved;
+  CHECK(constMoved.AsString() == "1 2 3 &amp;");
+  CHECK_FALSE(moved.IsStringRef());
+  CHECK(&constMoved.AsString() == &moved.AsString());
+  CHECK(moved.AsStringRef().Data == moved.AsString().data());
+}
+
+TEST_CASE("strings by reference")
+{
+  GIVEN("json")
+  {
+    auto reader = JsonFormatHandler().CreateReader(
+      R"(["a string", "b\u0000r"])");
+    reader->SetStringsByReference(true);
+    Value value = reader->GetValue();
+
+    REQUIRE(value.AsArray().size() == 2);
+    CHECK(value[0].IsString());
+    CHECK(value[0].IsStringRef());
+    CHECK(value[0].AsString() == "a string");
+    CHECK(value[1].IsBinary());
+    CHECK(value[1].IsStringRef());
+    CHECK(value[1].AsBinary() == (Value::String{'b', '\0', 'r'}));
+  }
+
+  GIVEN("xml")
+  {
+    auto reader = XmlFormatHandler().CreateReader(
+      "<value><string>a &lt;string&gt;</string></value>");
+    reader->SetStringsByReference(true);
+    Value value = reader->GetValue();
+
+    CHECK(value.IsString());
+    CHECK(value.IsStringRef());
+    CHECK(value.AsString() == "a <string>");
+  }
+}
+
+TEST_CASE("json type inference")
+{
+  JsonFormatHandler handler;
+  const char json[] = "[\"20150401T12:13:14\", \"a\\u0000b\"]";
+
+  auto reader = handler.CreateReader(json);
+  auto value = reader->GetValue();
+  CHECK(value[0].IsDateTime());
+  CHECK(value[1].IsBinary());
+
+  handler.SetTypeInference(false);
+  reader = handler.CreateReader(json);
+  value = reader->GetValue();
+  CHECK(value[0].IsString());
+  CHECK(value[0].AsString() == "20150401T12:13:14");
+  CHECK(value[1].IsString());
+  CHECK(value[1].AsString() == std::string("a\0b", 3));
+}
+
+TEST_CASE("json utf-8 validation")
+{
+  JsonFormatHandler handler;
+  const char json[] = "[\"\xc3\xa5\", \"\xc3\"]";
+
+  auto reader = handler.CreateReader(json);
+  CHECK(reader->GetValue()[1].AsString() == "\xc3");
+
+  handler.SetUtf8Validation(true);
+  reader = handler.CreateReader(json);
+  CHECK_THROWS_AS(reader->GetValue(), ParseErrorFault);
+  reader = handler.CreateReader("[\"\xc3\xa5\"]");
+  CHECK(reader->GetValue()[0].AsString() == "\xc3\xa5");
+}
+
+TEST_CASE("json string escaping")
+{
+  // Every byte, in runs that span several vectors
+  std::string text;
+  for (int c = 0; c < 256; ++c) {
+    text += std::string(c % 40, 'x');
+    text += static_cast<char>(c);
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.String(text.data(), text.size());
+  const std::string json = ToJson(Value(text));
+  CHECK(json == buffer.GetString());
+
+  JsonFormatHandler handler;
+  handler.SetTypeInference(false);
+  CHECK(handler.CreateReader(json)->GetValue().AsString() == text);
+}
+
+TEST_CASE("json reader allocator pool")
+{
+  auto pool = std::make_shared<JsonAllocatorPool>();
+  const size_t initialCapacity = pool->GetCapacity();
+
+  std::string json = "[";
+  for (int i = 0; i < 1000; ++i) {
+    json += "{\"a\": [true, null], \"b\": \"c\"},";
+  }
+  json.back() = ']';
+
+  {
+    JsonReader reader(json, true, false, pool);
+    CHECK(reader.GetValue().AsArray().size() == 1000);
+  }
+  const size_t capacity = pool->GetCapacity();
+  CHECK(capacity > initialCapacity);
+
+  for (int i = 0; i < 3; ++i) {
+    JsonReader reader(json, true, false, pool);
+    CHECK(reader.GetValue().AsArray().size() == 1000);
+  }
+  CHECK(pool->GetCapacity() == capacity);
+
+  // Values do not reference the allocator of the reader
+  Value value;
+  {
+    JsonReader reader(R"(["foo", {"bar": 1}])", true, false, pool);
+    value = reader.GetValue();
+  }
+  CHECK(value[0].AsString() == "foo");
+  CHECK(value[1]["bar"].AsInteger32() == 1);
+}
+
+TEST_CASE("json reader allocator pool shared by threads")
+{
+  JsonFormatHandler handler;
+  std::string json = "[";
+  for (int i = 0; i < 100; ++i) {
+    json += "{\"a\": [true, null], \"b\": \"c\"},";
+  }
+  json.back() = ']';
+
+  // Catch isn't thread safe, so the threads only count the failures
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back(
+      [&]
+      {
+        for (int j = 0; j < 200; ++j) {
+          auto value = handler.CreateReader(json)->GetValue();
+          if (value.AsArray().size() != 100
+              || value[99]["b"].AsString() != "c") {
+            ++failures;
+          }
+        }
+      });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK(failures == 0);
+}
+
+TEST_CASE("invalid xml numbers")
+{
+  CHECK_THROWS_AS(FromXml("<i4>2147483648</i4>"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromXml("<int>1.5</int>"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromXml("<i8>9223372036854775808</i8>"),
+                  InvalidRequestFault);
+  CHECK_THROWS_AS(FromXml("<i8>x</i8>"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromXml("<double>1e999</double>"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromXml("<boolean>2</boolean>"), InvalidRequestFault);
+
+  CHECK(FromXml("<i8> -9223372036854775808 </i8>")->AsInteger64()
+        == INT64_MIN);
+}
+
+TEST_CASE("xml text and numbers")
+{
+  CHECK(ToXml(Value("<a & b>")) ==
+        "<value><string>&lt;a &amp; b&gt;</string></value>");
+  CHECK(ToXml(Value("\"'")) == "<value><string>\"'</string></value>");
+  CHECK(ToXml(Value("")) == "<value><string></string></value>");
+  CHECK(ToXml(Value(std::string("a\0b", 3))) ==
+        "<value><string>a</string></value>");
+
+  CHECK(ToXml(Value(0.1)) == "<value><double>0.1</double></value>");
+  CHECK(ToXml(Value(-0.0)) == "<value><double>-0</double></value>");
+  CHECK(ToXml(Value(1e300)) == "<value><double>1e300</double></value>");
+  CHECK(FromXml("<double>0.1</double>")->AsDouble() == 0.1);
+
+  // Doubles are written with full precision
+  typedef std::numeric_limits<double> Limits;
+  for (double d : {0.1 + 0.2, 1.0 / 3, Limits::max(), Limits::min(),
+                   Limits::denorm_min()}) {
+    CHECK(Value(Value::Format::XML, ToXml(Value(d))).AsDouble() == d);
+  }
+  CHECK_THROWS_AS(ToXml(Value(Limits::infinity())), std::invalid_argument);
+  CHECK_THROWS_AS(ToXml(Value(Limits::quiet_NaN())),
+                  std::invalid_argument);
+
+  CHECK(ToXml(Value(INT32_MIN)) ==
+        "<value><i4>-2147483648</i4></value>");
+  CHECK(ToXml(Value(INT64_MIN)) ==
+        "<value><i8>-9223372036854775808</i8></value>");
+
+  Value::Struct empty;
+  empty["a"] = Value(Value::Array{});
+  CHECK(ToXml(Value(std::move(empty))) ==
+        "<value><struct><member><name>a</name>"
+        "<value><array><data/></array></value>"
+        "</member></struct></value>");
+  CHECK(ToXml(Value(Value::Struct{})) == "<value><struct/></value>");
+}
+
+TEST_CASE("raw value")
+{
+  Value json(Value::Format::JSON, R"({"a": [1, "x"]})");
+  CHECK(json.IsStruct());
+  CHECK(ToJson(json) == R"({"a": [1, "x"]})");
+  CHECK(ToXml(json) ==
+        "<value><struct><member><name>a</name>"
+        "<value><array><data>"
+        "<value><i4>1</i4></value><value><string>x</string></value>"
+        "</data></array></value>"
+        "</member></struct></value>");
+
+  Value::Array array;
+  array.emplace_back(Value::Format::XML, "<value><i8>5</i8></value>");
+  array.emplace_back(Value::Format::JSON, " 1.5 ");
+  array.emplace_back(Value(json));
+  Value value(std::move(array));
+  CHECK(value[0].IsInteger64());
+  CHECK(value[1].IsDouble());
+  CHECK(ToJson(value) == R"([5, 1.5 ,{"a": [1, "x"]}])");
+  CHECK(ToXml(value[0]) == "<value><i8>5</i8></value>");
+
+  CHECK(Value(Value::Format::JSON, "7").IsInteger32());
+  CHECK(Value(Value::Format::JSON, "null").IsNil());
+  CHECK(Value(Value::Format::XML, "<value>text</value>").IsString());
+  CHECK(Value(Value::Format::XML, "<value/>").IsString());
+  CHECK(Value(Value::Format::XML, "<value> <nil/> </value>").IsNil());
+  CHECK(Value(Value::Format::XML,
+              "<value><dateTime.iso8601>19980717T14:08:55"
+              "</dateTime.iso8601></value>").IsDateTime());
+  CHECK_THROWS_AS(Value(Value::Format::XML, "<string/>"),
+                  std::invalid_argument);
+
+  // Accessing the contents parses the value
+  CHECK(json["a"][1].AsString() == "x");
+  CHECK_FALSE(json.IsWritable());
+  CHECK(ToJson(json) == R"({"a":[1,"x"]})");
+
+  // Scalars are parsed as well, with the type given by the raw data
+  CHECK(Value(Value::Format::JSON, "42").AsInteger32() == 42);
+  CHECK(Value(Value::Format::JSON, "1.5").AsDouble() == 1.5);
+  CHECK(Value(Value::Format::JSON, "true").AsBoolean());
+  CHECK(Value(Value::Format::XML, "<value><i8>5</i8></value>")
+        .AsInteger64() == 5);
+  Value date(Value::Format::JSON, R"("19980717T14:08:55")");
+  CHECK(date.IsString());
+  CHECK(date.AsString() == "19980717T14:08:55");
+  CHECK(date.IsString());
+  std::ostringstream os;
+  os << Value(Value::Format::JSON, "7");
+  CHECK(os.str() == "7");
+}
+
+TEST_CASE("xml base64 round trip")
+{
+  std::string binary;
+  for (int i = 0; i < 10000; ++i) {
+    binary += static_cast<char>(i * 7);
+  }
+  const std::string xml = ToXml(Value(binary, true));
+
+  for (bool byReference : {false, true}) {
+    CAPTURE(byReference);
+    auto reader = XmlFormatHandler().CreateReader(xml);
+    reader->SetStringsByReference(byReference);
+    auto value = reader->GetValue();
+    CHECK(value.IsStringRef() == byReference);
+    CHECK(value.AsBinary() == binary);
+  }
+}
+
+TEST_CASE("msgpack values")
+{
+  CHECK(ToMsgPack(Value()) == "\xc0");
+  CHECK(ToMsgPack(true) == "\xc3");
+  CHECK(ToMsgPack(false) == "\xc2");
+  CHECK(ToMsgPack(5) == "\x05");
+  CHECK(ToMsgPack(-1) == "\xff");
+  CHECK(ToMsgPack(200) == "\xcc\xc8");
+  CHECK(ToMsgPack(70000) == Bytes("\xce\x00\x01\x11\x70"));
+  CHECK(ToMsgPack(-200) == "\xd1\xff\x38");
+  CHECK(ToMsgPack(int64_t(5)) == Bytes("\xd3\0\0\0\0\0\0\0\x05"));
+  CHECK(ToMsgPack(1.5) == Bytes("\xcb\x3f\xf8\0\0\0\0\0\0"));
+  CHECK(ToMsgPack("abc") == "\xa3" "abc");
+  CHECK(ToMsgPack(Value(Bytes("\0\1"), true)) == Bytes("\xc4\x02\0\1"));
+  CHECK(ToMsgPack(Value::Array{1, "a"}) == "\x92\x01\xa1" "a");
+  CHECK(ToMsgPack(Value::Struct{{"a", 1}}) == "\x81\xa1" "a\x01");
+  CHECK(ToMsgPack(Value::DateTime(1)) == Bytes("\xd6\xff\0\0\0\x01"));
+  CHECK(ToMsgPack(Value::DateTime(-1)) ==
+        Bytes("\xc7\x0c\xff\0\0\0\0\xff\xff\xff\xff\xff\xff\xff\xff"));
+  CHECK(ToMsgPack(Value::Array(16)) ==
+        Bytes("\xdc\0\x10") + std::string(16, '\xc0'));
+  CHECK(ToMsgPack(std::vector<int32_t>{1, 2}) == "\x92\x01\x02");
+
+  // Round trip of nested containers and every type
+  Value::Struct members;
+  members["binary"] = Value(std::string(300, '\0'), true);
+  members["date"] = Value::DateTime(1500000000);
+  members["double"] = -0.25;
+  members["i32"] = std::numeric_limits<int32_t>::min();
+  members["i64"] = std::numeric_limits<int64_t>::max();
+  members["nil"] = Value();
+  members["string"] = std::string(70000, 'x');
+  members["array"] = Value::Array{Value::Array{}, Value::Struct{}, true};
+  Value value(std::move(members));
+  auto read = FromMsgPack(ToMsgPack(value));
+  CHECK(ToJson(*read) == ToJson(value));
+  CHECK((*read)["binary"].IsBinary());
+  CHECK((*read)["date"].IsDateTime());
+  CHECK((*read)["i64"].IsInteger64());
+  CHECK((*read)["i32"].AsInteger32() == std::numeric_limits<int32_t>::min());
+
+  // Formats the writer doesn't use
+  CHECK(FromMsgPack(Bytes("\xca\x3f\xc0\0\0"))->AsDouble() == 1.5);
+  CHECK(FromMsgPack("\xce\xff\xff\xff\xff")->AsInteger64() == 0xffffffff);
+  CHECK(FromMsgPack("\xcf\xff\xff\xff\xff\xff\xff\xff\xff")->IsDouble());
+  CHECK(FromMsgPack(Bytes("\xd7\xff\0\0\0\x04\0\0\0\x02"))->AsDateTime()
+        == Value::DateTime(2));
+  CHECK(FromMsgPack("\xd9\x01x")->AsString() == "x");
+
+  CHECK_THROWS_AS(FromMsgPack(""), ParseErrorFault);
+  CHECK_THROWS_AS(FromMsgPack("\xa3" "ab"), ParseErrorFault);
+  CHECK_THROWS_AS(FromMsgPack("\xdd\xff\xff\xff\xff"), ParseErrorFault);
+  CHECK_THROWS_AS(FromMsgPack("\xc1"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromMsgPack("\x81\x01\x01"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromMsgPack(Bytes("\xd4\x01\x00")), InvalidRequestFault);
+  CHECK_THROWS_AS(FromMsgPack("\xc0\xc0"), InvalidRequestFault);
+}
+
+TEST_CASE("cbor values")
+{
+  CHECK(ToCbor(Value()) == "\xf6");
+  CHECK(ToCbor(true) == "\xf5");
+  CHECK(ToCbor(false) == "\xf4");
+  CHECK(ToCbor(5) == "\x05");
+  CHECK(ToCbor(-1) == "\x20");
+  CHECK(ToCbor(200) == "\x18\xc8");
+  CHECK(ToCbor(70000) == Bytes("\x1a\x00\x01\x11\x70"));
+  CHECK(ToCbor(-200) == "\x38\xc7");
+  CHECK(ToCbor(int64_t(5)) == Bytes("\x1b\0\0\0\0\0\0\0\x05"));
+  CHECK(ToCbor(int64_t(-6)) == Bytes("\x3b\0\0\0\0\0\0\0\x05"));
+  CHECK(ToCbor(1.5) == Bytes("\xfb\x3f\xf8\0\0\0\0\0\0"));
+  CHECK(ToCbor("abc") == "\x63" "abc");
+  CHECK(ToCbor(Value(Bytes("\0\1"), true)) == Bytes("\x42\0\1"));
+  CHECK(ToCbor(Value::Array{1, "a"}) == "\x9f\x01\x61" "a\xff");
+  CHECK(ToCbor(Value::Struct{{"a", 1}}) == "\xbf\x61" "a\x01\xff");
+  CHECK(ToCbor(Value::DateTime(1)) == "\xc1\x01");
+  CHECK(ToCbor(Value::DateTime(-1)) == "\xc1\x20");
+  CHECK(ToCbor(std::vector<int32_t>{1, 2}) == "\x82\x01\x02");
+  CHECK(ToCbor(std::vector<int32_t>(24))
+        == "\x98\x18" + std::string(24, '\0'));
+
+  // Containers of definite length are read too
+  CHECK(FromCbor("\x82\x01\x61" "a")->AsArray().size() == 2);
+  CHECK(FromCbor("\xa1\x61" "a\x01")->AsStruct().at("a").AsInteger32() == 1);
+
+  // Round trip of nested containers and every type
+  Value::Struct members;
+  members["binary"] = Value(std::string(300, '\0'), true);
+  members["date"] = Value::DateTime(1500000000);
+  members["double"] = -0.25;
+  members["i32"] = std::numeric_limits<int32_t>::min();
+  members["i64"] = std::numeric_limits<int64_t>::min();
+  members["nil"] = Value();
+  members["string"] = std::string(70000, 'x');
+  members["array"] = Value::Array{Value::Array{}, Value::Struct{}, true};
+  Value value(std::move(members));
+  auto read = FromCbor(ToCbor(value));
+  CHECK(ToJson(*read) == ToJson(value));
+  CHECK((*read)["binary"].IsBinary());
+  CHECK((*read)["date"].IsDateTime());
+  CHECK((*read)["i64"].IsInteger64());
+  CHECK((*read)["i32"].AsInteger32() == std::numeric_limits<int32_t>::min());
+
+  // Encodings the writer doesn't use
+  CHECK(FromCbor(Bytes("\xf9\x3e\x00"))->AsDouble() == 1.5);
+  CHECK(FromCbor(Bytes("\xf9\x00\x01"))->AsDouble() == 5.960464477539063e-8);
+  CHECK(FromCbor(Bytes("\xf9\xfc\x00"))->AsDouble()
+        == -std::numeric_limits<double>::infinity());
+  CHECK(FromCbor(Bytes("\xfa\x3f\xc0\0\0"))->AsDouble() == 1.5);
+  CHECK(FromCbor("\x1a\xff\xff\xff\xff")->AsInteger64() == 0xffffffff);
+  CHECK(FromCbor("\x1b\xff\xff\xff\xff\xff\xff\xff\xff")->IsDouble());
+  CHECK(FromCbor("\xf7")->IsNil());
+  CHECK(FromCbor("\x7f\x61" "a\x61" "b\xff")->AsString() == "ab");
+  CHECK(FromCbor("\x5f\x41" "a\x40\xff")->IsBinary());
+  CHECK(FromCbor("\x9f\x01\x9f\xff\xff")->AsArray().size() == 2);
+  CHECK(FromCbor("\xbf\x61" "a\x01\xff")->AsStruct().size() == 1);
+  CHECK(FromCbor(Bytes("\xc1\xf9\x3e\x00"))->AsDateTime()
+        == Value::DateTime(1));
+  // Other tags are ignored
+  CHECK(FromCbor("\xd8\x20\x61" "x")->AsString() == "x");
+
+  CHECK_THROWS_AS(FromCbor(""), ParseErrorFault);
+  CHECK_THROWS_AS(FromCbor("\x63" "ab"), ParseErrorFault);
+  CHECK_THROWS_AS(FromCbor("\x9a\xff\xff\xff\xff"), ParseErrorFault);
+  CHECK_THROWS_AS(FromCbor("\x9f\x01"), ParseErrorFault);
+  CHECK_THROWS_AS(FromCbor("\xff"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCbor("\x1c"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCbor("\xf8\x20"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCbor("\xa1\x01\x01"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCbor("\x7f\x41" "a\xff"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCbor("\xc1\x61" "x"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCbor("\xf6\xf6"), InvalidRequestFault);
+}
+
+TEST_CASE("compact values")
+{
+  CHECK(ToCompact(Value()) == Bytes("\0"));
+  CHECK(ToCompact(true) == "\x02");
+  CHECK(ToCompact(false) == "\x01");
+  CHECK(ToCompact(-2) == "\x03\xfe\xff\xff\xff");
+  CHECK(ToCompact(int64_t(5)) == Bytes("\x04\x05\0\0\0\0\0\0\0"));
+  CHECK(ToCompact(1.5) == Bytes("\x05\0\0\0\0\0\0\xf8\x3f"));
+  CHECK(ToCompact("ab") == Bytes("\x06\x02\0\0\0" "ab"));
+  CHECK(ToCompact(Value(Bytes("\0\1"), true))
+        == Bytes("\x07\x02\0\0\0\0\1"));
+  CHECK(ToCompact(Value::DateTime(-1))
+        == "\x08\xff\xff\xff\xff\xff\xff\xff\xff");
+  CHECK(ToCompact(Value::Array{true, "a"})
+        == Bytes("\x09\x02\0\0\0\x02\x06\x01\0\0\0" "a"));
+  CHECK(ToCompact(Value::Struct{{"a", true}})
+        == Bytes("\x0a\x01\0\0\0\x01\0\0\0" "a\x02"));
+  CHECK(ToCompact(std::vector<int32_t>{1, 2})
+        == Bytes("\x0b\x02\0\0\0\x01\0\0\0\x02\0\0\0"));
+  CHECK(ToCompact(std::vector<int64_t>{1})
+        == Bytes("\x0c\x01\0\0\0\x01\0\0\0\0\0\0\0"));
+  CHECK(ToCompact(std::vector<double>{1.5})
+        == Bytes("\x0d\x01\0\0\0\0\0\0\0\0\0\xf8\x3f"));
+
+  // Round trip of nested containers and every type
+  Value::Struct members;
+  members["binary"] = Value(std::string(300, '\0'), true);
+  members["date"] = Value::DateTime(1500000000);
+  members["double"] = -0.25;
+  members["doubles"] = std::vector<double>{0.5, -1};
+  members["i32"] = std::numeric_limits<int32_t>::min();
+  members["i64"] = std::numeric_limits<int64_t>::min();
+  members["i64s"] = std::vector<int64_t>{1, 2};
+  members["nil"] = Value();
+  members["string"] = std::string(70000, 'x');
+  members["array"] = Value::Array{Value::Array{}, Value::Struct{}, true};
+  Value value(std::move(members));
+  auto read = FromCompact(ToCompact(value));
+  CHECK(ToJson(*read) == ToJson(value));
+  CHECK((*read)["binary"].IsBinary());
+  CHECK((*read)["date"].IsDateTime());
+  CHECK((*read)["doubles"].IsDoubleArray());
+  CHECK((*read)["i64"].IsInteger64());
+  CHECK((*read)["i64s"].IsInteger64Array());
+
+  CHECK_THROWS_AS(FromCompact(""), ParseErrorFault);
+  CHECK_THROWS_AS(FromCompact("\x03\x01"), ParseErrorFault);
+  CHECK_THROWS_AS(FromCompact(Bytes("\x06\x03\0\0\0" "ab")),
+                  ParseErrorFault);
+  CHECK_THROWS_AS(FromCompact("\x09\xff\xff\xff\xff"), ParseErrorFault);
+  CHECK_THROWS_AS(FromCompact(Bytes("\x0b\x02\0\0\0\x01\0\0\0")),
+                  ParseErrorFault);
+  CHECK_THROWS_AS(FromCompact("\x0e"), InvalidRequestFault);
+  CHECK_THROWS_AS(FromCompact("\x02\x02"), InvalidRequestFault);
+}
@@ -0,0 +1,95 @@
+// This file is part of xsonrpc, an XML/JSON RPC library.
+// Copyright (C) 2015 Erik Johansson <erik@ejohansson.se>
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; either version 2.1 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "../src/xmlparser.h"
+
+#include "fault.h"
+
+#include <catch.hpp>
+#include <string>
+
+using namespace xsonrpc;
+
+namespace {
+
+// Tokens as a string: <tag>, </tag> and [text]
+std::string Parse(std::string xml)
+{
+  XmlParser parser(&xml[0], xml.size());
+  std::string tokens;
+  std::string names;
+  for (;;) {
+    switch (parser.Next()) {
+      case XmlParser::Token::START_TAG:
+        tokens += parser.IsName("a") ? "<a>" : "<b>";
+        break;
+      case XmlParser::Token::END_TAG:
+        tokens += parser.IsName("a") ? "</a>" : "</b>";
+        break;
+      case XmlParser::Token::TEXT:
+        CHECK(parser.GetText()[parser.GetTextSize()] == '\0');
+        tokens += "[" + std::string(parser.GetText(), parser.GetTextSize())
+          + "]";
+        break;
+      case XmlParser::Token::END:
+        return tokens;
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("xml parser elements")
+{
+  CHECK(Parse("<a/>") == "<a></a>");
+  CHECK(Parse("<a></a>") == "<a></a>");
+  CHECK(Parse("<a><b>x</b><b /></a>") == "<a><b>[x]</b><b></b></a>");
+  CHECK(Parse("<a x='1' y=\"/>\"><b/></a >") == "<a><b></b></a>");
+  CHECK(Parse("\xEF\xBB\xBF<?xml version=\"1.0\"?>\n"
+              "<!DOCTYPE a>\n<!-- comment -->\n<a/>\n") == "<a></a>");
+}
+
+TEST_CASE("xml parser text")
+{
+  CHECK(Parse("<a>&lt;&gt;&amp;&quot;&apos;</a>") == "<a>[<>&\"']</a>");
+  CHECK(Parse("<a>&#65;&#x42;&#xe5;&#x20AC;&#x1F600;</a>")
+        == "<a>[AB\xC3\xA5\xE2\x82\xAC\xF0\x9F\x98\x80]</a>");
+  CHECK(Parse("<a>x<![CDATA[<b>&amp;]]>y</a>") == "<a>[x<b>&amp;y]</a>");
+  CHECK(Parse("<a>x<!-- <b/> -->y<?pi?>z</a>") == "<a>[xyz]</a>");
+  CHECK(Parse("<a>x\r\ny\rz</a>") == "<a>[x\ny\nz]</a>");
+  CHECK(Parse("<a>0123456789abcdef&amp;0123456789abcdef</a>")
+        == "<a>[0123456789abcdef&0123456789abcdef]</a>");
+}
+
+TEST_CASE("xml parser errors")
+{
+  CHECK_THROWS_AS(Parse(""), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a>x"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a></b>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a/><a/>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("x<a/>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a>&foo;</a>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a>&#0;</a>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a>&#x110000;</a>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a>&amp</a>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a x=1/>"), ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<!DOCTYPE a [<!ENTITY b 'c'>]><a/>"),
+                  ParseErrorFault);
+  CHECK_THROWS_AS(Parse("<a><!-- x</a>"), ParseErrorFault);
+}
@@ -15,7 +15,9 @@
 // along with this library; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include "cborformathandler.h"
 #include "dispatcher.h"
+#include "jsonformathandler.h"
 #include "xmlrpcsystemmethods.h"
 
 #include <catch.hpp>
@@ -214,3 +216,37 @@ TEST_CASE("multicall spec example")
   CHECK(value[5].AsArray().size() == 1);
   CHECK(value[5][0].AsInteger32() == 8);
 }
+
+TEST_CASE("formats as capabilities")
+{
+  Dispatcher dispatcher;
+  XmlRpcSystemMethods systemMethods(dispatcher, false);
+
+  CborFormatHandler cborFormatHandler;
+  JsonFormatHandler jsonFormatHandler;
+  systemMethods.AddFormat(cborFormatHandler);
+  systemMethods.AddFormat(jsonFormatHandler);
+  CHECK_THROWS_AS(systemMethods.AddFormat(jsonFormatHandler),
+                  std::invalid_argument);
+  systemMethods.RemoveCapability("application/json");
+
+  auto response = dispatcher.Invoke("system.getCapabilities", {}, Value());
+  REQUIRE_FALSE(response.IsFault());
+  auto& capabilities = response.GetResult().AsStruct();
+  CHECK(capabilities.count("xmlrpc") == 1);
+  CHECK(capabilities.count("application/json") == 0);
+  REQUIRE(capabilities.count("application/cbor") == 1);
+  auto& cbor = capabilities.at("application/cbor");
+  CHECK(cbor["specUrl"].AsString()
+        == "https://www.iana.org/assignments/media-types/application/cbor");
+  CHECK(cbor["specVersion"].AsInteger32() == 1);
+
+  // Formats of the server are listed without being added
+  dispatcher.AddFormat("application/msgpack");
+  dispatcher.AddFormat("application/msgpack");
+  CHECK(dispatcher.GetFormats().size() == 1);
+  response = dispatcher.Invoke("system.getCapabilities", {}, Value());
+  CHECK(response.GetResult()["application/msgpack"]["specUrl"].AsString()
+        == "https://www.iana.org/assignments/media-types/"
+        "application/msgpack");
+}